@@ -115,9 +115,49 @@ enum UCS_S_PACKED ucg_group_hierarchy_level {
     UCG_GROUP_HIERARCHY_LEVEL_L3CACHE
 };
 
+/* Reduce operation codes reported by get_operate_param_f */
+typedef enum {
+    UCG_OP_SUM = 0,
+    UCG_OP_PROD,
+    UCG_OP_MIN,
+    UCG_OP_MAX,
+    UCG_OP_BAND,
+    UCG_OP_BOR,
+    UCG_OP_BXOR,
+    UCG_OP_NUMS
+} ucg_operate_type_t;
+
+/* Datatype codes reported by get_operate_param_f */
+typedef enum {
+    UCG_DT_INT8 = 0,
+    UCG_DT_UINT8,
+    UCG_DT_INT16,
+    UCG_DT_UINT16,
+    UCG_DT_INT32,
+    UCG_DT_UINT32,
+    UCG_DT_INT64,
+    UCG_DT_UINT64,
+    UCG_DT_FLOAT,
+    UCG_DT_DOUBLE,
+    UCG_DT_FLOAT16,
+    UCG_DT_BFLOAT16,
+    UCG_DT_NUMS
+} ucg_operate_dtype_t;
+
 typedef int (*dt_convert_f)(void *dt_ext, ucp_datatype_t *ucp_datatype);
 typedef ptrdiff_t (*dt_span_f)(void *dt_ext, int count, ptrdiff_t *gap);
 
+/* Layout of a derived datatype made of equally spaced blocks of a predefined datatype */
+typedef struct ucg_dt_strided {
+    void      *base_dt;      /* predefined datatype of the block elements */
+    unsigned   block_cnt;    /* number of blocks in one datatype element */
+    unsigned   block_len;    /* number of base elements in one block */
+    ptrdiff_t  block_disp;   /* byte displacement of the first block */
+    ptrdiff_t  block_stride; /* byte distance between two blocks */
+} ucg_dt_strided_t;
+
+typedef int (*dt_strided_f)(void *dt_ext, ucg_dt_strided_t *strided);
+
 typedef struct inc_params {
     uint16_t comm_id;             /* INC comm id */
     uint8_t switch_info_got;      /* indicates whether switch supports INC with under the current parameters */
@@ -191,6 +231,12 @@ typedef struct ucg_group_params {
     
     dt_span_f mpi_datatype_span;
 
+    /* Callback function to describe a derived datatype, returns 0 if it is strided */
+    dt_strided_f mpi_datatype_strided;
+
+    /* Callback function to map MPI_OP and datatype to ucg_operate_type_t and
+       ucg_operate_dtype_t, returns 0 if both have a code (user-defined ops do not).
+       Only called with UCX_BUILTIN_NATIVE_REDUCE=y, whose reductions trust the codes */
     int (*get_operate_param_f)(void *mpi_op, void *mpi_dt, int *op, int *dt);
 
     /* INC params */
@@ -226,6 +272,28 @@ typedef struct ucg_collective {
 } ucg_collective_params_t;
 
 
+/*
+ * Latency buckets are logarithmic, four per power of two nanoseconds, see
+ * @ref ucg_collective_metrics_bucket .
+ */
+#define UCG_COLLECTIVE_METRICS_BUCKETS 128
+#define UCG_COLLECTIVE_METRICS_RAILS   4 /* see UCX_BUILTIN_MAX_RAILS */
+
+typedef struct ucg_collective_metrics {
+    coll_type_t coll_type;        /* collective type */
+    int         algo;             /* algorithm number, as in UCX_BUILTIN_<TYPE>_ALGORITHM */
+    unsigned    size_log;         /* message lengths below 2^size_log bytes, and at least half of it */
+    uint64_t    count;            /* completed collectives */
+    uint64_t    errors;           /* those which completed with an error */
+    uint64_t    bytes;            /* local message length, summed over the completed ones */
+    uint64_t    resends;          /* sends retried after UCS_ERR_NO_RESOURCE */
+    uint64_t    unexpected;       /* messages which arrived before their step started */
+    uint64_t    zcopy_promotions; /* bcopy sends turned into zcopy */
+    uint64_t    rail_frags[UCG_COLLECTIVE_METRICS_RAILS]; /* fragments striped onto each rail, 0 is the main one */
+    uint64_t    latency[UCG_COLLECTIVE_METRICS_BUCKETS]; /* completions per latency bucket */
+} ucg_collective_metrics_t;
+
+
 /**
  * @ingroup UCG_GROUP
  * @brief Create a group object.
@@ -336,7 +404,13 @@ ucs_status_t ucg_collective_create(ucg_group_h group,
  *                          is returned to the application in order to track
  *                          progress of the message. The application is
  *                          responsible to release the handle using
- *                          @ref ucg_request_free routine.
+ *                          @ref ucg_request_free routine. The handle may
+ *                          belong to the collective operation: it is only
+ *                          valid until the operation is destroyed, or, if
+ *                          it is not persistent, until the group discards it
+ *                          to make room for other collectives. Use
+ *                          @ref ucg_collective_start_nbr to keep the request
+ *                          beyond that.
  */
 ucs_status_ptr_t ucg_collective_start_nb(ucg_coll_h coll);
 
@@ -360,6 +434,169 @@ ucs_status_ptr_t ucg_collective_start_nb(ucg_coll_h coll);
 ucs_status_t ucg_collective_start_nbr(ucg_coll_h coll, void *req);
 
 
+/**
+ * @ingroup UCG_GROUP
+ * @brief Starts a batch of collective operations.
+ *
+ * This routine is equivalent to @ref ucg_collective_start_nbr on each of the
+ * collectives in turn, but takes the worker's lock once for the whole batch.
+ * The collectives may belong to different groups of the same worker. A
+ * collective which fails to start does not prevent the others from starting,
+ * and the outcome of each one is written to @a statuses .
+ *
+ * @param [in]  colls       Array of collective operation handles.
+ * @param [in]  requests    Array of request handles allocated by the user, as
+ *                          for @ref ucg_collective_start_nbr, one per handle.
+ * @param [in]  count       Number of collectives to start.
+ * @param [out] statuses    Array of @a count entries, each set to what
+ *                          @ref ucg_collective_start_nbr would have returned
+ *                          for the same collective. Only the requests of the
+ *                          UCS_INPROGRESS entries need to be waited for.
+ *
+ * @return UCS_OK           - All the collectives were completed immediately.
+ * @return UCS_INPROGRESS   - None failed, and some are in progress.
+ * @return Error code as defined by @ref ucs_status_t - the first of the
+ *                            failures, see @a statuses for the others. If the
+ *                            arguments are invalid, none was started and
+ *                            @a statuses is not written.
+ */
+ucs_status_t ucg_collective_start_nbr_batch(ucg_coll_h *colls, void **requests, unsigned count,
+                                            ucs_status_t *statuses);
+
+
+/**
+ * @ingroup UCG_GROUP
+ * @brief Starts a batch of collective operations of a group, fusing allreduces.
+ *
+ * This routine is equivalent to @ref ucg_collective_start_nbr_batch on
+ * collectives of a single group, except that consecutive allreduces of a
+ * predefined datatype with the same operation and datatype are packed and run
+ * as a single allreduce, up to 64 of them. Other collectives start on their
+ * own, in order. All the members must pass the same sequence of collectives.
+ * The group keeps each fused allreduce for the next run of the same shape.
+ * The requests of fused allreduces complete on @ref ucg_group_progress , also
+ * when their start failed.
+ *
+ * @param [in]  group       Group of all the collectives.
+ * @param [in]  colls       Array of collective operation handles.
+ * @param [in]  requests    Array of request handles allocated by the user, as
+ *                          for @ref ucg_collective_start_nbr, one per handle.
+ * @param [in]  count       Number of collectives to start.
+ * @param [out] statuses    Array of @a count entries, each set to what
+ *                          @ref ucg_collective_start_nbr would have returned
+ *                          for the same collective, or for the allreduce it
+ *                          was fused into.
+ *
+ * @return As for @ref ucg_collective_start_nbr_batch .
+ */
+ucs_status_t ucg_collective_start_nbr_fused(ucg_group_h group, ucg_coll_h *colls, void **requests,
+                                            unsigned count, ucs_status_t *statuses);
+
+
+/**
+ * @ingroup UCG_GROUP
+ * @brief Create a partitioned collective operation.
+ *
+ * The buffers of an allreduce or a broadcast of a predefined datatype are cut
+ * into @a partitions slices, and each slice is started as soon as it is marked
+ * ready by @ref ucg_collective_partitioned_ready and all the slices before it
+ * were started. The last slice also holds the remainder of the count. Other
+ * collectives started on the group meanwhile, partitioned or not, are delayed
+ * until all the slices are started, so all the members start them in the same
+ * order.
+ *
+ * @param [in]  group       Group of the collective.
+ * @param [in]  params      Collective parameters of the whole buffers.
+ * @param [in]  partitions  Number of partitions, at most the item count.
+ * @param [out] part_p      Partitioned collective handle, reusable after completion.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucg_collective_partitioned_create(ucg_group_h group, const ucg_collective_params_t *params,
+                                               unsigned partitions, ucg_partitioned_h *part_p);
+
+
+/**
+ * @ingroup UCG_GROUP
+ * @brief Start a partitioned collective operation, with no partition ready.
+ *
+ * @param [in]  part        Partitioned collective handle.
+ * @param [in]  request     Request handle allocated by the user, as for
+ *                          @ref ucg_collective_start_nbr . It completes once
+ *                          all the partitions are done.
+ *
+ * @return UCS_INPROGRESS   - The collective was started. Its partitions may be
+ *                            marked ready at once, they start after the
+ *                            collectives started on the group before it.
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucg_collective_partitioned_start(ucg_partitioned_h part, void *request);
+
+
+/**
+ * @ingroup UCG_GROUP
+ * @brief Mark a partition of a started partitioned collective ready.
+ *
+ * The partition buffers must not be changed afterwards until the request of
+ * the partitioned collective completes.
+ *
+ * @param [in]  part        Partitioned collective handle.
+ * @param [in]  partition   Index of the ready partition.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucg_collective_partitioned_ready(ucg_partitioned_h part, unsigned partition);
+
+
+/**
+ * @ingroup UCG_GROUP
+ * @brief Destroy a partitioned collective operation.
+ *
+ * @param [in]  part        Partitioned collective handle.
+ */
+void ucg_collective_partitioned_destroy(ucg_partitioned_h part);
+
+
+/**
+ * @ingroup UCG_GROUP
+ * @brief Query the collective metrics of a group.
+ *
+ * With UCX_BUILTIN_METRICS set, every group keeps a record per collective
+ * type, algorithm and power-of-two message length, with a histogram of the
+ * latencies from the start of the collectives to their completion.
+ *
+ * @param [in]  group       Group object to query.
+ * @param [out] metrics     Array filled with the records of the group.
+ * @param [in]  max         Number of entries in @a metrics .
+ *
+ * @return The number of records of the group, which may be more than @a max .
+ */
+unsigned ucg_group_metrics_query(ucg_group_h group, ucg_collective_metrics_t *metrics, unsigned max);
+
+
+/**
+ * @ingroup UCG_GROUP
+ * @brief Print the collective metrics of a group.
+ *
+ * The metrics are also dumped on the group destruction, and on the signal
+ * set by UCX_BUILTIN_METRICS_SIGNAL, to the files of UCX_BUILTIN_METRICS_FILE
+ * or to the log.
+ *
+ * @param [in]  group       Group object to print.
+ * @param [in]  stream      Output stream.
+ */
+void ucg_group_metrics_print(ucg_group_h group, FILE *stream);
+
+
+/**
+ * @ingroup UCG_GROUP
+ * @brief Lower bound of a latency bucket, in nanoseconds.
+ *
+ * @param [in]  bucket      Bucket index, below @ref UCG_COLLECTIVE_METRICS_BUCKETS .
+ */
+uint64_t ucg_collective_metrics_bucket(unsigned bucket);
+
+
 /**
  * @ingroup UCG_GROUP
  * @brief Destroys a collective operation handle.
@@ -369,6 +606,9 @@ ucs_status_t ucg_collective_start_nbr(ucg_coll_h coll, void *req);
  * @ref ucg_collective_create. Otherwise, the handle is
  * destroyed when the collective operation is completed.
  *
+ * A started collective which is still waiting for an earlier one of its group
+ * is not started anymore, and its request completes with UCS_ERR_CANCELED.
+ *
  * @param [in]  coll         Collective operation handle.
  *
  * @return Error code as defined by @ref ucs_status_t
@@ -391,6 +631,53 @@ void ucg_collective_destroy(ucg_coll_h coll);
 ucs_status_t ucg_request_check_status(void *request);
 
 
+/**
+ * @ingroup UCG_GROUP
+ * @brief Check the status of a batch of non-blocking requests.
+ *
+ * @param [in]  requests    Array of non-blocking requests to check.
+ * @param [in]  count       Number of requests.
+ *
+ * @return UCS_INPROGRESS if any request is in progress, otherwise the first
+ *         error of the requests, or UCS_OK.
+ */
+ucs_status_t ucg_request_check_status_batch(void **requests, unsigned count);
+
+
+/**
+ * @ingroup UCG_GROUP
+ * @brief Wait for a non-blocking request to complete.
+ *
+ * This routine progresses the group until the request completes. After
+ * spinning for UCX_BUILTIN_WAIT_SPIN_TIME, it arms the worker and blocks on
+ * its event file descriptor until a message arrives, if the worker's context
+ * was created with UCP_FEATURE_WAKEUP. Otherwise it keeps progressing, and
+ * yields the CPU between the calls.
+ *
+ * @param [in]  group       Group object of the collective operation.
+ * @param [in]  request     Non-blocking request to wait for.
+ *
+ * @return Completion status of the request, as defined by @ref ucs_status_t
+ */
+ucs_status_t ucg_request_wait(ucg_group_h group, void *request);
+
+
+/**
+ * @ingroup UCG_GROUP
+ * @brief Wait for a batch of non-blocking requests to complete.
+ *
+ * Same as @ref ucg_request_wait , until all the requests are completed.
+ *
+ * @param [in]  group       Group object of the collective operations.
+ * @param [in]  requests    Array of non-blocking requests to wait for.
+ * @param [in]  count       Number of requests.
+ *
+ * @return The status @ref ucg_request_check_status_batch returns once all the
+ *         requests are completed.
+ */
+ucs_status_t ucg_request_wait_batch(ucg_group_h group, void **requests, unsigned count);
+
+
 /**
  * @ingroup UCG_GROUP
  * @brief Cancel an outstanding communications request.
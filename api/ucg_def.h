@@ -37,6 +37,17 @@ typedef struct ucg_group                *ucg_group_h;
 typedef void                            *ucg_coll_h;
 
 
+/**
+ * @ingroup UCG_GROUP
+ * @brief UCG partitioned collective handle.
+ *
+ * A collective operation whose buffers are split into partitions, which the
+ * application marks ready one by one. Each partition is sent as soon as it and
+ * the partitions before it are ready.
+ */
+typedef struct ucg_partitioned          *ucg_partitioned_h;
+
+
 /**
  * @ingroup UCG_GROUP
  * @brief UCG group member index.
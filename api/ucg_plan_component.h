@@ -162,6 +162,12 @@ struct ucg_plan_component {
     void                   (*destroy) (ucg_group_h group);
     /* destroy a group context, along with all its operations and requests */
     unsigned               (*progress)(ucg_group_h group);
+    /* release the worker context, once all the groups are destroyed (optional) */
+    void                   (*worker_cleanup)(ucg_worker_h worker);
+    /* seconds to spin in ucg_request_wait before blocking (optional) */
+    double                 (*wait_spin_time)(ucg_group_h group);
+    /* whether the group has nothing to retry without an event (optional) */
+    int                    (*can_block)(ucg_group_h group);
 
     /* plan a collective operation with this component */
     ucs_status_t           (*plan)    (ucg_group_h group,
@@ -215,20 +221,28 @@ struct ucg_plan_component {
  * @param _prepare       Function to prepare an operation according to a plan.
  * @param _trigger       Function to start a prepared collective operation.
  * @param _destroy       Function to release a plan and all related objects.
+ * @param _worker_cleanup Function to release the worker context, or NULL.
+ * @param _wait_spin_time Function to get the spin time of a wait, or NULL.
+ * @param _can_block     Function to tell if a waiting group may block, or NULL.
  * @param _priv          Custom private data.
  * @param _cfg_prefix    Prefix for configuration environment variables.
  * @param _cfg_table     Defines the planning component's configuration values.
  * @param _cfg_struct    Planning component configuration structure.
  */
 #define UCG_PLAN_COMPONENT_DEFINE(_planc, _name, _sz, _query, _create, _destroy,\
-                                  _progress, _plan, _prepare, _trigger, _discard,\
-                                  _print, _cfg_prefix, _cfg_table, _cfg_struct)\
+                                  _worker_cleanup, _wait_spin_time, _can_block,\
+                                  _progress, _plan, _prepare, _trigger,        \
+                                  _discard, _print, _cfg_prefix, _cfg_table,   \
+                                  _cfg_struct)                                 \
                                                                                \
     ucg_plan_component_t _planc = {                                            \
         .group_context_size = (_sz),                                           \
         .query              = (_query),                                        \
         .create             = (_create),                                       \
         .destroy            = (_destroy),                                      \
+        .worker_cleanup     = (_worker_cleanup),                               \
+        .wait_spin_time     = (_wait_spin_time),                               \
+        .can_block          = (_can_block),                                    \
         .progress           = (_progress),                                     \
         .plan               = (_plan),                                         \
         .prepare            = (_prepare),                                      \
@@ -258,6 +272,11 @@ ucs_status_t ucg_plan_connect(ucg_group_h group, ucg_group_member_index_t index,
                               uct_md_h* md_p, const uct_md_attr_t** md_attr_p, 
                               ucp_ep_h *ucp_ep_p);
 
+/* Helper function for listing the AM bandwidth lanes of a connection, to stripe large messages over */
+ucs_status_t ucg_plan_connect_rails(ucg_group_h group, ucp_ep_h ucp_ep, unsigned max_rails,
+                                    uct_ep_h *eps, uct_md_h *mds, const uct_iface_attr_t **ep_attrs,
+                                    double *bandwidths, unsigned *rail_cnt_p);
+
 /* Helper function for selecting other planners - to be used as fall-back */
 ucs_status_t ucg_plan_select(ucg_group_h group, const char* planner_name,
                              const ucg_collective_params_t *params,
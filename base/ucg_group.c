@@ -3,6 +3,9 @@
  * Description: UCG group
  */
 
+#include <limits.h>
+#include <poll.h>
+#include <sched.h>
 #include <ucg/builtin/plan/builtin_plan.h>
 #include <ucg/builtin/plan/builtin_plan_cache.h>
 #include <ucg/builtin/plan/builtin_algo_decision.h>
@@ -10,15 +13,21 @@
 #include <ucg/api/ucg_mpi.h>
 #include <ucp/core/ucp_ep.inl>
 #include <ucp/core/ucp_worker.h>
+#include <ucs/arch/cpu.h>
 #include <ucs/datastruct/queue.h>
 #include <ucs/datastruct/list.h>
 #include <ucs/profile/profile.h>
 #include <ucs/debug/memtrack.h>
+#include <ucs/time/time.h>
 #include <ucp/core/ucp_ep.inl>
 #include <ucp/core/ucp_proxy_ep.h> /* for @ref ucp_proxy_ep_test */
+#include <ucp/wireup/wireup_ep.h> /* for @ref ucp_wireup_ep_test */
 
 #include "ucg_group.h"
 
+/* a blocked wait progresses at least this often, in case an event is missed */
+#define UCG_GROUP_WAIT_POLL_TIMEOUT_MS 1
+
 #if ENABLE_STATS
 /* UCG group statistics counters */
 enum {
@@ -53,23 +62,36 @@ static ucs_stats_class_t ucg_group_stats_class = {
         }                                            \
         idx++;                                       \
     }                                                \
-    if (idx == (ctx)->iface_cnt) {                   \
+    if ((idx == (ctx)->iface_cnt) &&                 \
+        (idx < UCG_GROUP_MAX_IFACES)) {              \
         (ctx)->ifaces[(ctx)->iface_cnt++] = (iface); \
     }                                                \
 }
 
+/*
+ * Progress takes the worker's lock too: with a thread-multi worker, a planner
+ * may progress the groups from its own thread (see UCX_BUILTIN_ASYNC_PROGRESS).
+ */
 unsigned ucg_worker_progress(ucg_worker_h worker)
 {
     unsigned idx;
     unsigned ret = 0;
     ucg_groups_t *gctx = UCG_WORKER_TO_GROUPS_CTX(worker);
+
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
     for (idx = 0; idx < gctx->iface_cnt; idx++) {
         ret += uct_iface_progress(gctx->ifaces[idx]);
     }
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
     return ret;
 }
 
-unsigned ucg_group_progress(ucg_group_h group)
+static void ucg_group_fusion_progress(ucg_group_h group);
+static void ucg_group_fusion_cleanup(ucg_group_h group);
+static int ucg_group_fusion_is_owned(ucg_group_h group, const ucg_op_t *op);
+static void ucg_group_partitioned_progress(ucg_group_h group);
+
+unsigned ucg_group_progress_locked(ucg_group_h group)
 {
     unsigned idx;
     unsigned ret = 0;
@@ -84,6 +106,25 @@ unsigned ucg_group_progress(ucg_group_h group)
         ret += uct_iface_progress(group->ifaces[idx]);
     }
 
+    if (ucs_unlikely(!ucs_queue_is_empty(&group->fused))) {
+        ucg_group_fusion_progress(group);
+    }
+
+    if (ucs_unlikely(!ucs_list_is_empty(&group->partitioned))) {
+        ucg_group_partitioned_progress(group);
+    }
+
+    return ret;
+}
+
+unsigned ucg_group_progress(ucg_group_h group)
+{
+    ucg_worker_h worker = group->worker;
+    unsigned ret;
+
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+    ret = ucg_group_progress_locked(group);
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
     return ret;
 }
 
@@ -105,6 +146,13 @@ ucs_status_t ucg_init_group(ucg_worker_h worker,
     new_group->iface_cnt              = 0;
 
     ucs_queue_head_init(&new_group->pending);
+    ucs_list_head_init(&new_group->partitioned);
+    new_group->pended_cnt     = 0;
+    new_group->released_cnt   = 0;
+    new_group->parts_starting = 0;
+    ucs_queue_head_init(&new_group->fused);
+    ucs_list_head_init(&new_group->fusion_batches);
+    new_group->fusion_batch_cnt = 0;
     new_group->params = *params;
     new_group->params.node_index = (typeof(params->node_index))((char*)(new_group
             + 1) + ctx->total_planner_sizes + distance_size);
@@ -228,6 +276,28 @@ ucg_group_member_index_t ucg_group_get_member_count(ucg_group_h group)
     return group_params->member_count;
 }
 
+unsigned ucg_group_metrics_query(ucg_group_h group, ucg_collective_metrics_t *metrics, unsigned max)
+{
+    unsigned count;
+
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(group->worker);
+    count = ucg_builtin_group_metrics_query(group, metrics, max);
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(group->worker);
+    return count;
+}
+
+void ucg_group_metrics_print(ucg_group_h group, FILE *stream)
+{
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(group->worker);
+    ucg_builtin_group_metrics_print(group, stream);
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(group->worker);
+}
+
+uint64_t ucg_collective_metrics_bucket(unsigned bucket)
+{
+    return ucg_builtin_metrics_bucket_nsec(ucs_min(bucket, UCG_COLLECTIVE_METRICS_BUCKETS - 1));
+}
+
 void ucg_group_planner_destroy(ucg_group_h group)
 {
     unsigned idx;
@@ -245,7 +315,8 @@ void ucg_group_destroy(ucg_group_h group)
     }
     ucs_info("destroying ucg group %hu", group->group_id);
     /* First - make sure all the collectives are completed */
-    while (!ucs_queue_is_empty(&group->pending)) {
+    while (!ucs_queue_is_empty(&group->pending) || !ucs_queue_is_empty(&group->fused) ||
+           !ucs_list_is_empty(&group->partitioned)) {
         ucg_group_progress(group);
     }
 
@@ -264,6 +335,7 @@ void ucg_group_destroy(ucg_group_h group)
     UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
 #endif
 
+    ucg_group_fusion_cleanup(group);
     ucg_group_planner_destroy(group);
     UCS_STATS_NODE_FREE(group->stats);
     ucs_list_del(&group->list);
@@ -289,6 +361,101 @@ ucs_status_t ucg_request_check_status(void *request)
     return UCS_INPROGRESS;
 }
 
+ucs_status_t ucg_request_check_status_batch(void **requests, unsigned count)
+{
+    ucs_status_t ret = UCS_OK;
+    ucs_status_t status;
+    unsigned idx;
+
+    for (idx = 0; idx < count; idx++) {
+        status = ucg_request_check_status(requests[idx]);
+        if (status == UCS_INPROGRESS) {
+            return UCS_INPROGRESS;
+        }
+        if (ret == UCS_OK) {
+            ret = status;
+        }
+    }
+
+    return ret;
+}
+
+ucs_status_t ucg_request_wait(ucg_group_h group, void *request)
+{
+    return ucg_request_wait_batch(group, &request, 1);
+}
+
+/* the longest spin time asked by the planners, none if they ask nothing */
+static double ucg_group_wait_spin_time(ucg_group_h group)
+{
+    ucg_groups_t *gctx = UCG_WORKER_TO_GROUPS_CTX(group->worker);
+    ucg_plan_component_t *planc;
+    double spin_time = 0;
+    unsigned idx;
+
+    for (idx = 0; idx < gctx->num_planners; idx++) {
+        planc = gctx->planners[idx].plan_component;
+        if (planc->wait_spin_time != NULL) {
+            spin_time = ucs_max(spin_time, planc->wait_spin_time(group));
+        }
+    }
+    return spin_time;
+}
+
+/* a group may block unless one of its planners has something to retry */
+static int ucg_group_can_block(ucg_group_h group)
+{
+    ucg_groups_t *gctx = UCG_WORKER_TO_GROUPS_CTX(group->worker);
+    ucg_plan_component_t *planc;
+    unsigned idx;
+
+    for (idx = 0; idx < gctx->num_planners; idx++) {
+        planc = gctx->planners[idx].plan_component;
+        if ((planc->can_block != NULL) && !planc->can_block(group)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+ucs_status_t ucg_request_wait_batch(ucg_group_h group, void **requests, unsigned count)
+{
+    ucg_worker_h worker = group->worker;
+    int can_block       = worker->context->config.features & UCP_FEATURE_WAKEUP;
+    ucs_time_t spin_end = ucs_get_time() + ucs_time_from_sec(ucg_group_wait_spin_time(group));
+    struct pollfd pfd   = { .fd = -1, .events = POLLIN };
+    ucs_status_t status;
+
+    for (;;) {
+        ucg_group_progress(group);
+        status = ucg_request_check_status_batch(requests, count);
+        if (status != UCS_INPROGRESS) {
+            return status;
+        }
+
+        if (ucs_get_time() < spin_end) {
+            continue;
+        }
+
+        /* sends retried on progress are not woken up by any event */
+        if (can_block && (pfd.fd < 0) && (ucp_worker_get_efd(worker, &pfd.fd) != UCS_OK)) {
+            can_block = 0;
+        }
+        if (!can_block || !ucg_group_can_block(group)) {
+            sched_yield();
+            continue;
+        }
+
+        status = ucp_worker_arm(worker);
+        if (status == UCS_OK) {
+            pfd.revents = 0;
+            (void) poll(&pfd, 1, UCG_GROUP_WAIT_POLL_TIMEOUT_MS);
+        } else if (status != UCS_ERR_BUSY) {
+            sched_yield();
+        }
+    }
+}
+
 void ucg_request_cancel(ucg_worker_h worker, void *request) { }
 
 void ucg_request_free(void *request) { }
@@ -380,17 +547,15 @@ ucs_status_t ucg_collective_check_input(ucg_group_h group,
     return status;
 }
 
-UCS_PROFILE_FUNC(ucs_status_t, ucg_collective_create,
-        (group, params, coll), ucg_group_h group,
-        ucg_collective_params_t *params, ucg_coll_h *coll)
+/* Called with the worker lock held, by ucg_collective_create and the collectives started on its behalf */
+static ucs_status_t ucg_collective_create_locked(ucg_group_h group, ucg_collective_params_t *params,
+                                                 ucg_coll_h *coll)
 {
     ucg_plan_t *plan = NULL;
     ucg_op_t *op = NULL;
     ucs_status_t status;
     int algo;
 
-    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(group->worker);
-
     status = ucg_collective_check_input(group, params, coll);
     if (status != UCS_OK) {
         goto out;
@@ -477,6 +642,17 @@ op_found:
     ucg_log_coll_params(params);
 
 out:
+    return status;
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucg_collective_create,
+        (group, params, coll), ucg_group_h group,
+        ucg_collective_params_t *params, ucg_coll_h *coll)
+{
+    ucs_status_t status;
+
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(group->worker);
+    status = ucg_collective_create_locked(group, params, coll);
     UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(group->worker);
     return status;
 }
@@ -502,58 +678,110 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_collective_trigger(ucg_group_h group
     return ret;
 }
 
-ucs_status_t ucg_collective_release_barrier(ucg_group_h group)
+static int ucg_partitioned_start_ready(ucg_partitioned_h part);
+
+/* first partitioned collective of the group not fully started, if any */
+static ucg_partitioned_h ucg_group_partitioned_starting(ucg_group_h group)
 {
-    if (group->is_barrier_outstanding == 0) {
-        /* current operation is not barrier */
-        return UCS_OK;
+    ucg_partitioned_h part;
+
+    if (group->parts_starting == 0) {
+        return NULL;
     }
-    group->is_barrier_outstanding = 0;
-    if (ucs_queue_is_empty(&group->pending)) {
-        return UCS_OK;
+
+    ucs_list_for_each(part, &group->partitioned, list) {
+        if (part->next_part < part->part_cnt) {
+            return part;
+        }
     }
+    return NULL;
+}
+
+/* Starts what the group delayed, in the order it was started */
+static ucs_status_t ucg_group_release_pending(ucg_group_h group)
+{
+    ucs_status_t ret = UCS_OK;
+    ucg_partitioned_h part;
+    ucg_request_t **req;
+    ucg_op_t *op;
+
+    while (!group->is_barrier_outstanding && !UCS_STATUS_IS_ERR(ret)) {
+        part = ucg_group_partitioned_starting(group);
+        if (part != NULL) {
+            if (!part->is_pending) {
+                break; /* its partitions are not all ready yet */
+            }
+            if (part->pending_seq == group->released_cnt) {
+                part->is_pending = 0;
+                (void) ucg_partitioned_start_ready(part);
+                continue;
+            }
+        }
+
+        if (ucs_queue_is_empty(&group->pending)) {
+            break;
+        }
 
-    ucs_status_t ret;
-    do {
         /* Move the operation from the pending queue back to the original one */
-        ucg_op_t *op = (ucg_op_t*)ucs_queue_pull_non_empty(&group->pending);
-        ucg_request_t **req = op->pending_req;
-        ucs_list_add_head(&op->plan->op_head, &op->list);
+        op  = (ucg_op_t*)ucs_queue_pull_non_empty(&group->pending);
+        req = op->pending_req;
+        if (ucs_likely(!ucg_group_fusion_is_owned(group, op))) {
+            ucs_list_add_head(&op->plan->op_head, &op->list);
+        } else {
+            ucs_list_head_init(&op->list);
+        }
+        group->released_cnt++;
 
         /* Start this next pending operation */
         ret = ucg_collective_trigger(group, op, req);
-    } while ((!ucs_queue_is_empty(&group->pending)) &&
-             (!group->is_barrier_outstanding) &&
-             (ret == UCS_OK));
+    }
 
     return ret;
 }
 
-static UCS_F_ALWAYS_INLINE ucs_status_t ucg_collective_start(ucg_coll_h coll, ucg_request_t **req)
+ucs_status_t ucg_collective_release_barrier(ucg_group_h group)
 {
-    if (coll == NULL || req == NULL) {
-        return UCS_ERR_INVALID_PARAM;
+    if (group->is_barrier_outstanding == 0) {
+        /* current operation is not barrier */
+        return UCS_OK;
     }
+    group->is_barrier_outstanding = 0;
+    return ucg_group_release_pending(group);
+}
+
+static UCS_F_ALWAYS_INLINE ucs_status_t ucg_collective_start_op(ucg_op_t *op, ucg_request_t **req)
+{
     ucs_status_t ret;
-    ucg_op_t *op = (ucg_op_t*)coll;
     ucg_group_h group = op->plan->group;
 
-    /* Since group was created - don't need UCP_CONTEXT_CHECK_FEATURE_FLAGS */
-    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(group->worker);
-
-    ucs_trace_req("ucg_collective_start: op=%p req=%p", coll, *req);
+    ucs_trace_req("ucg_collective_start: op=%p req=%p", op, *req);
 
-    if (ucs_unlikely(group->is_barrier_outstanding)) {
+    if (ucs_unlikely(group->is_barrier_outstanding || (group->parts_starting != 0))) {
         ucs_list_del(&op->list);
         ucs_queue_push(&group->pending, &op->queue);
         op->pending_req = req;
+        group->pended_cnt++;
         ret = UCS_INPROGRESS;
     } else {
         ret = ucg_collective_trigger(group, op, req);
     }
 
     UCS_STATS_UPDATE_COUNTER(group->stats, UCG_GROUP_STAT_OPS_USED, 1);
-    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(group->worker);
+    return ret;
+}
+
+static UCS_F_ALWAYS_INLINE ucs_status_t ucg_collective_start(ucg_coll_h coll, ucg_request_t **req)
+{
+    if (coll == NULL || req == NULL) {
+        return UCS_ERR_INVALID_PARAM;
+    }
+    ucs_status_t ret;
+    ucg_worker_h worker = ((ucg_op_t*)coll)->plan->group->worker;
+
+    /* Since group was created - don't need UCP_CONTEXT_CHECK_FEATURE_FLAGS */
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+    ret = ucg_collective_start_op((ucg_op_t*)coll, req);
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
     return ret;
 }
 
@@ -573,12 +801,471 @@ UCS_PROFILE_FUNC(ucs_status_t, ucg_collective_start_nbr,
     return ucg_collective_start(coll, (ucg_request_t**)&request);
 }
 
+UCS_PROFILE_FUNC(ucs_status_t, ucg_collective_start_nbr_batch,
+                 (colls, requests, count, statuses), ucg_coll_h *colls, void **requests,
+                 unsigned count, ucs_status_t *statuses)
+{
+    ucs_status_t ret = UCS_OK;
+    ucg_worker_h worker;
+    unsigned idx;
+
+    if ((colls == NULL) || (requests == NULL) || (statuses == NULL) || (count == 0)) {
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    /* the lock is only taken once, so all the collectives must be on its worker */
+    for (idx = 0; idx < count; idx++) {
+        if ((colls[idx] == NULL) || (requests[idx] == NULL) ||
+            (((ucg_op_t*)colls[idx])->plan->group->worker != ((ucg_op_t*)colls[0])->plan->group->worker)) {
+            return UCS_ERR_INVALID_PARAM;
+        }
+    }
+
+    ucs_debug("ucg_collective_start_nbr_batch %p count %u", colls[0], count);
+    worker = ((ucg_op_t*)colls[0])->plan->group->worker;
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(worker);
+    /* a failure does not stop the others, each one is reported on its own */
+    for (idx = 0; idx < count; idx++) {
+        statuses[idx] = ucg_collective_start_op((ucg_op_t*)colls[idx], (ucg_request_t**)&requests[idx]);
+        if (UCS_STATUS_IS_ERR(statuses[idx])) {
+            if (!UCS_STATUS_IS_ERR(ret)) {
+                ret = statuses[idx];
+            }
+        } else if ((statuses[idx] == UCS_INPROGRESS) && (ret == UCS_OK)) {
+            ret = UCS_INPROGRESS;
+        }
+    }
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(worker);
+    return ret;
+}
+
+static void ucg_group_fusion_destroy(ucg_group_h group, ucg_group_fusion_batch_t *batch)
+{
+    ucs_list_del(&batch->list);
+    group->fusion_batch_cnt--;
+    if (batch->coll != NULL) {
+        ucg_discard((ucg_op_t*)batch->coll);
+    }
+    ucs_free(batch);
+}
+
+static void ucg_group_fusion_cleanup(ucg_group_h group)
+{
+    ucg_group_fusion_batch_t *batch, *tmp;
+
+    ucs_list_for_each_safe(batch, tmp, &group->fusion_batches, list) {
+        ucg_group_fusion_destroy(group, batch);
+    }
+}
+
+/* Operations of the batches are not in their plan, so they are not put back there */
+static int ucg_group_fusion_is_owned(ucg_group_h group, const ucg_op_t *op)
+{
+    ucg_group_fusion_batch_t *batch;
+
+    ucs_list_for_each(batch, &group->fusion_batches, list) {
+        if (batch->coll == (ucg_coll_h)op) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void ucg_group_fusion_complete(ucg_group_h group, ucg_group_fusion_batch_t *batch, ucs_status_t status)
+{
+    const char *packed = (const char*)batch->params.recv.buf;
+    unsigned idx;
+
+    for (idx = 0; idx < batch->op_cnt; idx++) {
+        if (status == UCS_OK) {
+            memcpy(batch->ops[idx].buf, packed, batch->ops[idx].length);
+        }
+        packed += batch->ops[idx].length;
+        batch->ops[idx].req->status = status;
+        ucs_memory_cpu_store_fence();
+        batch->ops[idx].req->flags  = UCG_REQUEST_COMMON_FLAG_COMPLETED;
+    }
+
+    batch->is_inflight = 0;
+    if (UCS_STATUS_IS_ERR(status)) {
+        ucg_group_fusion_destroy(group, batch);
+    }
+}
+
+static void ucg_group_fusion_progress(ucg_group_h group)
+{
+    ucg_group_fusion_batch_t *batch;
+    ucs_queue_iter_t iter;
+    ucs_status_t status;
+
+    ucs_queue_for_each_safe(batch, iter, &group->fused, queue) {
+        status = ucg_request_check_status(&batch->req + 1);
+        if (status != UCS_INPROGRESS) {
+            ucs_queue_del_iter(&group->fused, iter);
+            ucg_group_fusion_complete(group, batch, status);
+        }
+    }
+}
+
+static int ucg_group_fusion_is_eligible(ucg_group_h group, const ucg_collective_params_t *params)
+{
+    /* predefined datatypes are contiguous, so allreduces are packed back to back */
+    return (params->coll_type == COLL_TYPE_ALLREDUCE) && (params->recv.count > 0) &&
+           (group->params.mpi_dt_is_predefine != NULL) && group->params.mpi_dt_is_predefine(params->recv.dt_ext);
+}
+
+/* how many of the first allreduces are fused together, and their packed length */
+static unsigned ucg_group_fusion_count(ucg_group_h group, ucg_coll_h *colls, unsigned count, size_t *length_p)
+{
+    const ucg_collective_params_t *first = &((ucg_op_t*)colls[0])->params;
+    const ucg_collective_params_t *params;
+    size_t length = 0;
+    unsigned idx;
+
+    for (idx = 0; (idx < count) && (idx < UCG_GROUP_FUSION_MAX_OPS); idx++) {
+        params = &((ucg_op_t*)colls[idx])->params;
+        if (!ucg_group_fusion_is_eligible(group, params) ||
+            (params->recv.op_ext != first->recv.op_ext) || (params->recv.dt_ext != first->recv.dt_ext) ||
+            (params->recv.dt_len != first->recv.dt_len) ||
+            ((length / params->recv.dt_len) + params->recv.count > INT_MAX)) {
+            break;
+        }
+        length += (size_t)params->recv.count * params->recv.dt_len;
+    }
+
+    *length_p = length;
+    return idx;
+}
+
+/* A batch of the same shape which is not in flight, or a new one with its operation */
+static ucs_status_t ucg_group_fusion_get(ucg_group_h group, const ucg_collective_params_t *params,
+                                         size_t length, ucg_group_fusion_batch_t **batch_p)
+{
+    ucg_group_fusion_batch_t *batch, *victim = NULL;
+    ucs_status_t status;
+    ucg_op_t *op;
+
+    ucs_list_for_each(batch, &group->fusion_batches, list) {
+        if (!batch->is_inflight && (batch->length == length) &&
+            (batch->params.recv.op_ext == params->recv.op_ext) &&
+            (batch->params.recv.dt_ext == params->recv.dt_ext) &&
+            (batch->params.recv.dt_len == params->recv.dt_len) &&
+            !memcmp(&batch->params.type, &params->type, sizeof(params->type))) {
+            ucs_list_del(&batch->list);
+            ucs_list_add_head(&group->fusion_batches, &batch->list);
+            *batch_p = batch;
+            return UCS_OK;
+        }
+    }
+
+    /* the least recently used batch not in flight makes room */
+    if (group->fusion_batch_cnt >= UCG_GROUP_FUSION_MAX_BATCHES) {
+        ucs_list_for_each(batch, &group->fusion_batches, list) {
+            if (!batch->is_inflight) {
+                victim = batch;
+            }
+        }
+        if (victim != NULL) {
+            ucg_group_fusion_destroy(group, victim);
+        }
+    }
+
+    batch = ucs_malloc(sizeof(*batch) + 2 * length, "ucg fusion batch");
+    if (batch == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    batch->params             = *params;
+    batch->params.send.buf    = batch + 1;
+    batch->params.send.count  = (int)(length / params->recv.dt_len);
+    batch->params.send.dt_len = params->recv.dt_len;
+    batch->params.send.dt_ext = params->recv.dt_ext;
+    batch->params.recv.buf    = (char*)(batch + 1) + length;
+    batch->params.recv.count  = batch->params.send.count;
+    batch->params.comp_cb     = NULL;
+    batch->length             = length;
+    batch->is_inflight        = 0;
+
+    status = ucg_collective_create_locked(group, &batch->params, &batch->coll);
+    if (status != UCS_OK) {
+        ucs_free(batch);
+        return status;
+    }
+
+    /* kept by the batch, so the plan neither finds it again nor evicts it */
+    op = (ucg_op_t*)batch->coll;
+    ucs_list_del(&op->list);
+    ucs_list_head_init(&op->list);
+    op->plan->op_cnt--;
+
+    ucs_list_add_head(&group->fusion_batches, &batch->list);
+    group->fusion_batch_cnt++;
+    *batch_p = batch;
+    return UCS_OK;
+}
+
+static ucs_status_t ucg_group_fusion_start(ucg_group_h group, ucg_coll_h *colls, void **requests,
+                                           unsigned count, size_t length)
+{
+    const ucg_collective_params_t *params = &((ucg_op_t*)colls[0])->params;
+    ucg_group_fusion_batch_t *batch;
+    ucg_request_t *req;
+    ucs_status_t status;
+    char *packed;
+    unsigned idx;
+
+    status = ucg_group_fusion_get(group, params, length, &batch);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    batch->is_inflight = 1;
+    batch->op_cnt      = count;
+    packed             = batch->params.send.buf;
+    for (idx = 0; idx < count; idx++) {
+        params = &((ucg_op_t*)colls[idx])->params;
+        batch->ops[idx].req    = (ucg_request_t*)requests[idx] - 1;
+        batch->ops[idx].buf    = params->recv.buf;
+        batch->ops[idx].length = (size_t)params->recv.count * params->recv.dt_len;
+        batch->ops[idx].req->flags = 0;
+        memcpy(packed, (params->send.buf == MPI_IN_PLACE) ? params->recv.buf : params->send.buf,
+               batch->ops[idx].length);
+        packed += batch->ops[idx].length;
+    }
+
+    ucs_trace_req("ucg_collective_start_nbr_fused: %u allreduces, %zu bytes", count, length);
+    req    = &batch->req + 1;
+    status = ucg_collective_start_op((ucg_op_t*)batch->coll, &req);
+    if (status == UCS_INPROGRESS) {
+        ucs_queue_push(&group->fused, &batch->queue);
+    } else {
+        ucg_group_fusion_complete(group, batch, status);
+    }
+    return status;
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucg_collective_start_nbr_fused,
+                 (group, colls, requests, count, statuses), ucg_group_h group, ucg_coll_h *colls,
+                 void **requests, unsigned count, ucs_status_t *statuses)
+{
+    ucs_status_t ret = UCS_OK;
+    unsigned idx, fused, op_idx;
+    size_t length;
+
+    if ((group == NULL) || (colls == NULL) || (requests == NULL) || (statuses == NULL) || (count == 0)) {
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    for (idx = 0; idx < count; idx++) {
+        if ((colls[idx] == NULL) || (requests[idx] == NULL) || (((ucg_op_t*)colls[idx])->plan->group != group)) {
+            return UCS_ERR_INVALID_PARAM;
+        }
+    }
+
+    ucs_debug("ucg_collective_start_nbr_fused group %hu count %u", group->group_id, count);
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(group->worker);
+    for (idx = 0; idx < count; idx += ucs_max(fused, 1)) {
+        fused = ucg_group_fusion_count(group, &colls[idx], count - idx, &length);
+        if (fused > 1) {
+            statuses[idx] = ucg_group_fusion_start(group, &colls[idx], &requests[idx], fused, length);
+            for (op_idx = 1; op_idx < fused; op_idx++) {
+                statuses[idx + op_idx] = statuses[idx];
+            }
+        } else {
+            statuses[idx] = ucg_collective_start_op((ucg_op_t*)colls[idx], (ucg_request_t**)&requests[idx]);
+        }
+
+        if (UCS_STATUS_IS_ERR(statuses[idx])) {
+            if (!UCS_STATUS_IS_ERR(ret)) {
+                ret = statuses[idx];
+            }
+        } else if ((statuses[idx] == UCS_INPROGRESS) && (ret == UCS_OK)) {
+            ret = UCS_INPROGRESS;
+        }
+    }
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(group->worker);
+    return ret;
+}
+
+ucs_status_t ucg_collective_partitioned_create(ucg_group_h group, const ucg_collective_params_t *params,
+                                               unsigned partitions, ucg_partitioned_h *part_p)
+{
+    ucg_partitioned_h part;
+
+    if ((group == NULL) || (params == NULL) || (part_p == NULL) || (partitions == 0)) {
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    /* partitions are slices of contiguous buffers, reduced or broadcast element-wise */
+    if (((params->coll_type != COLL_TYPE_ALLREDUCE) && (params->coll_type != COLL_TYPE_BCAST)) ||
+        (params->type.modifiers & UCG_GROUP_COLLECTIVE_MODIFIER_BARRIER) ||
+        (params->send.count < (int)partitions) || (params->recv.count != params->send.count) ||
+        (group->params.mpi_dt_is_predefine == NULL) ||
+        !group->params.mpi_dt_is_predefine(params->send.dt_ext) ||
+        !group->params.mpi_dt_is_predefine(params->recv.dt_ext)) {
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    part = ucs_malloc(sizeof(*part) + partitions * (sizeof(ucg_request_t) + sizeof(uint8_t)),
+                      "ucg partitioned collective");
+    if (part == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    part->group      = group;
+    part->params     = *params;
+    part->part_cnt   = partitions;
+    part->next_part  = partitions;
+    part->is_active  = 0;
+    part->is_pending = 0;
+    part->req        = NULL;
+    part->is_ready   = (uint8_t*)&part->reqs[partitions];
+    *part_p          = part;
+    return UCS_OK;
+}
+
+static void ucg_partitioned_slice(ucg_partitioned_h part, unsigned idx, ucg_collective_params_t *params)
+{
+    int part_count = part->params.send.count / part->part_cnt;
+    int first      = idx * part_count;
+
+    *params            = part->params;
+    params->send.count = (idx == part->part_cnt - 1) ? (part->params.send.count - first) : part_count;
+    params->recv.count = params->send.count;
+    params->comp_cb    = NULL;
+    if (params->send.buf != MPI_IN_PLACE) {
+        params->send.buf = (char*)params->send.buf + first * params->send.dt_len;
+    }
+    params->recv.buf = (char*)params->recv.buf + first * params->recv.dt_len;
+}
+
+/* Starts the partitions which are ready in order, returns whether all are started */
+static int ucg_partitioned_start_ready(ucg_partitioned_h part)
+{
+    ucg_group_h group = part->group;
+    ucg_collective_params_t params;
+    ucs_status_t status;
+    ucg_request_t *req;
+    ucg_coll_h coll;
+    unsigned idx;
+
+    while ((part->next_part < part->part_cnt) && part->is_ready[part->next_part]) {
+        idx = part->next_part++;
+        req = &part->reqs[idx] + 1;
+        ucg_partitioned_slice(part, idx, &params);
+
+        status = ucg_collective_create_locked(group, &params, &coll);
+        if (status == UCS_OK) {
+            status = ucg_collective_trigger(group, (ucg_op_t*)coll, &req);
+        }
+        if (status != UCS_INPROGRESS) {
+            part->reqs[idx].status = status;
+            part->reqs[idx].flags  = UCG_REQUEST_COMMON_FLAG_COMPLETED;
+        }
+    }
+
+    if (part->next_part < part->part_cnt) {
+        return 0;
+    }
+
+    group->parts_starting--;
+    return 1;
+}
+
+static void ucg_group_partitioned_progress(ucg_group_h group)
+{
+    ucg_partitioned_h part, tmp;
+    ucs_status_t ret, status;
+    unsigned idx;
+
+    ucs_list_for_each_safe(part, tmp, &group->partitioned, list) {
+        if (part->next_part < part->part_cnt) {
+            continue;
+        }
+
+        ret = UCS_OK;
+        for (idx = 0; idx < part->part_cnt; idx++) {
+            status = ucg_request_check_status(&part->reqs[idx] + 1);
+            if (status == UCS_INPROGRESS) {
+                break;
+            }
+            ret = (ret == UCS_OK) ? status : ret;
+        }
+        if (idx < part->part_cnt) {
+            continue;
+        }
+
+        ucs_list_del(&part->list);
+        part->is_active   = 0;
+        part->req->status = ret;
+        ucs_memory_cpu_store_fence();
+        part->req->flags  = UCG_REQUEST_COMMON_FLAG_COMPLETED;
+    }
+}
+
+ucs_status_t ucg_collective_partitioned_start(ucg_partitioned_h part, void *request)
+{
+    ucg_group_h group = part->group;
+    unsigned idx;
+
+    if ((request == NULL) || part->is_active) {
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(group->worker);
+    for (idx = 0; idx < part->part_cnt; idx++) {
+        part->reqs[idx].flags = 0;
+        part->is_ready[idx]   = 0;
+    }
+    part->next_part   = 0;
+    part->is_active   = 1;
+    part->req         = (ucg_request_t*)request - 1;
+    part->req->flags  = 0;
+    part->is_pending  = group->is_barrier_outstanding || (group->parts_starting != 0);
+    part->pending_seq = group->pended_cnt;
+    group->parts_starting++;
+    ucs_list_add_tail(&group->partitioned, &part->list);
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(group->worker);
+    return UCS_INPROGRESS;
+}
+
+ucs_status_t ucg_collective_partitioned_ready(ucg_partitioned_h part, unsigned partition)
+{
+    if (!part->is_active || (partition >= part->part_cnt)) {
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(part->group->worker);
+    part->is_ready[partition] = 1;
+    if (!part->is_pending && (partition == part->next_part) && ucg_partitioned_start_ready(part)) {
+        /* the collectives started after it */
+        (void) ucg_group_release_pending(part->group);
+    }
+    UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(part->group->worker);
+    return UCS_OK;
+}
+
+void ucg_collective_partitioned_destroy(ucg_partitioned_h part)
+{
+    if (part == NULL) {
+        return;
+    }
+
+    if (part->is_active) {
+        ucs_warn("partitioned collective %p destroyed before its completion", part);
+        while (part->is_active) {
+            ucg_group_progress(part->group);
+        }
+    }
+    ucs_free(part);
+}
+
 void ucg_collective_destroy(ucg_coll_h coll)
 {
     if (coll == NULL) {
         return;
     }
-    ucs_info("ucg_collective_destroy %p", coll);
+    ucs_trace_req("ucg_collective_destroy %p", coll);
     ucg_discard((ucg_op_t*)coll);
 }
 
@@ -616,6 +1303,8 @@ ucs_status_t ucg_worker_groups_init(void *groups_ctx)
 void ucg_worker_groups_cleanup(void *groups_ctx)
 {
     ucg_groups_t *gctx = (ucg_groups_t*)groups_ctx;
+    ucg_plan_component_t *planc;
+    unsigned planner_idx;
 
     ucg_group_h group = NULL;
     ucg_group_h tmp = NULL;
@@ -627,6 +1316,13 @@ void ucg_worker_groups_cleanup(void *groups_ctx)
 
     kh_destroy_inplace(ucg_groups_ep, &gctx->eps);
 
+    for (planner_idx = 0; planner_idx < gctx->num_planners; planner_idx++) {
+        planc = gctx->planners[planner_idx].plan_component;
+        if (planc->worker_cleanup != NULL) {
+            planc->worker_cleanup(UCG_GROUPS_CTX_TO_WORKER(gctx));
+        }
+    }
+
     ucg_plan_release_list(gctx->planners, gctx->num_planners);
 }
 
@@ -750,6 +1446,48 @@ connect_cleanup:
     return status;
 }
 
+ucs_status_t ucg_plan_connect_rails(ucg_group_h group, ucp_ep_h ucp_ep, unsigned max_rails,
+                                    uct_ep_h *eps, uct_md_h *mds, const uct_iface_attr_t **ep_attrs,
+                                    double *bandwidths, unsigned *rail_cnt_p)
+{
+    ucg_groups_t *gctx = UCG_WORKER_TO_GROUPS_CTX(group->worker);
+    ucp_ep_config_t *config = ucp_ep_config(ucp_ep);
+    ucp_context_h context = group->worker->context;
+    ucp_lane_index_t lane;
+    unsigned lane_idx;
+    unsigned rail_cnt = 0;
+    uct_ep_h uct_ep;
+
+    /* am_bw_lanes[0] is the AM lane used by ucg_plan_connect() */
+    for (lane_idx = 0; (lane_idx < UCP_MAX_LANES) && (rail_cnt < max_rails); lane_idx++) {
+        lane = config->key.am_bw_lanes[lane_idx];
+        if (lane == UCP_NULL_LANE) {
+            break;
+        }
+
+        uct_ep = ucp_ep->uct_eps[lane];
+        if ((uct_ep == NULL) || ucp_wireup_ep_test(uct_ep)) {
+            /* not connected (yet) - only the AM lane is worth waiting for */
+            continue;
+        }
+
+        if (ucp_proxy_ep_test(uct_ep)) {
+            uct_ep = ucs_derived_of(uct_ep, ucp_proxy_ep_t)->uct_ep;
+        }
+
+        eps[rail_cnt]        = uct_ep;
+        mds[rail_cnt]        = ucp_ep_md(ucp_ep, lane);
+        ep_attrs[rail_cnt]   = ucp_ep_get_iface_attr(ucp_ep, lane);
+        bandwidths[rail_cnt] = ucp_tl_iface_bandwidth(context, &ep_attrs[rail_cnt]->bandwidth);
+        rail_cnt++;
+
+        UCG_GROUP_PROGRESS_ADD(uct_ep->iface, group);
+        UCG_GROUP_PROGRESS_ADD(uct_ep->iface, gctx);
+    }
+
+    *rail_cnt_p = rail_cnt;
+    return UCS_OK;
+}
 
 ucs_status_t ucg_worker_create(ucp_context_h context,
                                const ucp_worker_params_t *params,
@@ -32,9 +32,17 @@
 /* max number of ops stored in a plan */
 #define UCG_GROUP_MAX_OPS_IN_PLAN  200
 
+/* max number of allreduces fused into a single one */
+#define UCG_GROUP_FUSION_MAX_OPS   64
+
+/* max number of fused allreduces kept for reuse by a group */
+#define UCG_GROUP_FUSION_MAX_BATCHES 16
+
 extern size_t ucg_ctx_worker_offset;
 #define UCG_WORKER_TO_GROUPS_CTX(worker) \
     ((ucg_groups_t*)((char*)(worker) + ucg_ctx_worker_offset))
+#define UCG_GROUPS_CTX_TO_WORKER(gctx) \
+    ((ucg_worker_h)((char*)(gctx) - ucg_ctx_worker_offset))
 
 #define UCG_FLAG_MASK(params) \
     ((params)->type.modifiers & UCG_GROUP_COLLECTIVE_MODIFIER_MASK)
@@ -65,6 +73,50 @@ typedef struct ucg_groups {
     ucg_plan_desc_t      *planners;
 } ucg_groups_t;
 
+/*
+ * Allreduces started together on a group, packed into a single allreduce. The
+ * send and receive buffers follow the batch. Batches are kept for reuse by the
+ * same shape of allreduce, with their operation, which is owned by the batch
+ * and not by the plan.
+ */
+typedef struct ucg_group_fusion_batch {
+    ucs_list_link_t         list;      /* member of the group's batches, latest used first */
+    ucs_queue_elem_t        queue;     /* member of the group's fused ones in flight */
+    ucg_collective_params_t params;    /* of the fused allreduce */
+    ucg_coll_h              coll;
+    size_t                  length;    /* bytes packed */
+    int                     is_inflight;
+    unsigned                op_cnt;
+    struct {
+        ucg_request_t      *req;
+        void               *buf;       /* receive buffer of the allreduce */
+        size_t              length;
+    } ops[UCG_GROUP_FUSION_MAX_OPS];
+    ucg_request_t           req;       /* of the fused allreduce */
+} ucg_group_fusion_batch_t;
+
+/*
+ * A collective split into partitions, each run as the same collective on its
+ * slice of the buffers. Partitions start in order, once they and all the ones
+ * before them are ready, so all the members start them in the same order.
+ * Other collectives of the group, partitioned or not, wait until the last
+ * partition started. One started while the group waits is pending as well, and
+ * starts after the collectives pended before it.
+ */
+struct ucg_partitioned {
+    ucs_list_link_t         list;      /* member of the group's started ones */
+    ucg_group_h             group;
+    ucg_collective_params_t params;
+    unsigned                part_cnt;
+    unsigned                next_part; /* first partition not started */
+    int                     is_active;
+    int                     is_pending; /* waits for the group, no partition started */
+    uint64_t                pending_seq; /* collectives pended on the group before it */
+    ucg_request_t          *req;       /* of the whole collective */
+    uint8_t                *is_ready;
+    ucg_request_t           reqs[0];   /* of every partition */
+};
+
 struct ucg_group {
     /*
      * Whether a current barrier is waited upon. If so, new collectives cannot
@@ -76,6 +128,13 @@ struct ucg_group {
     ucg_coll_id_t      next_id;      /* for the next collective operation */
     ucg_group_id_t     group_id;     /* group identifier (order of creation) */
     ucs_queue_head_t   pending;      /* requests currently pending execution */
+    ucs_queue_head_t   fused;        /* fused allreduces started, not completed */
+    ucs_list_link_t    fusion_batches; /* fused allreduces kept for reuse */
+    unsigned           fusion_batch_cnt;
+    uint64_t           pended_cnt;   /* collectives ever put in the pending queue */
+    uint64_t           released_cnt; /* collectives ever pulled from it */
+    unsigned           parts_starting; /* partitioned collectives not fully started */
+    ucs_list_link_t    partitioned;  /* partitioned collectives started, not completed */
     ucg_group_params_t params;       /* parameters, for future connections */
     ucs_list_link_t    list;         /* worker's group list */
 
@@ -94,4 +153,12 @@ int ucg_builtin_op_can_reuse(const ucg_plan_t *plan, const ucg_op_t *op,
 
 ucs_status_t ucg_builtin_op_md_mem_rereg(ucg_op_t *op);
 
+/* Collective metrics of the group, see UCX_BUILTIN_METRICS */
+unsigned ucg_builtin_group_metrics_query(ucg_group_h group, ucg_collective_metrics_t *metrics, unsigned max);
+void ucg_builtin_group_metrics_print(ucg_group_h group, FILE *stream);
+uint64_t ucg_builtin_metrics_bucket_nsec(unsigned bucket);
+
+/* Same as @ref ucg_group_progress , with the worker's lock already held */
+unsigned ucg_group_progress_locked(ucg_group_h group);
+
 #endif /* UCG_GROUP_H_ */
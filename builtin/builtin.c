@@ -4,9 +4,15 @@
  * Notes: See file LICENSE for terms.
  */
 
+#include <pthread.h>
+#include <sched.h>
 #include <string.h>
+#include <unistd.h>
+#include <ucs/arch/atomic.h>
 #include <ucs/debug/memtrack.h>
 #include <ucs/profile/profile.h>
+#include <ucs/sys/math.h>
+#include <ucs/time/time.h>
 #include <ucg/api/ucg_mpi.h>
 #include <ucg/base/ucg_group.h>
 #include <ucg/api/ucg_plan_component.h>
@@ -21,6 +27,10 @@
 #define DEFAULT_INTER_KVALUE 8
 #define DEFAULT_INTRA_KVALUE 2
 #define DATATYPE_ALIGN 16
+#define DEFAULT_DISSEMINATION_RADIX 2
+#define ZCOPY_EAGER_SAMPLE_MIN 4096  /* registration cost is fitted between these two lengths */
+#define ZCOPY_EAGER_SAMPLE_MAX 65536
+#define ZCOPY_EAGER_SAMPLE_ITER 4     /* copies, the best one is kept */
 
 #define UCG_BUILTIN_SUPPORT_MASK (UCG_GROUP_COLLECTIVE_MODIFIER_AGGREGATE |\
                                   UCG_GROUP_COLLECTIVE_MODIFIER_BROADCAST)
@@ -93,8 +103,11 @@ static ucs_config_field_t ucg_builtin_config_table[] = {
     {"NAP_", "", NULL, ucs_offsetof(ucg_builtin_config_t, NAP),
     UCS_CONFIG_TYPE_TABLE(ucg_builtin_NAP_config_table)},
 
-    {"MAX_MSG_LIST_SIZE", "40", "Largest loop count of msg process function",
-     ucs_offsetof(ucg_builtin_config_t, max_msg_list_size), UCS_CONFIG_TYPE_UINT},
+    {"RECURSIVE_", "", NULL, ucs_offsetof(ucg_builtin_config_t, recursive),
+    UCS_CONFIG_TYPE_TABLE(ucg_builtin_recursive_config_table)},
+
+    {"MAX_MSG_LIST_SIZE", "", NULL,
+     UCS_CONFIG_DEPRECATED_FIELD_OFFSET, UCS_CONFIG_TYPE_DEPRECATED},
 
     {"MEM_REG_OPT_CNT", "10", "Operation counter before registering the memory",
      ucs_offsetof(ucg_builtin_config_t, mem_reg_opt_cnt), UCS_CONFIG_TYPE_ULUNITS},
@@ -118,9 +131,95 @@ static ucs_config_field_t ucg_builtin_config_table[] = {
     {"LADD_THEROTTLED_FACTOR", "0", "throttle factor",
     ucs_offsetof(ucg_builtin_config_t, throttle_factor), UCS_CONFIG_TYPE_UINT},
 
+    {"BARRIER_DISSEMINATION_RADIX", "2", "Number of peers signalled per round by the dissemination barrier",
+    ucs_offsetof(ucg_builtin_config_t, dissemination_radix), UCS_CONFIG_TYPE_UINT},
+
+    {"NATIVE_REDUCE", "n", "Reduce predefined operations and datatypes with the built-in vectorised kernels\n"
+    "instead of the MPI reduce callback, which is kept for user-defined operations. Only for\n"
+    "integrations whose get_operate_param_f reports ucg_operate_type_t and ucg_operate_dtype_t codes.",
+    ucs_offsetof(ucg_builtin_config_t, native_reduce), UCS_CONFIG_TYPE_BOOL},
+
+    {"MAX_RAILS", "1", "Number of interfaces large fragments to the same peer are striped over.\n"
+    "Only the AM bandwidth lanes of the connection are used, see UCX_MAX_EAGER_RAILS.",
+    ucs_offsetof(ucg_builtin_config_t, max_rails), UCS_CONFIG_TYPE_UINT},
+
+    {"RAIL_STRIPE_MIN", "64k", "Fragments smaller than this are not striped and use the first interface",
+    ucs_offsetof(ucg_builtin_config_t, rail_stripe_min), UCS_CONFIG_TYPE_MEMUNITS},
+
+    {"RAIL_WEIGHTED", "y", "Stripe fragments by interface bandwidth instead of round-robin",
+    ucs_offsetof(ucg_builtin_config_t, rail_weighted), UCS_CONFIG_TYPE_BOOL},
+
+    {"RNDV_THRESH", "inf", "Messages from this size on are read by the receiver straight from the sender's\n"
+    "buffer (RMA get) instead of being sent as active messages. Used by broadcast and\n"
+    "recursive-doubling allgather, where the interface supports get zero-copy.",
+    ucs_offsetof(ucg_builtin_config_t, rndv_thresh), UCS_CONFIG_TYPE_MEMUNITS},
+
+    {"REG_CACHE", "y", "Keep zero-copy memory registrations in a cache, so that operations reusing a\n"
+    "buffer do not register it again. Cached regions are dropped when their memory is unmapped.",
+    ucs_offsetof(ucg_builtin_config_t, reg_cache), UCS_CONFIG_TYPE_BOOL},
+
+    {"MAX_CONCURRENT_OPS", "16", "Collective operations of a group outstanding at the same time, rounded up\n"
+    "to a power of 2. Further operations wait for a slot and make the window grow.",
+    ucs_offsetof(ucg_builtin_config_t, concurrent_ops), UCS_CONFIG_TYPE_UINT},
+
+    {"MAX_CONCURRENT_OPS_LIMIT", "128", "Largest window of outstanding collective operations of a group,\n"
+    "at most 128.",
+    ucs_offsetof(ucg_builtin_config_t, concurrent_ops_limit), UCS_CONFIG_TYPE_UINT},
+
+    {"WAIT_SPIN_TIME", "100us", "Time ucg_request_wait progresses before it blocks on the worker's events.",
+    ucs_offsetof(ucg_builtin_config_t, wait_spin_time), UCS_CONFIG_TYPE_TIME},
+
+    {"ASYNC_PROGRESS", "n", "Progress the collectives of a worker from a dedicated thread, so non-blocking\n"
+    "collectives advance between the application's calls. Requires a thread-multi worker.",
+    ucs_offsetof(ucg_builtin_config_t, async_progress), UCS_CONFIG_TYPE_BOOL},
+
+    {"ASYNC_PROGRESS_INTERVAL", "0", "Pause of the progress thread after a pass without progress, while\n"
+    "collectives are outstanding, 0 to keep polling. The thread sleeps while none are.",
+    ucs_offsetof(ucg_builtin_config_t, async_interval), UCS_CONFIG_TYPE_TIME},
+
+    {"REDUCE_THREADS", "0", "Threads of a worker splitting large reductions of predefined operations and\n"
+    "datatypes with the progressing thread, pinned to the other CPUs the rank is bound to. 0 to reduce\n"
+    "on the progressing thread only.",
+    ucs_offsetof(ucg_builtin_config_t, reduce_threads), UCS_CONFIG_TYPE_UINT},
+
+    {"REDUCE_THREADS_THRESH", "8m", "Smallest reduction split over the REDUCE_THREADS threads.",
+    ucs_offsetof(ucg_builtin_config_t, reduce_threads_thresh), UCS_CONFIG_TYPE_MEMUNITS},
+
+    {"METRICS", "n", "Record per-group latency histograms and counters of the collectives, by type,\n"
+    "algorithm and power-of-two message length. They are dumped on the group destruction, and can\n"
+    "be queried with ucg_group_metrics_query.",
+    ucs_offsetof(ucg_builtin_config_t, metrics), UCS_CONFIG_TYPE_BOOL},
+
+    {"METRICS_FILE", "", "Prefix of the files the METRICS are appended to, as <METRICS_FILE>.<pid>.\n"
+    "Empty to log them at info level.",
+    ucs_offsetof(ucg_builtin_config_t, metrics_file), UCS_CONFIG_TYPE_STRING},
+
+    {"METRICS_SIGNAL", "0", "Signal number dumping the METRICS of every group on its next progress,\n"
+    "0 for none.",
+    ucs_offsetof(ucg_builtin_config_t, metrics_signal), UCS_CONFIG_TYPE_INT},
+
+    {"TRACE_FILE", "", "Record a timeline of the collectives: triggers, step sends, receives, step\n"
+    "completions, resends and completions. It is written on worker cleanup to <TRACE_FILE>.<rank>.json,\n"
+    "in the Chrome trace format, with a track per rank. Empty to disable.",
+    ucs_offsetof(ucg_builtin_config_t, trace_file), UCS_CONFIG_TYPE_STRING},
+
+    {"TRACE_EVENTS", "65536", "Latest TRACE_FILE events kept by every thread.",
+    ucs_offsetof(ucg_builtin_config_t, trace_events), UCS_CONFIG_TYPE_UINT},
+
+    {"DECISION_AUDIT", "32", "Algorithm decisions logged at info level, once per new plan cache entry, with\n"
+    "their inputs, fallbacks and final algorithm. Counted per process, 0 to disable.",
+    ucs_offsetof(ucg_builtin_config_t, decision_audit), UCS_CONFIG_TYPE_UINT},
+
+    {"ZCOPY_EAGER_THRESH", "auto", "Buffers sent by bcopy are registered and sent by zcopy from the first\n"
+    "call from this length on, smaller ones only after MEM_REG_OPT_CNT calls. \"auto\" measures\n"
+    "where copying becomes more expensive than registering, once per memory domain.",
+    ucs_offsetof(ucg_builtin_config_t, zcopy_eager_thresh), UCS_CONFIG_TYPE_MEMUNITS},
+
     /* To ensure consistency of allreduce calculation results,you need to enable this flag.
-    By default, this function is disabled. If this flag is enabled, the performance of the
-    allreduce tree algorithm interface decreases by 5%. */
+    By default, this function is disabled. If this flag is enabled, tree nodes reduce their
+    children in rank order as they become ready, holding only the ones that arrive early,
+    and recursive k-ing falls back to radix 2. Ring and binary block reduce one peer per
+    step, so their order is already fixed. */
     {"REDUCE_CONSISTENCY", "n", "reduce consistency flag",
     ucs_offsetof(ucg_builtin_config_t, reduce_consistency), UCS_CONFIG_TYPE_BOOL},
     {NULL}
@@ -141,6 +240,7 @@ struct ucg_builtin_algorithm ucg_algo = {
     .binary_block = 0,
     .ladd         = 0,
     .plummer      = 0,
+    .sparse       = 0,
 };
 
 struct ucg_builtin_group_ctx {
@@ -153,26 +253,79 @@ struct ucg_builtin_group_ctx {
     ucs_list_link_t           plan_head;    /* for resource release */
     ucg_builtin_config_t     *config;
 
-    ucg_builtin_comp_slot_t   *slots;
+    ucg_builtin_slot_window_t *window;      /* slots of the outstanding operations */
+    ucg_builtin_scratch_t     scratch;      /* temporary buffers of the group's operations */
+    ucg_builtin_rcache_t      rcache;       /* zero-copy registrations of the group's operations */
+
+    struct {
+        uct_md_h              md;
+        size_t                crossover;    /* bcopy length from which registering is cheaper */
+    } zcopy_eager[UCG_BUILTIN_RCACHE_MAX_MDS];
+    unsigned                  zcopy_eager_cnt;
+
+    ucg_builtin_async_t      *async;        /* progress thread of the worker, NULL if none */
+    ucs_list_link_t           async_list;   /* member of the groups it progresses */
+    ucg_builtin_rpool_t      *rpool;        /* reduction threads of the worker, NULL if none */
+    ucg_builtin_metrics_t     metrics;      /* latency histograms and counters of the collectives */
+};
+
+/*
+ * Passes of the progress thread hold the worker's lock, like the application
+ * calls to start and progress collectives. The thread only polls while some
+ * collective is outstanding, and waits for the next start otherwise.
+ */
+struct ucg_builtin_async {
+    pthread_t                 thread;
+    pthread_mutex_t           lock;         /* for the sleep only */
+    pthread_cond_t            cond;
+    volatile int              is_stop;
+    int                       is_kicked;    /* a collective started since the last pass */
+    ucg_worker_h              worker;
+    ucs_list_link_t           groups;
+    unsigned long             interval;     /* usec between passes without progress */
+    uint64_t                  pass_cnt;
+    uint64_t                  sleep_cnt;
 };
 
+/*
+ * Windows of the worker's groups by group_id, in fixed chunks which are never
+ * moved. The AM handler looks windows up without a lock, and a new chunk or
+ * window is published with a single atomic store.
+ */
+#define UCG_BUILTIN_WINDOW_CHUNK_SHIFT 6
+#define UCG_BUILTIN_WINDOW_CHUNK_SIZE  UCS_BIT(UCG_BUILTIN_WINDOW_CHUNK_SHIFT)
+#define UCG_BUILTIN_WINDOW_CHUNKS      ((UCS_BIT(8 * sizeof(ucg_group_id_t)) + \
+                                         UCG_BUILTIN_WINDOW_CHUNK_SIZE - 1) / UCG_BUILTIN_WINDOW_CHUNK_SIZE)
+
 typedef struct ucg_builtin_ctx {
-    unsigned slots_total;
-    ucg_builtin_comp_slot_t **slots;
+    ucg_builtin_slot_window_t **chunks[UCG_BUILTIN_WINDOW_CHUNKS];
+    ucg_builtin_async_t *async;
+    int is_async_checked;
+    ucg_builtin_rpool_t *rpool;
+    int is_rpool_checked;
 } ucg_builtin_ctx_t;
 
-static ucg_builtin_comp_slot_t *ucg_builtin_alloc_slot()
+/* Window size from the configuration: a power of 2, no more than UCG_BUILTIN_MAX_CONCURRENT_OPS */
+static unsigned ucg_builtin_window_size(unsigned size)
+{
+    return ucs_min(ucs_roundup_pow2(ucs_max(size, 1)), UCG_BUILTIN_MAX_CONCURRENT_OPS);
+}
+
+static ucg_builtin_comp_slot_t *ucg_builtin_alloc_slot(unsigned size, ucs_mpool_t *mp)
 {
     ucg_builtin_comp_slot_t *slot =
-        ucs_malloc(sizeof(ucg_builtin_comp_slot_t) * UCG_BUILTIN_MAX_CONCURRENT_OPS, "ucg_msg_slot");
+        ucs_malloc(sizeof(ucg_builtin_comp_slot_t) * size, "ucg_msg_slot");
     if (slot == NULL) {
         return NULL;
     }
 
-    unsigned i;
-    for (i = 0; i < UCG_BUILTIN_MAX_CONCURRENT_OPS; i++) {
-        ucs_list_head_init(&slot[i].msg_head);
-        slot[i].mp = NULL;
+    unsigned i, bucket;
+    for (i = 0; i < size; i++) {
+        for (bucket = 0; bucket < UCG_BUILTIN_MSG_BUCKETS; bucket++) {
+            ucs_list_head_init(&slot[i].msg_head[bucket]);
+        }
+        slot[i].msg_cnt = 0;
+        slot[i].mp = mp;
         slot[i].cb = NULL;
         slot[i].coll_id = 0;
         slot[i].step_idx = 0;
@@ -180,12 +333,86 @@ static ucg_builtin_comp_slot_t *ucg_builtin_alloc_slot()
     return slot;
 }
 
-static void ucg_builtin_free_slot(ucg_builtin_comp_slot_t *slot)
+static ucg_builtin_slot_window_t *ucg_builtin_alloc_window()
+{
+    const ucg_builtin_config_t *config = (const ucg_builtin_config_t*)ucg_builtin_component.plan_config;
+    unsigned size = ucg_builtin_window_size(config->concurrent_ops);
+
+    ucg_builtin_slot_window_t *window = ucs_malloc(sizeof(*window), "ucg_slot_window");
+    if (window == NULL) {
+        return NULL;
+    }
+
+    window->slots = ucg_builtin_alloc_slot(size, NULL);
+    if (window->slots == NULL) {
+        ucs_free(window);
+        return NULL;
+    }
+
+    window->mask        = size - 1;
+    window->limit       = ucs_max(ucg_builtin_window_size(config->concurrent_ops_limit), size);
+    window->is_grow     = 0;
+    window->mp          = NULL;
+    window->retired_cnt = 0;
+    ucs_queue_head_init(&window->waiting);
+    return window;
+}
+
+static void ucg_builtin_free_window(ucg_builtin_slot_window_t *window)
+{
+    unsigned i;
+
+    for (i = 0; i <= window->mask; i++) {
+        if (window->slots[i].msg_cnt != 0) {
+            ucs_warn("massage head is not empty!");
+        }
+    }
+
+    for (i = 0; i < window->retired_cnt; i++) {
+        ucs_free(window->retired[i]);
+    }
+    ucs_free(window->slots);
+    ucs_free(window);
+}
+
+/*
+ * Double the window of an idle group. The stored messages follow their
+ * coll_id to the new slots, the old slots are kept until the window is freed
+ * since completed user requests may still point there.
+ */
+static ucs_status_t ucg_builtin_grow_window(ucg_builtin_slot_window_t *window)
 {
-    if (!ucs_list_is_empty(&slot->msg_head)) {
-        ucs_warn("massage head is not empty!");
+    unsigned size = 2 * (window->mask + 1);
+    unsigned i, bucket;
+
+    if ((size > window->limit) || (window->retired_cnt == UCG_BUILTIN_MAX_WINDOW_GROWTH)) {
+        return UCS_ERR_EXCEEDS_LIMIT;
+    }
+
+    ucg_builtin_comp_slot_t *slots = ucg_builtin_alloc_slot(size, window->mp);
+    if (slots == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    for (i = 0; i <= window->mask; i++) {
+        for (bucket = 0; bucket < UCG_BUILTIN_MSG_BUCKETS; bucket++) {
+            while (!ucs_list_is_empty(&window->slots[i].msg_head[bucket])) {
+                ucg_builtin_comp_desc_t *desc =
+                        ucs_list_extract_head(&window->slots[i].msg_head[bucket],
+                                              ucg_builtin_comp_desc_t, super.tag_list[0]);
+                ucg_builtin_comp_slot_t *slot = &slots[desc->header.coll_id & (size - 1)];
+                ucs_list_add_tail(ucg_builtin_slot_msgs(slot, desc->header.step_idx), &desc->super.tag_list[0]);
+                slot->msg_cnt++;
+            }
+        }
+        window->slots[i].msg_cnt = 0;
     }
-    ucs_free(slot);
+
+    window->retired[window->retired_cnt++] = window->slots;
+    window->slots = slots;
+    window->mask  = size - 1;
+    ucs_debug("slot window %p grown to %u collectives", window, size);
+    return UCS_OK;
 }
 
 static ucs_status_t ucg_builtin_init_ctx(ucg_builtin_ctx_t **ctx)
@@ -193,39 +420,52 @@ static ucs_status_t ucg_builtin_init_ctx(ucg_builtin_ctx_t **ctx)
     /* The applied memory is reclaimed by the operating system. */
     (*ctx) = UCS_ALLOC_CHECK(sizeof(ucg_builtin_ctx_t), "alloc ucg_builtin_ctx_t");
 
-    (*ctx)->slots_total = 0;
-    (*ctx)->slots       = NULL;
+    memset((*ctx)->chunks, 0, sizeof((*ctx)->chunks));
+    (*ctx)->async            = NULL;
+    (*ctx)->is_async_checked = 0;
+    (*ctx)->rpool            = NULL;
+    (*ctx)->is_rpool_checked = 0;
     return UCS_OK;
 }
 
 
-static ucs_status_t ucg_builtin_extend_slots(ucg_builtin_ctx_t *ctx, unsigned max_size)
+/* Stores the pointer unless another thread stored one first, returns the one stored */
+static void *ucg_builtin_publish(void **location, void *ptr)
 {
-    if (ctx->slots_total >= max_size) {
-        return UCS_OK;
-    }
-    size_t slots_size = max_size * sizeof(ucg_builtin_comp_slot_t *);
-    ucg_builtin_comp_slot_t **new_slots = ucs_realloc(ctx->slots, slots_size, "ucg_msg_slots");
-    if (new_slots == NULL) {
-        return UCS_ERR_NO_MEMORY;
+    if (ucs_atomic_bool_cswap64((volatile uint64_t*)location, 0, (uintptr_t)ptr)) {
+        return ptr;
     }
-    ctx->slots = new_slots;
-    unsigned i;
-    for (i = ctx->slots_total; i < max_size; i++) {
-        ctx->slots[i] = ucg_builtin_alloc_slot();
-        if (ctx->slots[i] == NULL) {
-            goto cleanup;
+
+    return *(void* volatile*)location;
+}
+
+static ucg_builtin_slot_window_t *ucg_builtin_extend_slots(ucg_builtin_ctx_t *ctx, unsigned group_id)
+{
+    ucg_builtin_slot_window_t ***chunk_p = &ctx->chunks[group_id >> UCG_BUILTIN_WINDOW_CHUNK_SHIFT];
+    ucg_builtin_slot_window_t **chunk = *chunk_p;
+    ucg_builtin_slot_window_t *window;
+
+    if (chunk == NULL) {
+        chunk = ucs_calloc(UCG_BUILTIN_WINDOW_CHUNK_SIZE, sizeof(*chunk), "ucg_msg_slots");
+        if (chunk == NULL) {
+            return NULL;
+        }
+        if (ucg_builtin_publish((void**)chunk_p, chunk) != chunk) {
+            ucs_free(chunk);
+            chunk = *chunk_p;
         }
     }
-    ctx->slots_total = max_size;
-    return UCS_OK;
 
-cleanup:
-    while((i--) > ctx->slots_total) {
-        ucg_builtin_free_slot(ctx->slots[i]);
-        ctx->slots[i] = NULL;
+    window = ucg_builtin_alloc_window();
+    if (window == NULL) {
+        return NULL;
     }
-    return UCS_ERR_NO_MEMORY;
+    if (ucg_builtin_publish((void**)&chunk[group_id & (UCG_BUILTIN_WINDOW_CHUNK_SIZE - 1)], window) != window) {
+        ucg_builtin_free_window(window);
+        window = chunk[group_id & (UCG_BUILTIN_WINDOW_CHUNK_SIZE - 1)];
+    }
+
+    return window;
 }
 
 static ucg_builtin_ctx_t *ucg_builtin_get_ctx(ucg_worker_h worker)
@@ -242,41 +482,41 @@ static ucg_builtin_ctx_t *ucg_builtin_get_ctx(ucg_worker_h worker)
     return (*ctx);
 }
 
-static ucg_builtin_comp_slot_t *ucg_builtin_get_slot(ucg_worker_h worker, unsigned group_id)
+static ucg_builtin_slot_window_t *ucg_builtin_get_slot(ucg_worker_h worker, unsigned group_id)
 {
     ucg_builtin_ctx_t *ctx = ucg_builtin_get_ctx(worker);
+    ucg_builtin_slot_window_t **chunk;
     if (ctx == NULL) {
         return NULL;
     }
 
-    if (ctx->slots_total <= group_id) {
-        return NULL;
-    }
-
-    return ctx->slots[group_id];
+    chunk = ctx->chunks[group_id >> UCG_BUILTIN_WINDOW_CHUNK_SHIFT];
+    return (chunk != NULL) ? chunk[group_id & (UCG_BUILTIN_WINDOW_CHUNK_SIZE - 1)] : NULL;
 }
 
-static ucg_builtin_comp_slot_t *ucg_builtin_set_slot(ucg_worker_h worker, unsigned group_id, ucs_mpool_t *group_am_mp)
+static ucg_builtin_slot_window_t *ucg_builtin_set_slot(ucg_worker_h worker, unsigned group_id,
+                                                       ucs_mpool_t *group_am_mp)
 {
     ucg_builtin_ctx_t *ctx = ucg_builtin_get_ctx(worker);
     if (ctx == NULL) {
         return NULL;
     }
 
-    if (ctx->slots_total <= group_id) {
-        ucs_status_t status = ucg_builtin_extend_slots(ctx, group_id + 1);
-        if (status != UCS_OK) {
+    ucg_builtin_slot_window_t *window = ucg_builtin_get_slot(worker, group_id);
+    if (window == NULL) {
+        window = ucg_builtin_extend_slots(ctx, group_id);
+        if (window == NULL) {
             return NULL;
         }
     }
 
     unsigned i;
-    for (i = 0; i < UCG_BUILTIN_MAX_CONCURRENT_OPS; i++) {
-        ucg_builtin_comp_slot_t *slot = &ctx->slots[group_id][i];
-        slot->mp = group_am_mp;
+    for (i = 0; i <= window->mask; i++) {
+        window->slots[i].mp = group_am_mp;
     }
+    window->mp = group_am_mp;
 
-    return ctx->slots[group_id];
+    return window;
 }
 
 /*
@@ -331,6 +571,9 @@ enum ucg_builtin_plan_topology_type ucg_builtin_choose_type(enum ucg_collective_
     }
 
     if (flags & ucg_predefined_modifiers[UCG_PRIMITIVE_ALLTOALLV]) {
+        if (ucg_algo.sparse) {
+            return UCG_PLAN_ALLTOALLV_SPARSE;
+        }
         return (ucg_algo.plummer) ? UCG_PLAN_ALLTOALLV_PLUMMER : UCG_PLAN_ALLTOALLV_LADD;
     }
 
@@ -351,14 +594,26 @@ static ucs_status_t ucg_builtin_am_process(ucg_builtin_comp_slot_t *slot, void *
 
 {
     ucg_builtin_header_t *header = data;
+    UCG_BUILTIN_TRACE(UCG_BUILTIN_TRACE_RECV, header->group_id, header->coll_id, header->step_idx,
+                      length - sizeof(ucg_builtin_header_t));
    /* Consume the message if it fits the current collective and step index */
     if (ucs_likely(slot->cb && (header->local_id == slot->local_id))) {
         /* Make sure the packet indeed belongs to the collective currently on */
         ucs_debug("ucg_builtin_am_handler CB: coll_id %u step_idx %u cb %p pending %u",
                   header->coll_id, header->step_idx, slot->cb, slot->req.pending);
 
+        /* A peer has read my buffer - this completes a send, not a receive */
+        if (ucs_unlikely(ucg_builtin_rndv_is_ctl(slot->req.step, header->remote_offset,
+                                                 UCG_BUILTIN_RNDV_ATS))) {
+            ucg_builtin_rndv_ack(&slot->req, data + sizeof(ucg_builtin_header_t),
+                                 length - sizeof(ucg_builtin_header_t));
+            return UCS_OK;
+        }
+
+        /* Reading does not touch what I send, and holding RTS back would stall both peers */
         if ((slot->req.step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_ZCOPY) &&
-            (slot->req.step->flags & UCG_BUILTIN_OP_STEP_FLAG_RECV_AFTER_SEND)) {
+            (slot->req.step->flags & UCG_BUILTIN_OP_STEP_FLAG_RECV_AFTER_SEND) &&
+            !(slot->req.step->flags & UCG_BUILTIN_OP_STEP_FLAG_RNDV)) {
              /* receive from "multiple" EPs with "multiple" fragments */
             unsigned recv_zcopy_cnt = slot->req.step->fragments_recv * slot->req.step->phase->ep_cnt;
             /* Zcopy recv before sending finished, store msg */
@@ -387,10 +642,13 @@ static ucs_status_t ucg_builtin_am_process(ucg_builtin_comp_slot_t *slot, void *
         }
 
         /* The packet arrived "on time" - process it */
+        ucg_builtin_comp_recv_cb_t recv_cb =
+                ucg_builtin_rndv_is_rts(slot->req.step, header->remote_offset) ?
+                ucg_builtin_rndv_recv : slot->cb;
         UCS_PROFILE_CODE("ucg_builtin_am_handler_cb") {
-            (void) slot->cb(&slot->req, header->remote_offset,
-                            data + sizeof(ucg_builtin_header_t),
-                            length - sizeof(ucg_builtin_header_t));
+            (void) recv_cb(&slot->req, header->remote_offset,
+                           data + sizeof(ucg_builtin_header_t),
+                           length - sizeof(ucg_builtin_header_t));
         }
         return UCS_OK;
     }
@@ -435,7 +693,8 @@ am_handler_store:
 
     desc->super.flags = am_flags;
     desc->super.length = length - sizeof(ucg_builtin_header_t);
-    ucs_list_add_tail(&slot->msg_head, &desc->super.tag_list[0]);
+    ucs_list_add_tail(ucg_builtin_slot_msgs(slot, header->step_idx), &desc->super.tag_list[0]);
+    slot->msg_cnt++;
     return ret;
 }
 
@@ -443,21 +702,21 @@ UCS_PROFILE_FUNC(ucs_status_t, ucg_builtin_am_handler,
                  (arg, data, length, am_flags),
                  void *arg, void *data, size_t length, unsigned am_flags)
 {
-    ucg_worker_h worker           = (ucg_worker_h)arg;
-    ucg_builtin_header_t *header  = data;
-    ucg_builtin_comp_slot_t *slot = NULL;
-    ucg_group_id_t group_id       = header->group_id;
+    ucg_worker_h worker               = (ucg_worker_h)arg;
+    ucg_builtin_header_t *header      = data;
+    ucg_builtin_slot_window_t *window = NULL;
+    ucg_group_id_t group_id           = header->group_id;
     ucs_assert(length >= sizeof(header));
 
-    slot = ucg_builtin_get_slot(worker, group_id);
-    if (slot == NULL) {
-        slot = ucg_builtin_set_slot(worker, group_id, NULL);
-        if (slot == NULL) {
+    window = ucg_builtin_get_slot(worker, group_id);
+    if (window == NULL) {
+        window = ucg_builtin_set_slot(worker, group_id, NULL);
+        if (window == NULL) {
             ucs_fatal("Message abandoned, collection operation cannot be performed.");
         }
     }
 
-    return ucg_builtin_am_process(&slot[header->coll_id % UCG_BUILTIN_MAX_CONCURRENT_OPS], data, length, am_flags);
+    return ucg_builtin_am_process(ucg_builtin_window_slot(window, header->coll_id), data, length, am_flags);
 }
 
 void ucg_builtin_msg_dump(ucp_worker_h worker, uct_am_trace_type_t type,
@@ -475,7 +734,30 @@ static ucs_status_t ucg_builtin_init_plan_config(ucg_plan_component_t *plan_comp
     ucg_builtin_config_t *config = (ucg_builtin_config_t*)plan_component->plan_config;
     config->cache_size = CACHE_SIZE;
     config->pipelining = 0;
-    config->recursive.factor = RECURSIVE_FACTOR;
+
+    /* Recursive k-ing requires a radix bigger than 1, and no more than the cached radix slots */
+    if (config->recursive.factor <= 1 || config->recursive.factor > UCG_BUILTIN_RECURSIVE_MAX_FACTOR) {
+        ucs_info("recursive factor %u is out of range, switch to default %u",
+                 config->recursive.factor, RECURSIVE_FACTOR);
+        config->recursive.factor = RECURSIVE_FACTOR;
+    }
+    if (config->recursive.max_factor > UCG_BUILTIN_RECURSIVE_MAX_FACTOR) {
+        config->recursive.max_factor = UCG_BUILTIN_RECURSIVE_MAX_FACTOR;
+    }
+
+    /* Dissemination barrier signals at least one peer per round */
+    if (config->dissemination_radix == 0) {
+        config->dissemination_radix = DEFAULT_DISSEMINATION_RADIX;
+    }
+
+    ucg_builtin_reduce_init(config->native_reduce);
+
+    if (config->max_rails == 0) {
+        config->max_rails = 1;
+    } else if (config->max_rails > UCG_BUILTIN_MAX_RAILS) {
+        ucs_info("max rails %u is too large, using %u", config->max_rails, UCG_BUILTIN_MAX_RAILS);
+        config->max_rails = UCG_BUILTIN_MAX_RAILS;
+    }
 
     /* K-nomial tree algorithm require all K value is bigger than 1 */
     if (config->bmtree.degree_inter_fanout <= 1 || config->bmtree.degree_inter_fanin <= 1 ||
@@ -496,6 +778,9 @@ static ucs_status_t ucg_builtin_init_plan_config(ucg_plan_component_t *plan_comp
     return UCS_OK;
 }
 
+static void ucg_builtin_async_add(ucg_builtin_group_ctx_t *gctx, ucg_worker_h worker);
+static void ucg_builtin_rpool_add(ucg_builtin_group_ctx_t *gctx, ucg_worker_h worker);
+
 static ucs_status_t ucg_builtin_create(ucg_plan_component_t *plan_component,
                                        ucg_worker_h worker,
                                        ucg_group_h group,
@@ -515,9 +800,24 @@ static ucs_status_t ucg_builtin_create(ucg_plan_component_t *plan_component,
     gctx->am_id                   = base_am_id;
     ucs_list_head_init(&gctx->send_head);
     ucs_list_head_init(&gctx->plan_head);
+    ucg_builtin_scratch_init(&gctx->scratch);
+    ucg_builtin_rcache_init(&gctx->rcache, gctx->config->reg_cache);
+    ucg_builtin_metrics_init(&gctx->metrics, gctx->config->metrics, gctx->config->metrics_signal,
+                             gctx->config->metrics_file);
+    if ((gctx->config->trace_file[0] != '\0') && !ucg_builtin_trace_enable) {
+        /* the first group decides the rank of the timeline */
+        ucg_builtin_trace_init(gctx->config->trace_file, gctx->config->trace_events,
+                               (group_params->mpi_global_idx_f != NULL) ?
+                               group_params->mpi_global_idx_f(group_params->cb_group_obj,
+                                                              group_params->member_index) :
+                               group_params->member_index);
+    }
+    gctx->zcopy_eager_cnt = 0;
+    gctx->async           = NULL;
+    gctx->rpool           = NULL;
 
-    gctx->slots = ucg_builtin_set_slot(worker, group_id, group_am_mp);
-    if (gctx->slots == NULL) {
+    gctx->window = ucg_builtin_set_slot(worker, group_id, group_am_mp);
+    if (gctx->window == NULL) {
         return UCS_ERR_NO_RESOURCE;
     }
 
@@ -526,7 +826,14 @@ static ucs_status_t ucg_builtin_create(ucg_plan_component_t *plan_component,
         return UCS_ERR_NO_MEMORY;
     }
 
-    return ucg_builtin_init_plan_config(plan_component);
+    ucs_status_t status = ucg_builtin_init_plan_config(plan_component);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    ucg_builtin_async_add(gctx, worker);
+    ucg_builtin_rpool_add(gctx, worker);
+    return UCS_OK;
 }
 
 static void ucg_builtin_clean_phases(ucg_builtin_plan_t *plan)
@@ -536,6 +843,7 @@ static void ucg_builtin_clean_phases(ucg_builtin_plan_t *plan)
         ucg_builtin_free((void **)&plan->phss[i].recv_cache_buffer);
         ucg_builtin_free((void **)&plan->phss[i].ucp_eps);
         ucg_builtin_free((void **)&plan->phss[i].ep_thresh);
+        ucg_builtin_free((void **)&plan->phss[i].rails);
     }
 
 #if ENABLE_DEBUG_DATA
@@ -584,43 +892,114 @@ ucs_status_t ucg_builtin_destroy_plan(ucg_builtin_plan_t *plan, ucg_group_h grou
 static void ucg_builtin_destroy(ucg_group_h group)
 {
     ucg_builtin_group_ctx_t *gctx = UCG_GROUP_TO_COMPONENT_CTX(ucg_builtin_component, group);
-    unsigned i;
+    ucg_builtin_plan_t *plan, *tmp_plan;
+    ucs_status_t status;
+    unsigned i, bucket;
+
+    if (gctx->async != NULL) {
+        ucs_list_del(&gctx->async_list);
+        gctx->async = NULL;
+    }
 
     ucg_builtin_pcache_destroy(group);
 
-    for (i = 0; i < UCG_BUILTIN_MAX_CONCURRENT_OPS; i++) {
-        if (gctx->slots[i].cb != NULL) {
+    if (!ucs_queue_is_empty(&gctx->window->waiting)) {
+        ucs_debug("Collective operations waiting for a slot have been left (Group #%u)", gctx->group_id);
+        while (!ucs_queue_is_empty(&gctx->window->waiting)) {
+            ucg_builtin_op_cancel_wait(ucs_queue_pull_elem_non_empty(&gctx->window->waiting,
+                                                                     ucg_builtin_op_t, queue));
+        }
+    }
+    gctx->window->is_grow = 0;
+
+    for (i = 0; i <= gctx->window->mask; i++) {
+        ucg_builtin_comp_slot_t *slot = &gctx->window->slots[i];
+        if (slot->cb != NULL) {
             ucs_debug("Collective operation #%u has been left incomplete (Group #%u)",
-                      gctx->slots[i].coll_id, gctx->group_id);
+                      slot->coll_id, gctx->group_id);
         }
 
-        while (!ucs_list_is_empty(&gctx->slots[i].msg_head)) {
-            ucg_builtin_comp_desc_t *desc =
-                    ucs_list_extract_head(&gctx->slots[i].msg_head,
-                                          ucg_builtin_comp_desc_t, super.tag_list[0]);
-            ucs_debug("Collective operation #%u has %u bytes left pending for step #%u (Group #%u)",
-                      desc->header.coll_id, desc->super.length, desc->header.step_idx, desc->header.group_id);
-            desc->release(desc);
-            desc = NULL;
+        for (bucket = 0; bucket < UCG_BUILTIN_MSG_BUCKETS; bucket++) {
+            while (!ucs_list_is_empty(&slot->msg_head[bucket])) {
+                ucg_builtin_comp_desc_t *desc =
+                        ucs_list_extract_head(&slot->msg_head[bucket],
+                                              ucg_builtin_comp_desc_t, super.tag_list[0]);
+                ucs_debug("Collective operation #%u has %u bytes left pending for step #%u (Group #%u)",
+                          desc->header.coll_id, desc->super.length, desc->header.step_idx, desc->header.group_id);
+                desc->release(desc);
+                desc = NULL;
+            }
         }
+        slot->msg_cnt = 0;
     }
 
-    while (!ucs_list_is_empty(&gctx->plan_head)) {
-        ucg_builtin_plan_t *plan = ucs_list_head(&gctx->plan_head,
-                                                 ucg_builtin_plan_t, list);
-        ucs_status_t status = ucg_builtin_destroy_plan(plan, group);
+    /* a plan that fails to go away is left behind, the rest of the group is still released */
+    ucs_list_for_each_safe(plan, tmp_plan, &gctx->plan_head, list) {
+        status = ucg_builtin_destroy_plan(plan, group);
         if (ucs_unlikely(status != UCS_OK)) {
-            return;
+            ucs_error("failed to destroy plan %p of group #%u: %s", plan, gctx->group_id,
+                      ucs_status_string(status));
         }
     }
+    ucs_list_head_init(&gctx->plan_head);
+
+    ucg_builtin_metrics_dump(&gctx->metrics, gctx->group_id);
+    ucg_builtin_metrics_cleanup(&gctx->metrics);
+    ucg_builtin_rcache_cleanup(&gctx->rcache);
+    ucg_builtin_scratch_cleanup(&gctx->scratch);
+}
+
+static int ucg_builtin_is_idle(ucg_builtin_group_ctx_t *gctx)
+{
+    unsigned i;
+
+    if (!ucs_list_is_empty(&gctx->send_head)) {
+        return 0;
+    }
+
+    for (i = 0; i <= gctx->window->mask; i++) {
+        if (gctx->window->slots[i].cb != NULL) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Operations wait for their slot in order. While the window is due to grow,
+ * the waiting ones are held back until the operations in flight complete.
+ */
+static unsigned ucg_builtin_progress_window(ucg_builtin_group_ctx_t *gctx)
+{
+    ucg_builtin_slot_window_t *window = gctx->window;
+
+    if (window->is_grow) {
+        if (!ucg_builtin_is_idle(gctx)) {
+            return 0;
+        }
+        window->is_grow = 0;
+        (void) ucg_builtin_grow_window(window);
+    }
+
+    return ucg_builtin_window_progress(window);
 }
 
 static unsigned ucg_builtin_progress(ucg_group_h group)
 {
     ucg_builtin_group_ctx_t *gctx =
             UCG_GROUP_TO_COMPONENT_CTX(ucg_builtin_component, group);
+    unsigned ret = 0;
+
+    if (ucs_unlikely(ucg_builtin_metrics_is_signaled(&gctx->metrics))) {
+        ucg_builtin_metrics_dump(&gctx->metrics, gctx->group_id);
+    }
+
+    if (ucs_unlikely(!ucs_queue_is_empty(&gctx->window->waiting))) {
+        ret += ucg_builtin_progress_window(gctx);
+    }
+
     if (ucs_likely(ucs_list_is_empty(&gctx->send_head))) {
-        return 0;
+        return ret;
     }
 
     /*
@@ -628,7 +1007,6 @@ static unsigned ucg_builtin_progress(ucg_group_h group)
      * the same list again, the list of pending sends is moved to a temporary
      * head, then drained - each call "resets" the state of that operation.
      */
-    unsigned ret = 0;
     UCS_LIST_HEAD(temp_head);
     ucs_list_splice_tail(&temp_head, &gctx->send_head);
     ucs_list_head_init(&gctx->send_head);
@@ -643,6 +1021,195 @@ static unsigned ucg_builtin_progress(ucg_group_h group)
     return ret;
 }
 
+#if ENABLE_MT
+static void *ucg_builtin_async_thread(void *arg)
+{
+    ucg_builtin_async_t *async = (ucg_builtin_async_t*)arg;
+    ucg_builtin_group_ctx_t *gctx;
+    unsigned count;
+    int is_active;
+
+    while (!async->is_stop) {
+        count     = 0;
+        is_active = 0;
+
+        UCP_WORKER_THREAD_CS_ENTER_CONDITIONAL(async->worker);
+        ucs_list_for_each(gctx, &async->groups, async_list) {
+            count     += ucg_group_progress_locked(gctx->group);
+            is_active |= !ucg_builtin_is_idle(gctx) || !ucs_queue_is_empty(&gctx->window->waiting);
+        }
+        UCP_WORKER_THREAD_CS_EXIT_CONDITIONAL(async->worker);
+        async->pass_cnt++;
+
+        if (is_active) {
+            if ((count == 0) && (async->interval != 0)) {
+                usleep(async->interval);
+            } else if (count == 0) {
+                sched_yield();
+            }
+            continue;
+        }
+
+        pthread_mutex_lock(&async->lock);
+        while (!async->is_kicked && !async->is_stop) {
+            async->sleep_cnt++;
+            pthread_cond_wait(&async->cond, &async->lock);
+        }
+        async->is_kicked = 0;
+        pthread_mutex_unlock(&async->lock);
+    }
+
+    return NULL;
+}
+#endif
+
+/* Starts the progress thread of the worker with its first group */
+static void ucg_builtin_async_add(ucg_builtin_group_ctx_t *gctx, ucg_worker_h worker)
+{
+    ucg_builtin_ctx_t *ctx = ucg_builtin_get_ctx(worker);
+
+    if (!gctx->config->async_progress || (ctx == NULL)) {
+        return;
+    }
+
+#if ENABLE_MT
+    if ((ctx->async == NULL) && !ctx->is_async_checked) {
+        ucp_worker_attr_t attr;
+        ucg_builtin_async_t *async;
+
+        ctx->is_async_checked = 1;
+        attr.field_mask       = UCP_WORKER_ATTR_FIELD_THREAD_MODE;
+        if ((ucp_worker_query(worker, &attr) != UCS_OK) || (attr.thread_mode != UCS_THREAD_MODE_MULTI)) {
+            ucs_warn("asynchronous progress requires a thread-multi worker, it is disabled");
+            return;
+        }
+
+        async = ucs_calloc(1, sizeof(*async), "ucg_builtin_async");
+        if (async == NULL) {
+            ucs_warn("no memory for the progress thread, asynchronous progress is disabled");
+            return;
+        }
+
+        async->worker   = worker;
+        async->interval = (unsigned long)(gctx->config->async_interval * UCS_USEC_PER_SEC);
+        ucs_list_head_init(&async->groups);
+        pthread_mutex_init(&async->lock, NULL);
+        pthread_cond_init(&async->cond, NULL);
+        if (pthread_create(&async->thread, NULL, ucg_builtin_async_thread, async) != 0) {
+            ucs_warn("failed to create the progress thread, asynchronous progress is disabled");
+            pthread_cond_destroy(&async->cond);
+            pthread_mutex_destroy(&async->lock);
+            ucs_free(async);
+            return;
+        }
+
+        ucs_debug("progress thread started for worker %p", worker);
+        ctx->async = async;
+    }
+
+    if (ctx->async != NULL) {
+        gctx->async = ctx->async;
+        ucs_list_add_tail(&ctx->async->groups, &gctx->async_list);
+    }
+#else
+    if (!ctx->is_async_checked) {
+        ctx->is_async_checked = 1;
+        ucs_warn("asynchronous progress requires a multi-threaded build, it is disabled");
+    }
+#endif
+}
+
+void ucg_builtin_async_kick(ucg_builtin_async_t *async)
+{
+#if ENABLE_MT
+    pthread_mutex_lock(&async->lock);
+    async->is_kicked = 1;
+    pthread_cond_signal(&async->cond);
+    pthread_mutex_unlock(&async->lock);
+#endif
+}
+
+/* Starts the reduction threads of the worker with its first group */
+static void ucg_builtin_rpool_add(ucg_builtin_group_ctx_t *gctx, ucg_worker_h worker)
+{
+    ucg_builtin_ctx_t *ctx = ucg_builtin_get_ctx(worker);
+    ucs_status_t status;
+
+    if ((gctx->config->reduce_threads == 0) || (ctx == NULL)) {
+        return;
+    }
+
+    if ((ctx->rpool == NULL) && !ctx->is_rpool_checked) {
+        ctx->is_rpool_checked = 1;
+        status = ucg_builtin_rpool_create(gctx->config->reduce_threads, &ctx->rpool);
+        if (status != UCS_OK) {
+            ucs_warn("failed to start the reduction threads: %s, reductions are not split",
+                     ucs_status_string(status));
+            ctx->rpool = NULL;
+        }
+    }
+
+    gctx->rpool = ctx->rpool;
+}
+
+static void ucg_builtin_async_stop(ucg_worker_h worker, ucg_builtin_ctx_t *ctx)
+{
+#if ENABLE_MT
+    ucg_builtin_async_t *async;
+
+    if (ctx->async == NULL) {
+        return;
+    }
+
+    async = ctx->async;
+    pthread_mutex_lock(&async->lock);
+    async->is_stop = 1;
+    pthread_cond_signal(&async->cond);
+    pthread_mutex_unlock(&async->lock);
+    pthread_join(async->thread, NULL);
+
+    ucs_debug("progress thread of worker %p: %lu passes, %lu sleeps",
+              worker, async->pass_cnt, async->sleep_cnt);
+    pthread_cond_destroy(&async->cond);
+    pthread_mutex_destroy(&async->lock);
+    ucs_free(async);
+    ctx->async            = NULL;
+    ctx->is_async_checked = 0;
+#endif
+}
+
+static void ucg_builtin_worker_cleanup(ucg_worker_h worker)
+{
+    ucg_builtin_ctx_t *ctx = *(ucg_builtin_ctx_t**)UCG_WORKER_TO_COMPONENT_CTX(ucg_builtin_component, worker);
+    unsigned chunk_idx, window_idx;
+
+    if (ctx == NULL) {
+        return;
+    }
+
+    ucg_builtin_async_stop(worker, ctx);
+    ucg_builtin_trace_write();
+
+    for (chunk_idx = 0; chunk_idx < UCG_BUILTIN_WINDOW_CHUNKS; chunk_idx++) {
+        if (ctx->chunks[chunk_idx] == NULL) {
+            continue;
+        }
+        for (window_idx = 0; window_idx < UCG_BUILTIN_WINDOW_CHUNK_SIZE; window_idx++) {
+            if (ctx->chunks[chunk_idx][window_idx] != NULL) {
+                ucg_builtin_free_window(ctx->chunks[chunk_idx][window_idx]);
+            }
+        }
+        ucs_free(ctx->chunks[chunk_idx]);
+        ctx->chunks[chunk_idx] = NULL;
+    }
+
+    if (ctx->rpool != NULL) {
+        ucg_builtin_rpool_destroy(ctx->rpool);
+        ctx->rpool = NULL;
+    }
+    ctx->is_rpool_checked = 0;
+}
+
 ucs_mpool_ops_t ucg_builtin_plan_mpool_ops = {
     .chunk_alloc   = ucs_mpool_hugetlb_malloc,
     .chunk_release = ucs_mpool_hugetlb_free,
@@ -680,6 +1247,7 @@ static void ucg_builtin_init_algo(struct ucg_builtin_algorithm *algo)
     algo->inc          = 0;
     algo->ladd         = 0;
     algo->plummer      = 0;
+    algo->sparse       = 0;
 }
 
 void ucg_builtin_bcast_algo_switch(const enum ucg_builtin_bcast_algorithm bcast_algo_decision,
@@ -765,6 +1333,17 @@ void ucg_builtin_barrier_algo_switch(const enum ucg_builtin_barrier_algorithm ba
             ucg_builtin_fillin_algo(algo, 0, 0, 0, 0, 1, 0, 1, 0);
             algo->topo_level = UCG_GROUP_HIERARCHY_LEVEL_NODE;
             break;
+        case UCG_ALGORITHM_BARRIER_DISSEMINATION:
+            ucg_builtin_fillin_algo(algo, 0, 0, 0, 0, 0, 0, 0, 0);
+            algo->feature_flag |= UCG_ALGORITHM_SUPPORT_RANK_FEATURE;
+            algo->feature_flag |= UCG_ALGORITHM_SUPPORT_BIND_TO_NONE;
+            break;
+        case UCG_ALGORITHM_BARRIER_NODE_AWARE_DISSEMINATION:
+            ucg_builtin_fillin_algo(algo, 0, 0, 0, 0, 1, 0, 0, 0);
+            algo->topo_level = UCG_GROUP_HIERARCHY_LEVEL_NODE;
+            algo->feature_flag |= UCG_ALGORITHM_SUPPORT_RANK_FEATURE;
+            algo->feature_flag |= UCG_ALGORITHM_SUPPORT_BIND_TO_NONE;
+            break;
         default:
             ucg_builtin_barrier_algo_switch(UCG_ALGORITHM_BARRIER_NODE_AWARE_KMTREE, algo);
             break;
@@ -864,6 +1443,10 @@ void ucg_builtin_alltoallv_algo_switch(const enum ucg_builtin_alltoallv_algorith
             ucg_builtin_fillin_algo(algo, 0, 0, 0, 0, 1, 0, 0, 0);
             algo->plummer = 1;
             break;
+        case UCG_ALGORITHM_ALLTOALLV_SPARSE:
+            ucg_builtin_fillin_algo(algo, 0, 0, 0, 0, 0, 0, 0, 0);
+            algo->sparse = 1;
+            break;
         default:
             ucg_builtin_alltoallv_algo_switch(UCG_ALGORITHM_ALLTOALLV_LADD, algo);
             break;
@@ -941,18 +1524,19 @@ int ucg_builtin_op_can_reuse(const ucg_plan_t *plan, const ucg_op_t *op,
     return 1;
 }
 
-static ucs_status_t ucg_builtin_step_md_mem_rereg(ucg_builtin_op_step_t *step)
+/* A cached region still valid is found again; one whose memory was released was invalidated meanwhile */
+static ucs_status_t ucg_builtin_step_md_mem_rereg(ucg_builtin_rcache_t *rcache, ucg_builtin_op_step_t *step)
 {
     ucs_status_t ret = UCS_OK;
 
     if ((step->uct_md != NULL) && (step->zcopy.memh != NULL)) {
-        ret = uct_md_mem_dereg(step->uct_md, step->zcopy.memh);
-        if (ret != UCS_OK) {
-            return ret;
-        }
+        ucg_builtin_rcache_dereg(rcache, step->uct_md, step->zcopy.memh, step->zcopy.region);
+        step->zcopy.memh   = NULL;
+        step->zcopy.region = NULL;
 
-        ret = uct_md_mem_reg(step->uct_md, step->send_buffer, step->buffer_length, UCT_MD_MEM_ACCESS_ALL,
-            &step->zcopy.memh);
+        ret = ucg_builtin_rcache_reg(rcache, step->uct_md, step->send_buffer,
+                                     (step->non_contig.iov != NULL) ? step->non_contig.span : step->buffer_length,
+                                     &step->zcopy.memh, &step->zcopy.region);
         if (ret != UCS_OK) {
             return ret;
         }
@@ -969,7 +1553,7 @@ ucs_status_t ucg_builtin_op_md_mem_rereg(ucg_op_t *op)
     if (builtin_op->steps != NULL) {
         ucg_builtin_op_step_t *step = &builtin_op->steps[0];
         do {
-            ret = ucg_builtin_step_md_mem_rereg(step);
+            ret = ucg_builtin_step_md_mem_rereg(builtin_op->rcache, step);
             if (ret != UCS_OK) {
                 return ret;
             }
@@ -981,10 +1565,10 @@ ucs_status_t ucg_builtin_op_md_mem_rereg(ucg_op_t *op)
 
 void ucg_builtin_log_algo()
 {
-    ucs_info("bmtree %u kmtree %u kmtree_intra %u recur %u bruck %u topo %u "
-             "level %u ring %u pipe %u nap %u binary_block %u ladd %u plummer %u ",ucg_algo.bmtree, ucg_algo.kmtree,
+    ucs_debug("bmtree %u kmtree %u kmtree_intra %u recur %u bruck %u topo %u "
+             "level %u ring %u pipe %u nap %u binary_block %u ladd %u plummer %u sparse %u ",ucg_algo.bmtree, ucg_algo.kmtree,
              ucg_algo.kmtree_intra, ucg_algo.recursive, ucg_algo.bruck, ucg_algo.topo, (unsigned)ucg_algo.topo_level,
-             ucg_algo.ring, ucg_algo.pipeline, ucg_algo.NAP, ucg_algo.binary_block, ucg_algo.ladd, ucg_algo.plummer);
+             ucg_algo.ring, ucg_algo.pipeline, ucg_algo.NAP, ucg_algo.binary_block, ucg_algo.ladd, ucg_algo.plummer, ucg_algo.sparse);
 }
 
 static void ucg_builtin_plan_create(ucg_builtin_plan_t *plan,
@@ -995,7 +1579,7 @@ static void ucg_builtin_plan_create(ucg_builtin_plan_t *plan,
     plan->convert_f = builtin_ctx->group_params->mpi_dt_convert;
     plan->dtspan_f = builtin_ctx->group_params->mpi_datatype_span;
     plan->resend = &builtin_ctx->send_head;
-    plan->slots = &builtin_ctx->slots[0];
+    plan->window = builtin_ctx->window;
     plan->am_id = builtin_ctx->am_id;
 }
 
@@ -1068,6 +1652,7 @@ static ucs_status_t ucg_builtin_plan(ucg_group_h group, int algo_id,
     ucs_list_add_head(&builtin_ctx->plan_head, &plan->list);
     ucg_builtin_plan_create(plan, plan_topo_type, coll_params, builtin_ctx);
     plan->ucg_algo = ucg_algo;
+    plan->algo_id  = algo_id;
     *plan_p         = (ucg_plan_t*)plan;
     return UCS_OK;
 }
@@ -1097,6 +1682,97 @@ STATIC_GTEST void  ucg_builtin_set_phase_thresh_max_short(ucg_builtin_group_ctx_
     phase->send_thresh.max_short_one -= phase->send_thresh.max_short_one % DATATYPE_ALIGN;
 }
 
+/* A single, cold registration: repeating it would only measure the memory domain's own cache */
+static double ucg_builtin_zcopy_eager_reg_nsec(uct_md_h md, void *buffer, size_t length)
+{
+    ucs_time_t start = ucs_get_time();
+    uct_mem_h memh;
+
+    if (uct_md_mem_reg(md, buffer, length, UCT_MD_MEM_ACCESS_ALL, &memh) != UCS_OK) {
+        return -1.0;
+    }
+    (void) uct_md_mem_dereg(md, memh);
+    return ucs_time_to_nsec(ucs_get_time() - start);
+}
+
+static double ucg_builtin_zcopy_eager_copy_nsec(void *dst, const void *src, size_t length)
+{
+    double best = -1.0;
+    ucs_time_t start;
+    double nsec;
+    unsigned iter;
+
+    for (iter = 0; iter < ZCOPY_EAGER_SAMPLE_ITER; iter++) {
+        start = ucs_get_time();
+        memcpy(dst, src, length);
+        nsec = ucs_time_to_nsec(ucs_get_time() - start);
+        best = ((best < 0) || (nsec < best)) ? nsec : best;
+    }
+
+    return best;
+}
+
+/*
+ * Registration costs a fixed part plus a part per byte, copying only the latter.
+ * The crossover is where the copy catches up with the registration, SIZE_MAX if
+ * it never does. The measure is local, so it may only change how a sender sends
+ * each fragment, never the fragmentation the receiver expects.
+ */
+static size_t ucg_builtin_zcopy_eager_measure(uct_md_h md)
+{
+    size_t crossover = SIZE_MAX;
+    double reg_min, reg_max, copy_max, reg_per_byte, reg_fixed, copy_per_byte;
+    size_t length = 2 * ZCOPY_EAGER_SAMPLE_MAX + ZCOPY_EAGER_SAMPLE_MIN; /* disjoint samples */
+    int8_t *buffer = ucs_malloc(length, "zcopy eager sample");
+
+    if (buffer == NULL) {
+        return crossover;
+    }
+    memset(buffer, 0, length);
+
+    reg_min  = ucg_builtin_zcopy_eager_reg_nsec(md, buffer + 2 * ZCOPY_EAGER_SAMPLE_MAX, ZCOPY_EAGER_SAMPLE_MIN);
+    reg_max  = ucg_builtin_zcopy_eager_reg_nsec(md, buffer, ZCOPY_EAGER_SAMPLE_MAX);
+    copy_max = ucg_builtin_zcopy_eager_copy_nsec(buffer + ZCOPY_EAGER_SAMPLE_MAX, buffer, ZCOPY_EAGER_SAMPLE_MAX);
+    ucs_free(buffer);
+    if ((reg_min < 0) || (reg_max < 0)) {
+        return crossover;
+    }
+
+    reg_per_byte  = ucs_max(reg_max - reg_min, 0.0) / (ZCOPY_EAGER_SAMPLE_MAX - ZCOPY_EAGER_SAMPLE_MIN);
+    copy_per_byte = copy_max / ZCOPY_EAGER_SAMPLE_MAX;
+    reg_fixed     = ucs_max(reg_min - reg_per_byte * ZCOPY_EAGER_SAMPLE_MIN, 0.0);
+    if (copy_per_byte > reg_per_byte) {
+        crossover = (size_t)(reg_fixed / (copy_per_byte - reg_per_byte));
+    }
+
+    ucs_debug("md %p: register %.0f/%.0f ns at %d/%d bytes, copy %.0f ns, zcopy from %zu bytes",
+              md, reg_min, reg_max, ZCOPY_EAGER_SAMPLE_MIN, ZCOPY_EAGER_SAMPLE_MAX, copy_max, crossover);
+    return crossover;
+}
+
+static size_t ucg_builtin_zcopy_eager_thresh(ucg_builtin_group_ctx_t *ctx, uct_md_h md)
+{
+    unsigned idx;
+
+    if (ctx->config->zcopy_eager_thresh != UCS_MEMUNITS_AUTO) {
+        return ctx->config->zcopy_eager_thresh;
+    }
+
+    for (idx = 0; idx < ctx->zcopy_eager_cnt; idx++) {
+        if (ctx->zcopy_eager[idx].md == md) {
+            return ctx->zcopy_eager[idx].crossover;
+        }
+    }
+
+    if (ctx->zcopy_eager_cnt == UCG_BUILTIN_RCACHE_MAX_MDS) {
+        return ucg_builtin_zcopy_eager_measure(md);
+    }
+
+    ctx->zcopy_eager[ctx->zcopy_eager_cnt].md        = md;
+    ctx->zcopy_eager[ctx->zcopy_eager_cnt].crossover = ucg_builtin_zcopy_eager_measure(md);
+    return ctx->zcopy_eager[ctx->zcopy_eager_cnt++].crossover;
+}
+
 void  ucg_builtin_set_phase_thresh_max_bcopy_zcopy(ucg_builtin_group_ctx_t *ctx,
                                                    ucg_builtin_plan_phase_t *phase)
 {
@@ -1113,6 +1789,17 @@ void  ucg_builtin_set_phase_thresh_max_bcopy_zcopy(ucg_builtin_group_ctx_t *ctx,
 
     phase->send_thresh.max_bcopy_one -= phase->send_thresh.max_bcopy_one % DATATYPE_ALIGN;
     phase->send_thresh.max_zcopy_one -= phase->send_thresh.max_zcopy_one % DATATYPE_ALIGN;
+
+    /* the receiver reads registered memory, so rendezvous needs the same as zcopy plus RMA get */
+    phase->send_thresh.rndv_thresh = ((phase->ep_attr->cap.flags & UCT_IFACE_FLAG_GET_ZCOPY) &&
+                                      (phase->md_attr->cap.flags & UCT_MD_FLAG_NEED_MEMH)) ?
+                                     ctx->config->rndv_thresh : SIZE_MAX;
+
+    /* bcopy fragments sent by zcopy must fit in a single zcopy message */
+    phase->send_thresh.zcopy_eager = ((phase->md_attr->cap.flags & UCT_MD_FLAG_NEED_MEMH) &&
+                                      (phase->ep_attr->cap.flags & UCT_IFACE_FLAG_AM_ZCOPY) &&
+                                      (phase->send_thresh.max_bcopy_one <= phase->send_thresh.max_zcopy_one)) ?
+                                     ucg_builtin_zcopy_eager_thresh(ctx, phase->md) : SIZE_MAX;
 }
 
 void  ucg_builtin_set_phase_thresholds(ucg_builtin_group_ctx_t *ctx,
@@ -1133,12 +1820,78 @@ void  ucg_builtin_set_phase_thresholds(ucg_builtin_group_ctx_t *ctx,
 
 void ucg_builtin_log_phase_info(ucg_builtin_plan_phase_t *phase, ucg_group_member_index_t idx)
 {
-    ucs_info("phase create: %p, dest %" PRIu64 ", short_one %zu, short_max %zu,"
+    ucs_debug("phase create: %p, dest %" PRIu64 ", short_one %zu, short_max %zu,"
              "bcopy_one %zu, bcopy_max %zu, zcopy_one %zu, max_reg %zu", phase, idx, phase->send_thresh.max_short_one,
               phase->send_thresh.max_short_max, phase->send_thresh.max_bcopy_one, phase->send_thresh.max_bcopy_max,
               phase->send_thresh.max_zcopy_one, phase->md_attr->cap.max_reg);
 }
 
+/*
+ * Find the other interfaces leading to the same peer. A rail is only used if it
+ * can carry the fragments sized for the main interface.
+ */
+static ucs_status_t ucg_builtin_connect_rails(ucg_builtin_group_ctx_t *ctx, ucg_builtin_plan_phase_t *phase,
+                                              uct_ep_h ep, ucp_ep_h ucp_ep, unsigned rails_index,
+                                              unsigned alloc_cnt)
+{
+    uct_ep_h eps[UCG_BUILTIN_MAX_RAILS];
+    uct_md_h mds[UCG_BUILTIN_MAX_RAILS];
+    const uct_iface_attr_t *attrs[UCG_BUILTIN_MAX_RAILS];
+    double bandwidths[UCG_BUILTIN_MAX_RAILS];
+    double min_bandwidth;
+    unsigned rail_cnt, rail_idx;
+    ucg_builtin_rails_t *rails;
+
+    ucs_status_t status = ucg_plan_connect_rails(ctx->group, ucp_ep, ctx->config->max_rails,
+                                                 eps, mds, attrs, bandwidths, &rail_cnt);
+    if ((status != UCS_OK) || (rail_cnt <= 1) || (eps[0] != ep)) {
+        return status;
+    }
+
+    if (phase->rails == NULL) {
+        phase->rails = ucs_calloc(alloc_cnt, sizeof(ucg_builtin_rails_t), "ucg rails");
+        if (phase->rails == NULL) {
+            return UCS_ERR_NO_MEMORY;
+        }
+        phase->rails_cnt       = alloc_cnt;
+        phase->rail_stripe_min = ctx->config->rail_stripe_min;
+    }
+
+    if (rails_index >= phase->rails_cnt) {
+        return UCS_OK;
+    }
+
+    rails          = &phase->rails[rails_index];
+    rails->main_ep = ep;
+    rails->cnt     = 0;
+    min_bandwidth  = bandwidths[0];
+    for (rail_idx = 0; rail_idx < rail_cnt; rail_idx++) {
+        if ((attrs[rail_idx]->cap.am.max_bcopy < attrs[0]->cap.am.max_bcopy) ||
+            (attrs[rail_idx]->cap.am.max_zcopy < attrs[0]->cap.am.max_zcopy)) {
+            continue;
+        }
+        rails->eps[rails->cnt]  = eps[rail_idx];
+        rails->mds[rails->cnt]  = mds[rail_idx];
+        bandwidths[rails->cnt]  = bandwidths[rail_idx];
+        min_bandwidth           = ucs_min(min_bandwidth, bandwidths[rail_idx]);
+        rails->cnt++;
+    }
+
+    /* weights are the bandwidth relative to the slowest rail, 1 for round-robin */
+    rails->weight_sum = 0;
+    for (rail_idx = 0; rail_idx < rails->cnt; rail_idx++) {
+        rails->weights[rail_idx] = 1;
+        if (ctx->config->rail_weighted && (min_bandwidth > 0)) {
+            rails->weights[rail_idx] = ucs_min(ucs_max((unsigned)(bandwidths[rail_idx] / min_bandwidth + 0.5), 1),
+                                               UCG_BUILTIN_MAX_RAILS);
+        }
+        rails->weight_sum += rails->weights[rail_idx];
+    }
+
+    ucs_debug("phase %p ep %p striped over %u rails", phase, ep, rails->cnt);
+    return UCS_OK;
+}
+
 ucs_status_t ucg_builtin_connect(ucg_builtin_group_ctx_t *ctx,
                                  ucg_group_member_index_t idx, ucg_builtin_plan_phase_t *phase,
                                  unsigned phase_ep_index)
@@ -1193,6 +1946,13 @@ ucs_status_t ucg_builtin_connect(ucg_builtin_group_ctx_t *ctx,
     phase->ep_thresh[(phase_ep_index != UCG_BUILTIN_CONNECT_SINGLE_EP) ? phase_ep_index : 0] = phase->send_thresh;
     ucg_builtin_log_phase_info(phase, idx);
 
+    /* Stripe large fragments over the other interfaces leading to this peer */
+    if (ctx->config->max_rails > 1) {
+        status = ucg_builtin_connect_rails(ctx, phase, ep, ucp_ep,
+                                           (phase_ep_index != UCG_BUILTIN_CONNECT_SINGLE_EP) ? phase_ep_index : 0,
+                                           ucs_max(phase->ep_cnt, 1));
+    }
+
     return status;
 }
 
@@ -1218,10 +1978,60 @@ int ucg_is_allreduce_consistency(const ucg_builtin_group_ctx_t *ctx)
     return ctx->config->reduce_consistency;
 }
 
+ucg_builtin_scratch_t *ucg_builtin_group_scratch(ucg_builtin_group_ctx_t *ctx)
+{
+    return &ctx->scratch;
+}
+
+ucg_builtin_rcache_t *ucg_builtin_group_rcache(ucg_builtin_group_ctx_t *ctx)
+{
+    return &ctx->rcache;
+}
+
+ucg_builtin_async_t *ucg_builtin_group_async(ucg_builtin_group_ctx_t *ctx)
+{
+    return ctx->async;
+}
+
+ucg_builtin_rpool_t *ucg_builtin_group_rpool(ucg_builtin_group_ctx_t *ctx)
+{
+    return ctx->rpool;
+}
+
+ucg_builtin_metrics_t *ucg_builtin_group_metrics(ucg_builtin_group_ctx_t *ctx)
+{
+    return &ctx->metrics;
+}
+
+unsigned ucg_builtin_group_metrics_query(ucg_group_h group, ucg_collective_metrics_t *metrics, unsigned max)
+{
+    ucg_builtin_group_ctx_t *gctx = UCG_GROUP_TO_COMPONENT_CTX(ucg_builtin_component, group);
+    return ucg_builtin_metrics_query(&gctx->metrics, metrics, max);
+}
+
+void ucg_builtin_group_metrics_print(ucg_group_h group, FILE *stream)
+{
+    ucg_builtin_group_ctx_t *gctx = UCG_GROUP_TO_COMPONENT_CTX(ucg_builtin_component, group);
+    ucg_builtin_metrics_print(&gctx->metrics, gctx->group_id, stream);
+}
+
+static double ucg_builtin_wait_spin_time(ucg_group_h group)
+{
+    return ((const ucg_builtin_config_t*)ucg_builtin_component.plan_config)->wait_spin_time;
+}
+
+static int ucg_builtin_group_can_block(ucg_group_h group)
+{
+    ucg_builtin_group_ctx_t *gctx = UCG_GROUP_TO_COMPONENT_CTX(ucg_builtin_component, group);
+    return ucs_list_is_empty(&gctx->send_head);
+}
+
 UCG_PLAN_COMPONENT_DEFINE(ucg_builtin_component, "builtin",
                           sizeof(ucg_builtin_group_ctx_t), ucg_builtin_query,
                           ucg_builtin_create, ucg_builtin_destroy,
-                          ucg_builtin_progress, ucg_builtin_plan,
-                          ucg_builtin_op_create, ucg_builtin_op_trigger,
-                          ucg_builtin_op_discard, ucg_builtin_print, "BUILTIN_",
+                          ucg_builtin_worker_cleanup, ucg_builtin_wait_spin_time,
+                          ucg_builtin_group_can_block, ucg_builtin_progress,
+                          ucg_builtin_plan, ucg_builtin_op_create,
+                          ucg_builtin_op_trigger, ucg_builtin_op_discard,
+                          ucg_builtin_print, "BUILTIN_",
                           ucg_builtin_config_table, ucg_builtin_config_t);
@@ -20,9 +20,19 @@
  */
 
 mpi_reduce_f ucg_builtin_mpi_reduce_cb;
-static UCS_F_ALWAYS_INLINE void ucg_builtin_mpi_reduce(void *mpi_op,
+static UCS_F_ALWAYS_INLINE void ucg_builtin_mpi_reduce(const ucg_builtin_op_t *op, void *mpi_op,
         const void *src, void *dst, unsigned dcount, void* mpi_datatype)
 {
+    /* predefined operations and datatypes are reduced natively */
+    if (ucs_likely(op->reduce_kernel != NULL)) {
+        if (ucs_unlikely(dcount >= op->rpool_min_cnt)) {
+            ucg_builtin_rpool_reduce(op->rpool, op->reduce_kernel, src, dst, dcount, op->rpool_dt_len);
+            return;
+        }
+        op->reduce_kernel(src, dst, dcount);
+        return;
+    }
+
     UCS_PROFILE_CALL_VOID(ucg_builtin_mpi_reduce_cb, mpi_op, (char*)src,
             (char*)dst, dcount, mpi_datatype);
 }
@@ -47,8 +57,14 @@ void ucg_builtin_mpi_reduce_full(ucg_builtin_request_t *req, size_t offset, cons
             ucs_info("mpi_reduce_full, dt_len is 0");
             return;
         }
+        if (req->op->reduce_strided_kernel != NULL) {
+            ucg_builtin_reduce_strided(req->op, data,
+                                       req->step->recv_buffer + (offset / dt_len) * params->recv.dt_len,
+                                       params->recv.count, dt_len, params->recv.dt_len);
+            return;
+        }
         dsize = req->op->dtspan_f(params->recv.dt_ext, params->recv.count, &gap);
-        reduce_buf = (char *)ucs_malloc(dsize, "temp full reduce buffer");
+        reduce_buf = (char *)ucg_builtin_scratch_get(req->op->scratch, dsize);
         if (reduce_buf == NULL) {
             ucs_fatal("no memory for malloc, dsize:%lu", dsize);
         }
@@ -62,12 +78,82 @@ void ucg_builtin_mpi_reduce_full(ucg_builtin_request_t *req, size_t offset, cons
     ucs_assert(length == (params->recv.count * dt_len));
     ucs_debug("mpi_reduce_full, data:%p, length:%lu, recv_buffer:%p, offset:%lu, dt_len:%lu",
               data, length, req->step->recv_buffer, offset, dt_len);
-    ucg_builtin_mpi_reduce(params->recv.op_ext, data, req->step->recv_buffer + offset,
+    ucg_builtin_mpi_reduce(req->op, params->recv.op_ext, data, req->step->recv_buffer + offset,
                            params->recv.count, params->recv.dt_ext);
 
     if (reduce_buf != NULL) {
-        ucs_free(reduce_buf);
+        ucg_builtin_scratch_put(req->op->scratch, reduce_buf, dsize);
+    }
+}
+
+/*
+ * Reduce the children of a tree node in the order of their position (rank order),
+ * so the result is bitwise reproducible. The offset carries the position of the
+ * child. A child is reduced as soon as all the positions before it have been
+ * reduced; only children arriving ahead of their turn are held in reduce_buff.
+ * Fragmented children send their position times the length plus the fragment
+ * offset, and a child takes its turn once all its fragments are in its slot.
+ */
+static void ucg_builtin_mpi_reduce_ordered(ucg_builtin_request_t *req, size_t offset, const void *data,
+                                           size_t length, ucg_collective_params_t *params)
+{
+    ucg_builtin_op_step_t *step = req->step;
+    char *slot;
+    unsigned count;
+    uint32_t pos;
+
+    if (step->rbuf_frags != NULL) {
+        pos  = offset / step->buffer_length;
+        slot = (char *)step->reduce_buff + pos * step->buffer_length;
+        if (ucs_unlikely((pos >= step->rbuf_count) ||
+                         ((offset % step->buffer_length) + length > step->buffer_length))) {
+            ucs_fatal("Illegal fragment offset:%lu length:%zu, method:%u", offset, length,
+                      (int)step->phase->method);
+        }
+
+        memcpy(slot + (offset % step->buffer_length), data, length);
+        if (++step->rbuf_frags[pos] < step->fragments_recv) {
+            return;
+        }
+
+        step->rbuf_frags[pos] = 0;
+        offset                = pos;
+        data                  = slot;
+        length                = step->buffer_length;
+    }
+
+    count = length / params->recv.dt_len;
+    if (ucs_unlikely(offset >= step->rbuf_count)) {
+        ucs_fatal("Illegal offset:%lu, method:%u", offset, (int)step->phase->method);
+    } else if (offset != step->rbuf_next) {
+        slot = (char *)step->reduce_buff + offset * length;
+        if (data != slot) {
+            memcpy(slot, data, length);
+        }
+        step->rbuf_held[offset] = 1;
+    } else {
+        ucg_builtin_mpi_reduce(req->op, params->recv.op_ext, data, step->recv_buffer, count, params->recv.dt_ext);
+        step->rbuf_next++;
+        while ((step->rbuf_next < step->rbuf_count) && step->rbuf_held[step->rbuf_next]) {
+            ucg_builtin_mpi_reduce(req->op, params->recv.op_ext, (char *)step->reduce_buff + step->rbuf_next * length,
+                                   step->recv_buffer, count, params->recv.dt_ext);
+            step->rbuf_held[step->rbuf_next++] = 0;
+        }
+    }
+
+    if (req->pending > 1) {
+        return;
+    }
+
+    /* last child: nothing should be held unless a position was skipped */
+    for (pos = step->rbuf_next; pos < step->rbuf_count; pos++) {
+        if (step->rbuf_held[pos]) {
+            ucg_builtin_mpi_reduce(req->op, params->recv.op_ext, (char *)step->reduce_buff + pos * length,
+                                   step->recv_buffer, count, params->recv.dt_ext);
+            step->rbuf_held[pos] = 0;
+        }
     }
+    step->rbuf_next = 0;
 }
 
 void ucg_builtin_mpi_reduce_partial(ucg_builtin_request_t *req, size_t offset, const void *data,
@@ -92,8 +178,14 @@ void ucg_builtin_mpi_reduce_partial(ucg_builtin_request_t *req, size_t offset, c
             return;
         }
         count = length / dt_len;
+        if (req->op->reduce_strided_kernel != NULL) {
+            ucg_builtin_reduce_strided(req->op, data,
+                                       req->step->recv_buffer + (offset / dt_len) * params->recv.dt_len,
+                                       count, dt_len, params->recv.dt_len);
+            return;
+        }
         dsize = req->op->dtspan_f(params->recv.dt_ext, count, &gap);
-        reduce_buf = (char *)ucs_malloc(dsize, "temp partial reduce buffer");
+        reduce_buf = (char *)ucg_builtin_scratch_get(req->op->scratch, dsize);
         if (reduce_buf == NULL) {
             ucs_fatal("no memory for malloc, dsize:%lu", dsize);
         }
@@ -102,11 +194,11 @@ void ucg_builtin_mpi_reduce_partial(ucg_builtin_request_t *req, size_t offset, c
         gen_dt->ops.finish(gen_state);
         data = reduce_buf - gap;
         offset = (offset / dt_len) * params->recv.dt_len;
-        ucg_builtin_mpi_reduce(params->recv.op_ext, data, req->step->recv_buffer + offset, length / dt_len,
+        ucg_builtin_mpi_reduce(req->op, params->recv.op_ext, data, req->step->recv_buffer + offset, length / dt_len,
             params->recv.dt_ext);
 
         if (reduce_buf != NULL) {
-            ucs_free(reduce_buf);
+            ucg_builtin_scratch_put(req->op->scratch, reduce_buf, dsize);
         }
 
         return;
@@ -117,35 +209,19 @@ void ucg_builtin_mpi_reduce_partial(ucg_builtin_request_t *req, size_t offset, c
         && req->step->phase->method != UCG_PLAN_METHOD_REDUCE_WAYPOINT) {
         ucs_debug("mpi_reduce_partial, data:%p, length:%lu, recv_buffer:%p, offset:%lu, dt_len:%lu", data, length,
             req->step->recv_buffer, offset, dt_len);
-        ucg_builtin_mpi_reduce(params->recv.op_ext, data, req->step->recv_buffer + offset,
+        ucg_builtin_mpi_reduce(req->op, params->recv.op_ext, data, req->step->recv_buffer + offset,
                                length / dt_len, params->recv.dt_ext);
         return;
     }
 
-    /* fragmented message not support reduce data buffer */
+    /* without REDUCE_CONSISTENCY, or too long to give every child its slot */
     if (req->step->reduce_buff == NULL) {
-        ucg_builtin_mpi_reduce(params->recv.op_ext, data, req->step->recv_buffer + offset,
+        ucg_builtin_mpi_reduce(req->op, params->recv.op_ext, data, req->step->recv_buffer + offset,
                            length / dt_len, params->recv.dt_ext);
         return;
     }
 
-    if (offset > req->step->rbuf_count) {
-        ucs_error("Illegal offset:%lu, method:%u", offset, (int)req->step->phase->method);
-        return;
-    }
-
-    int tLen = offset * length;
-    memcpy((char *)req->step->reduce_buff + tLen, data, length);
-    if (req->pending > 1) {
-        return;
-    }
-
-    uint32_t loop = 0;
-    while (loop < req->step->rbuf_count) {
-        ucg_builtin_mpi_reduce(params->recv.op_ext, (char *)req->step->reduce_buff + loop * length,
-                               req->step->recv_buffer, length / dt_len, params->recv.dt_ext);
-        loop++;
-    }
+    ucg_builtin_mpi_reduce_ordered(req, offset, data, length, params);
 }
 static UCS_F_ALWAYS_INLINE void ucg_builtin_comp_last_step_cb(ucg_builtin_request_t *req, ucs_status_t status)
 {
@@ -166,6 +242,8 @@ static UCS_F_ALWAYS_INLINE void ucg_builtin_comp_last_step_cb(ucg_builtin_reques
     }
 
     /* Mark request as complete */
+    ucg_builtin_metrics_complete(req->op, status);
+    UCG_BUILTIN_TRACE_STEP(UCG_BUILTIN_TRACE_COMPLETE, req->step, (uint64_t)(int64_t)status);
     req->comp_req->status = status;
     req->comp_req->flags |= UCP_REQUEST_FLAG_COMPLETED;
     UCS_PROFILE_REQUEST_EVENT(req, "complete_coll", 0);
@@ -195,6 +273,7 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_comp_step_cb(ucg_builtin_req
     /* Mark (per-group) slot as available */
     ucg_builtin_comp_slot_t *slot = ucs_container_of(req, ucg_builtin_comp_slot_t, req);
     slot->cb = NULL;
+    UCG_BUILTIN_TRACE_STEP(UCG_BUILTIN_TRACE_STEP_DONE, req->step, 0);
 
     /* Start on the next step for this collective operation */
     ucg_builtin_op_step_t *next_step = ++req->step;
@@ -285,10 +364,18 @@ static UCS_F_ALWAYS_INLINE void ucg_builtin_comp_zcopy_check_cb(ucg_builtin_requ
     }
 }
 
+/* Rendezvous reads may land the data in place, leaving nothing to copy */
+static UCS_F_ALWAYS_INLINE void ucg_builtin_comp_recv_copy(void *dst, const void *data, size_t length)
+{
+    if (ucs_likely(dst != data)) {
+        memcpy(dst, data, length);
+    }
+}
+
 static int ucg_builtin_comp_recv_one_cb(ucg_builtin_request_t *req,
     uint64_t offset, const void *data, size_t length)
 {
-    memcpy(req->step->recv_buffer, data, length);
+    ucg_builtin_comp_recv_copy(req->step->recv_buffer, data, length);
     (void) ucg_builtin_comp_step_cb(req, NULL);
     return 1;
 }
@@ -322,7 +409,7 @@ static int ucg_builtin_comp_recv_noncontig_one_cb(ucg_builtin_request_t *req,
 static int ucg_builtin_comp_recv_one_then_send_cb(ucg_builtin_request_t *req,
     uint64_t offset, const void *data, size_t length)
 {
-    memcpy(req->step->recv_buffer, data, length);
+    ucg_builtin_comp_recv_copy(req->step->recv_buffer, data, length);
     req->recv_comp = 1;
     (void) ucg_builtin_step_execute(req, NULL);
     return 1;
@@ -341,7 +428,7 @@ static int ucg_builtin_comp_recv_noncontig_one_then_send_cb(ucg_builtin_request_
 static int ucg_builtin_comp_recv_many_cb(ucg_builtin_request_t *req,
     uint64_t offset, const void *data, size_t length)
 {
-    memcpy(req->step->recv_buffer + offset, data, length);
+    ucg_builtin_comp_recv_copy(req->step->recv_buffer + offset, data, length);
     return ucg_builtin_comp_step_check_cb(req);
 }
 
@@ -387,7 +474,7 @@ static int ucg_builtin_comp_recv_noncontig_many_then_send_pipe_cb(ucg_builtin_re
 static int ucg_builtin_comp_recv_many_then_send_cb(ucg_builtin_request_t *req,
     uint64_t offset, const void *data, size_t length)
 {
-    memcpy(req->step->recv_buffer + offset, data, length);
+    ucg_builtin_comp_recv_copy(req->step->recv_buffer + offset, data, length);
     if (req->pending == 1) {
         req->recv_comp = 1;
     }
@@ -446,7 +533,7 @@ UCS_PROFILE_FUNC(int, ucg_builtin_comp_reduce_full_cb, (req, offset, data, lengt
         size_t total_length = params->recv.count * dt_len;
 
         if (gen_dt != NULL && req->step->phase->is_swap) {
-            tmp_buffer = (char *)ucs_malloc(total_length, "temp swap buffer");
+            tmp_buffer = (char *)ucg_builtin_scratch_get(req->op->scratch, total_length);
             if (tmp_buffer == NULL) {
                 ucs_fatal("no memory for malloc, total_length:%lu", total_length);
             }
@@ -454,7 +541,7 @@ UCS_PROFILE_FUNC(int, ucg_builtin_comp_reduce_full_cb, (req, offset, data, lengt
             memcpy(tmp_buffer, netdata, total_length);
             gen_dt->ops.pack(state_pack, 0, netdata, total_length);
             gen_dt->ops.unpack(state_unpack, 0, tmp_buffer, total_length);
-            ucs_free(tmp_buffer);
+            ucg_builtin_scratch_put(req->op->scratch, tmp_buffer, total_length);
         }
 
         ucg_builtin_mpi_reduce_full(req, 0, netdata, total_length, params);
@@ -483,7 +570,7 @@ static int ucg_builtin_comp_reduce_full_then_send_cb(ucg_builtin_request_t *req,
     memcpy(req->step->phase->recv_cache_buffer + offset, data, length);
 
     if (req->pending == 1) {
-        ucg_builtin_mpi_reduce(req->op->super.params.recv.op_ext,
+        ucg_builtin_mpi_reduce(req->op, req->op->super.params.recv.op_ext,
                             req->step->phase->recv_cache_buffer, req->step->recv_buffer,
                             req->op->super.params.recv.count,  req->op->super.params.recv.dt_ext);
     }
@@ -663,6 +750,11 @@ static ucs_status_t ucg_builtin_step_select_callbacks(ucg_builtin_plan_phase_t *
             }
             break;
 
+        case UCG_PLAN_METHOD_DISSEMINATION:
+            /* zero-byte signals, only the count of arrivals matters */
+            *recv_cb = is_single_ep ? ucg_builtin_comp_wait_one_cb : ucg_builtin_comp_wait_many_cb;
+            break;
+
         default:
             ucs_error("Invalid method for a collective operation.");
             return UCS_ERR_INVALID_PARAM;
@@ -694,9 +786,11 @@ static void ucg_builtin_send_alltoall(ucg_builtin_request_t *req)
     size_t len = req->step->buf_len_unit;
     ucg_builtin_op_step_t *step = req->step;
     size_t buffer_length_discrete = 0;
+    /* not num_procs, which is set on the thread creating the operation */
+    unsigned member_cnt = (unsigned)ucg_group_get_params(req->op->super.plan->group)->member_count;
     if (step->displs_rule == UCG_BUILTIN_OP_STEP_DISPLS_RULE_BRUCK_ALLTOALL) {
         k = (unsigned)step->am_header.step_idx;
-        for (i = 0; i < num_procs; i++) {
+        for (i = 0; i < member_cnt; i++) {
             if ((i >> k) & 1) { //kth bit is 1
                 memcpy(step->send_buffer + buffer_length_discrete * len,
                     step->recv_buffer + i * len, len);
@@ -793,13 +887,14 @@ void ucg_builtin_plummer_gather_send_counts_cb(ucg_builtin_request_t *req)
     if (step->phase->ex_attr.is_node_leader) {
         unsigned ppn = step->phase->ex_attr.ppn;
         size_t buffer_size = ppn * step->buf_len_unit;
-        step->recv_buffer = (int8_t *)ucs_malloc(buffer_size, "allocate gather send counts buffers");
+        step->recv_buffer = (int8_t *)ucg_builtin_scratch_get(req->op->scratch, buffer_size);
         if (step->recv_buffer == NULL) {
             ucs_fatal("no memory for malloc, buffer_size: %lu", buffer_size);
         }
         unsigned local_index = step->phase->ex_attr.recv_start_block;
         memcpy(step->recv_buffer + local_index * step->buf_len_unit, step->send_buffer, step->buf_len_unit);
         req->op->temp_data_buffer = step->recv_buffer; /* Save for next step use */
+        req->op->temp_data_length = buffer_size;
         /* single ep remote offset = 0 */
         if ( step->phase->ep_cnt == 1) {
             step->recv_buffer += step->buf_len_unit;
@@ -843,10 +938,11 @@ void ucg_builtin_plummer_gather_send_buffers_cb(ucg_builtin_request_t *req)
         PLUMMER_CHECK_DATA_SIZE(dt_len, total_recv_count);
 
         size_t total_recv_buffer = total_recv_count * dt_len;
-        req->op->temp_exchange_buffer = (int8_t *)ucs_malloc(total_recv_buffer, "allocate send buffer");
+        req->op->temp_exchange_buffer = (int8_t *)ucg_builtin_scratch_get(req->op->scratch, total_recv_buffer);
         if (req->op->temp_exchange_buffer== NULL) {
             ucs_fatal("no memory for malloc, total_recv_buffer: %lu", total_recv_buffer);
         }
+        req->op->temp_exchange_length = total_recv_buffer;
         ucg_builtin_plummer_memory_gather(req->op->temp_exchange_buffer, init_send_buf, params->send.counts, params->send.displs, dt_len, member_cnt);
 
         recv_coll_params->init_buf = req->op->temp_exchange_buffer;
@@ -854,10 +950,12 @@ void ucg_builtin_plummer_gather_send_buffers_cb(ucg_builtin_request_t *req)
         send_coll_params->init_buf = params->send.buf == MPI_IN_PLACE ? (int8_t *)params->recv.buf
                                                                   : (int8_t *)params->send.buf;
         int total_send_count = ucg_builtin_plummer_sum(params->send.counts, member_cnt);
-        req->op->temp_exchange_buffer = (int8_t *)ucs_malloc(total_send_count * dt_len, "allocate send buffer");
+        req->op->temp_exchange_buffer = (int8_t *)ucg_builtin_scratch_get(req->op->scratch,
+                                                                          total_send_count * dt_len);
         if (req->op->temp_exchange_buffer == NULL) {
             ucs_fatal("no memory for malloc, total_send_buffer:%lu", total_send_count * dt_len);
         }
+        req->op->temp_exchange_length = total_send_count * dt_len;
 
         ucg_builtin_plummer_memory_gather(req->op->temp_exchange_buffer, send_coll_params->init_buf,
             params->send.counts, params->send.displs, dt_len, member_cnt);
@@ -870,7 +968,7 @@ void ucg_builtin_plummer_gather_send_buffers_cb(ucg_builtin_request_t *req)
         step->send_buffer = send_coll_params->init_buf;
         step->buffer_length = send_coll_params->counts[0] * dt_len;
         
-        status = ucg_builtin_step_alloc_pack_rank_buffer(step, send_coll_params->counts[0] * dt_len);
+        status = ucg_builtin_step_alloc_pack_rank_buffer(step, req->op->scratch, send_coll_params->counts[0] * dt_len);
         if (status!= UCS_OK) {
             req->plummer_req_status = status;
         }
@@ -883,13 +981,14 @@ void ucg_builtin_plummer_gather_recv_counts_cb(ucg_builtin_request_t *req)
     if (step->phase->ex_attr.is_node_leader) {
         unsigned ppn = step->phase->ex_attr.ppn;
         size_t buffer_size = ppn * step->buf_len_unit;
-        step->recv_buffer = (int8_t *)ucs_malloc(buffer_size, "allocate gather send counts buffers");
+        step->recv_buffer = (int8_t *)ucg_builtin_scratch_get(req->op->scratch, buffer_size);
         if (step->recv_buffer == NULL) {
             ucs_fatal("no memory for malloc, buffer_size: %lu", buffer_size);
         }
         unsigned local_index = step->phase->ex_attr.recv_start_block;
         memcpy(step->recv_buffer + local_index * step->buf_len_unit, step->send_buffer, step->buf_len_unit);
         req->op->temp_data_buffer1 = step->recv_buffer; /* Save the buffer for future use. */
+        req->op->temp_data_length1 = buffer_size;
         /* single ep remote offset = 0 */
         if ( step->phase->ep_cnt == 1) {
             step->recv_buffer += step->buf_len_unit;
@@ -936,7 +1035,7 @@ void ucg_builtin_plummer_inter_alltoallv_cb(ucg_builtin_request_t *req)
     }
 
     /* init send and recv buffer, memory redistribution */
-    int *temp_send_displs = (int *)ucs_malloc(counter * sizeof(int), "allocate temp displs");
+    int *temp_send_displs = (int *)ucg_builtin_scratch_get(op->scratch, counter * sizeof(int));
     if (temp_send_displs == NULL) {
         ucs_fatal("no memory for malloc, counter_size: %lu", counter * sizeof(int));
     }
@@ -950,14 +1049,14 @@ void ucg_builtin_plummer_inter_alltoallv_cb(ucg_builtin_request_t *req)
         send_coll_params->counts[node_cnt-1]+send_coll_params->displs[node_cnt-1]);
     if (status != UCS_OK) {
         req->plummer_req_status = status;
-        ucg_builtin_free((void **)&temp_send_displs);
+        ucg_builtin_scratch_put(op->scratch, temp_send_displs, counter * sizeof(int));
         return;
     }
 
     size_t send_buf_size = (send_coll_params->counts[node_cnt-1] + send_coll_params->displs[node_cnt-1]) * send_dt_len;
-    send_coll_params->init_buf = (int8_t *)ucs_malloc(send_buf_size, "allocate init buffer");
+    send_coll_params->init_buf = (int8_t *)ucg_builtin_scratch_get(op->scratch, send_buf_size);
     if (send_coll_params->init_buf == NULL) {
-        ucg_builtin_free((void **)&temp_send_displs);
+        ucg_builtin_scratch_put(op->scratch, temp_send_displs, counter * sizeof(int));
         ucs_fatal("no memory for malloc, send_buf_size: %lu", send_buf_size);
     }
 
@@ -977,14 +1076,14 @@ void ucg_builtin_plummer_inter_alltoallv_cb(ucg_builtin_request_t *req)
             }
         }
     }
-    ucg_builtin_free((void **)&temp_send_displs);
+    ucg_builtin_scratch_put(op->scratch, temp_send_displs, counter * sizeof(int));
 
     PLUMMER_CHECK_DATA_SIZE(send_dt_len, (recv_coll_params->counts[node_cnt-1]+recv_coll_params->displs[node_cnt-1]));
 
     size_t recv_buf_size = (recv_coll_params->counts[node_cnt-1] + recv_coll_params->displs[node_cnt-1]) * send_dt_len;
-    recv_coll_params->init_buf = (int8_t *)ucs_malloc(recv_buf_size, "allocate init buffer");
+    recv_coll_params->init_buf = (int8_t *)ucg_builtin_scratch_get(op->scratch, recv_buf_size);
     if (recv_coll_params->init_buf == NULL) {
-        ucg_builtin_free((void **)&send_coll_params->init_buf);
+        ucg_builtin_scratch_put(op->scratch, send_coll_params->init_buf, send_buf_size);
         ucs_fatal("no memory for malloc, recv_buf_size: %lu", recv_buf_size);
     }
 
@@ -995,9 +1094,11 @@ void ucg_builtin_plummer_inter_alltoallv_cb(ucg_builtin_request_t *req)
            send_coll_params->counts[local_index]*send_dt_len);
 
     /* release old buffers, use redistribute buffer */
-    ucg_builtin_free((void **)&op->temp_exchange_buffer);
+    ucg_builtin_scratch_put(op->scratch, op->temp_exchange_buffer, op->temp_exchange_length);
     op->temp_exchange_buffer = send_coll_params->init_buf;
+    op->temp_exchange_length = send_buf_size;
     op->temp_exchange_buffer1 = recv_coll_params->init_buf;
+    op->temp_exchange_length1 = recv_buf_size;
     step->send_buffer = send_coll_params->init_buf;
 
     unsigned send_start_block = phase->ex_attr.start_block;
@@ -1013,7 +1114,7 @@ void ucg_builtin_plummer_inter_alltoallv_cb(ucg_builtin_request_t *req)
     }
     phase_send_buffer_length *= send_dt_len;
 
-    status = ucg_builtin_step_alloc_pack_rank_buffer(step, phase_send_buffer_length);
+    status = ucg_builtin_step_alloc_pack_rank_buffer(step, op->scratch, phase_send_buffer_length);
     if (status != UCS_OK) {
         req->plummer_req_status = status;
         return;
@@ -1051,7 +1152,7 @@ void ucg_builtin_plummer_scatter_recv_buffers_cb(ucg_builtin_request_t *req)
 
         /* init send buffers, first memory redistribution */
         size_t member_cnt_size = member_cnt * sizeof(int);
-        int *temp_send_counts_new = (int *)ucs_malloc(member_cnt_size, "allocate temp displs");
+        int *temp_send_counts_new = (int *)ucg_builtin_scratch_get(req->op->scratch, member_cnt_size);
         if (temp_send_counts_new == NULL) {
             ucs_fatal("no memory for malloc, member_cnt_size: %lu", member_cnt_size);
         }
@@ -1068,9 +1169,9 @@ void ucg_builtin_plummer_scatter_recv_buffers_cb(ucg_builtin_request_t *req)
             }
         }
 
-        int *temp_send_displs_new = (int *)ucs_malloc(member_cnt_size, "allocate temp displs");
+        int *temp_send_displs_new = (int *)ucg_builtin_scratch_get(req->op->scratch, member_cnt_size);
         if (temp_send_displs_new == NULL) {
-            ucg_builtin_free((void **)&temp_send_counts_new);
+            ucg_builtin_scratch_put(req->op->scratch, temp_send_counts_new, member_cnt_size);
             ucs_fatal("no memory for malloc, member_cnt_size: %lu", member_cnt_size);
         }
         memset(temp_send_displs_new, 0, member_cnt_size);
@@ -1080,10 +1181,10 @@ void ucg_builtin_plummer_scatter_recv_buffers_cb(ucg_builtin_request_t *req)
         }
 
         size_t send_buf_size = (temp_send_counts_new[member_cnt-1] + temp_send_displs_new[member_cnt-1]) * send_dt_len;
-        send_coll_params->init_buf = (int8_t *)ucs_malloc(send_buf_size, "allocate init buffer");
+        send_coll_params->init_buf = (int8_t *)ucg_builtin_scratch_get(req->op->scratch, send_buf_size);
         if (send_coll_params->init_buf == NULL) {
-            ucg_builtin_free((void **)&temp_send_counts_new);
-            ucg_builtin_free((void **)&temp_send_displs_new);
+            ucg_builtin_scratch_put(req->op->scratch, temp_send_counts_new, member_cnt_size);
+            ucg_builtin_scratch_put(req->op->scratch, temp_send_displs_new, member_cnt_size);
             ucs_fatal("no memory for malloc, send_buf_size: %lu", send_buf_size);
         }
 
@@ -1099,11 +1200,12 @@ void ucg_builtin_plummer_scatter_recv_buffers_cb(ucg_builtin_request_t *req)
             }
         }
 
-        ucg_builtin_free((void **)&temp_send_counts_new);
-        ucg_builtin_free((void **)&temp_send_displs_new);
-        ucg_builtin_free((void **)&req->op->temp_exchange_buffer1);
+        ucg_builtin_scratch_put(req->op->scratch, temp_send_counts_new, member_cnt_size);
+        ucg_builtin_scratch_put(req->op->scratch, temp_send_displs_new, member_cnt_size);
+        ucg_builtin_scratch_put(req->op->scratch, req->op->temp_exchange_buffer1, req->op->temp_exchange_length1);
 
         req->op->temp_exchange_buffer1 = send_coll_params->init_buf;
+        req->op->temp_exchange_length1 = send_buf_size;
         ucg_builtin_plummer_memory_scatter((int8_t *)params->recv.buf, req->op->temp_exchange_buffer1,
             params->recv.counts, params->recv.displs, send_dt_len, member_cnt);
 
@@ -1119,20 +1221,23 @@ void ucg_builtin_plummer_scatter_recv_buffers_cb(ucg_builtin_request_t *req)
         }
         phase_send_buffer_length *= send_dt_len;
 
-        ucs_status_t status = ucg_builtin_step_alloc_pack_rank_buffer(step, phase_send_buffer_length);
+        ucs_status_t status = ucg_builtin_step_alloc_pack_rank_buffer(step, req->op->scratch,
+                                                                      phase_send_buffer_length);
         if (status != UCS_OK) {
             req->plummer_req_status = status;
         }
     } else {
         /* initialize recv coll parameters */
         int total_recv_count = ucg_builtin_plummer_sum(params->recv.counts, member_cnt);
-        recv_coll_params->init_buf = (int8_t *)ucs_malloc(total_recv_count * send_dt_len, "recv buffer");
+        recv_coll_params->init_buf = (int8_t *)ucg_builtin_scratch_get(req->op->scratch,
+                                                                       total_recv_count * send_dt_len);
         if (recv_coll_params->init_buf == NULL) {
             ucs_fatal("no memory for malloc, recv_buf_size:%lu", total_recv_count * send_dt_len);
         }
         recv_coll_params->counts[0] = total_recv_count;
         recv_coll_params->displs[0] = 0;
         req->op->temp_exchange_buffer1 = recv_coll_params->init_buf;
+        req->op->temp_exchange_length1 = total_recv_count * send_dt_len;
     }
 }
 
@@ -1270,15 +1375,16 @@ static void ucg_builtin_final_allgather(ucg_builtin_request_t *req)
     size_t len = req->step->buf_len_unit;
     size_t my_index   = req->op->super.plan->my_index;
     size_t len_move = len * (num_procs_count - my_index);
-    void *temp_buffer = ucs_calloc(1, len * (num_procs_count - 1), "ucg_allgather_final_step_buffer");
-    ucs_assert(temp_buffer != NULL);
+    void *temp_buffer = NULL;
+
     if (req->op->super.plan->my_index != 0) {
+        temp_buffer = ucg_builtin_scratch_get(req->op->scratch, len_move);
+        ucs_assert(temp_buffer != NULL);
         memcpy(temp_buffer, req->step->recv_buffer, len_move);
         memmove(req->step->recv_buffer, req->step->recv_buffer + len_move, len*my_index);
         memcpy(req->step->recv_buffer + len * my_index, temp_buffer, len_move);
+        ucg_builtin_scratch_put(req->op->scratch, temp_buffer, len_move);
     }
-    free(temp_buffer);
-    temp_buffer = NULL;
 }
 
 /* local inverse rotation for alltoall at final step */
@@ -1292,15 +1398,14 @@ static void ucg_builtin_final_alltoall(ucg_builtin_request_t *req)
     size_t dst;
     unsigned i;
     size_t len_move = len * num_procs_count;
-    int8_t *temp_buffer = (int8_t*)ucs_calloc(1, len * num_procs_count, "ucg_alltoall_final_step_buffer");
+    int8_t *temp_buffer = (int8_t*)ucg_builtin_scratch_get(req->op->scratch, len_move);
     ucs_assert(temp_buffer != NULL);
     for (i = 0; i < num_procs_count; i++) {
         dst = (my_index - i + num_procs_count) % num_procs_count;
         memcpy(temp_buffer + dst * len, req->step->recv_buffer + i * len, len);
     }
     memcpy(req->step->recv_buffer, temp_buffer, len_move);
-    free(temp_buffer);
-    temp_buffer = NULL;
+    ucg_builtin_scratch_put(req->op->scratch, temp_buffer, len_move);
 }
 
 static UCS_F_ALWAYS_INLINE void
@@ -1480,7 +1585,7 @@ void ucg_builtin_final_throttled_scatter(ucg_builtin_request_t *req)
     unsigned step_idx;
     for (step_idx = 0; step_idx < ((ucg_builtin_plan_t *)op->super.plan)->phs_cnt; step_idx++) {
         ucg_builtin_op_step_t *step = &(op->steps[step_idx]);
-        ucg_builtin_step_free_pack_rank_buffer(step);
+        ucg_builtin_step_free_pack_rank_buffer(step, op->scratch);
         ucg_builtin_free((void **)&step->send_coll_params);
         ucg_builtin_free((void **)&step->recv_coll_params);
     }
@@ -1513,14 +1618,21 @@ void ucg_builtin_throttled_scatter_alltoallv_cb(ucg_builtin_request_t *req)
     unsigned block_idx = send_start_block;
     unsigned phase_send_buffer_length = 0;
 
-    while (block_idx < (send_start_block + send_num_blocks)) {
-        unsigned real_block_idx = block_idx % member_cnt;
-        phase_send_buffer_length += step->send_coll_params->counts[real_block_idx];
-        block_idx++;
+    if (phase->ex_attr.sparse_blocks != NULL) {
+        /* only the blocks of the active send peers */
+        for (block_idx = 0; block_idx < phase->send_ep_cnt; block_idx++) {
+            phase_send_buffer_length += step->send_coll_params->counts[phase->ex_attr.sparse_blocks[block_idx]];
+        }
+    } else {
+        while (block_idx < (send_start_block + send_num_blocks)) {
+            unsigned real_block_idx = block_idx % member_cnt;
+            phase_send_buffer_length += step->send_coll_params->counts[real_block_idx];
+            block_idx++;
+        }
     }
     phase_send_buffer_length *= send_dt_len;
 
-    ucs_status_t status = ucg_builtin_step_alloc_pack_rank_buffer(step, phase_send_buffer_length);
+    ucs_status_t status = ucg_builtin_step_alloc_pack_rank_buffer(step, req->op->scratch, phase_send_buffer_length);
     if (status != UCS_OK) {
         req->ladd_req_status = status;
     }
@@ -1574,7 +1686,7 @@ void ucg_builtin_final_plummer(ucg_builtin_request_t *req)
     unsigned step_idx;
     for (step_idx = 0; step_idx < ((ucg_builtin_plan_t *)op->super.plan)->phs_cnt; step_idx++) {
         ucg_builtin_op_step_t *step = &(op->steps[step_idx]);
-        ucg_builtin_step_free_pack_rank_buffer(step);
+        ucg_builtin_step_free_pack_rank_buffer(step, op->scratch);
 
         if (step->phase->ex_attr.is_variable_len) {
             if (step->phase->send_ep_cnt > 0) {
@@ -1587,10 +1699,10 @@ void ucg_builtin_final_plummer(ucg_builtin_request_t *req)
         }
     }
 
-    ucg_builtin_free((void **)&(op->temp_data_buffer));
-    ucg_builtin_free((void **)&(op->temp_data_buffer1));
-    ucg_builtin_free((void **)&(op->temp_exchange_buffer));
-    ucg_builtin_free((void **)&(op->temp_exchange_buffer1));
+    ucg_builtin_scratch_release(op->scratch, &op->temp_data_buffer, &op->temp_data_length);
+    ucg_builtin_scratch_release(op->scratch, &op->temp_data_buffer1, &op->temp_data_length1);
+    ucg_builtin_scratch_release(op->scratch, &op->temp_exchange_buffer, &op->temp_exchange_length);
+    ucg_builtin_scratch_release(op->scratch, &op->temp_exchange_buffer1, &op->temp_exchange_length1);
 }
 
 
@@ -1712,11 +1824,12 @@ static void ucg_builtin_step_am_zcopy_comp_step_check_cb(uct_completion_t *self)
     }
 }
 
-static inline ucs_status_t ucg_builtin_step_zcopy_prep(ucg_builtin_op_step_t *step)
+static inline ucs_status_t ucg_builtin_step_zcopy_prep(ucg_builtin_op_step_t *step, ucg_builtin_rcache_t *rcache)
 {
     /* Allocate callback context for zero-copy sends */
     uint32_t zcomp_cnt         = step->phase->ep_cnt * step->fragments;
     step->zcopy.memh           = NULL; /* - in case the allocation fails... */
+    step->zcopy.region         = NULL;
     step->zcopy.num_store      = 0;
     ucg_builtin_zcomp_t *zcomp =
              step->zcopy.zcomp = (ucg_builtin_zcomp_t*)UCS_ALLOC_CHECK(zcomp_cnt *
@@ -1731,18 +1844,18 @@ static inline ucs_status_t ucg_builtin_step_zcopy_prep(ucg_builtin_op_step_t *st
     }
 
     /* Register the buffer, creating a memory handle used in zero-copy sends */
-    ucs_status_t status = uct_md_mem_reg(step->uct_md, step->send_buffer,
-            step->buffer_length, UCT_MD_MEM_ACCESS_ALL, &step->zcopy.memh);
+    ucs_status_t status = ucg_builtin_rcache_reg(rcache, step->uct_md, step->send_buffer,
+            step->buffer_length, &step->zcopy.memh, &step->zcopy.region);
     if (status != UCS_OK) {
         ucs_error("failed to register memory %p, length %ld", step->send_buffer, step->buffer_length);
-        ucs_free(zcomp);
-        zcomp = NULL;
+        ucg_builtin_free((void **)&step->zcopy.zcomp);
         return status;
     }
     return UCS_OK;
 }
 
-static inline ucs_status_t ucg_builtin_dynamic_zcopy_prep(ucg_builtin_op_step_t *step, unsigned ep_index)
+static inline ucs_status_t ucg_builtin_dynamic_zcopy_prep(ucg_builtin_op_step_t *step, unsigned ep_index,
+                                                           ucg_builtin_rcache_t *rcache)
 {
     /* Allocate callback context for zero-copy sends */
     ucg_builtin_zcopy_info_t *zcopy = &step->zcopys[ep_index];
@@ -1750,6 +1863,7 @@ static inline ucs_status_t ucg_builtin_dynamic_zcopy_prep(ucg_builtin_op_step_t
         uint32_t zcomp_cnt             = step->fragments;
         zcopy->zcopy_pending           = zcomp_cnt;
         zcopy->memh                    = NULL;  /* - in case the allocation fails... */
+        zcopy->region                  = NULL;
         zcopy->num_store               = 0;
         ucg_builtin_zcomp_t  *zcomp          =
                         zcopy->zcomp = (ucg_builtin_zcomp_t *)UCS_ALLOC_CHECK(zcomp_cnt *
@@ -1766,8 +1880,8 @@ static inline ucs_status_t ucg_builtin_dynamic_zcopy_prep(ucg_builtin_op_step_t
         }
 
         /* Register the buffer, creating a memory handle used in zero-copy sends */
-        ucs_status_t status = uct_md_mem_reg(zcopy->uct_md, step->send_buffer,
-            step->buffer_length, UCT_MD_MEM_ACCESS_ALL, &zcopy->memh);
+        ucs_status_t status = ucg_builtin_rcache_reg(rcache, zcopy->uct_md, step->send_buffer,
+            step->buffer_length, &zcopy->memh, &zcopy->region);
 
         if (status != UCS_OK) {
             ucs_error("failed to register memory %p, length %ld", step->send_buffer, step->buffer_length);
@@ -1777,6 +1891,7 @@ static inline ucs_status_t ucg_builtin_dynamic_zcopy_prep(ucg_builtin_op_step_t
 
         /* set "current" step->zcopy point to step->zcopys[ep_index] for sending */
         step->zcopy.memh = step->zcopys[ep_index].memh;
+        step->zcopy.region = step->zcopys[ep_index].region;
         step->zcopy.num_store = step->zcopys[ep_index].num_store;
         step->zcopy.zcomp = step->zcopys[ep_index].zcomp;
     }
@@ -1784,6 +1899,32 @@ static inline ucs_status_t ucg_builtin_dynamic_zcopy_prep(ucg_builtin_op_step_t
     return UCS_OK;
 }
 
+static inline int ucg_builtin_step_can_zcopy(const ucg_builtin_op_step_t *step)
+{
+    /* packed bcopy sends already make a single copy, into the transport */
+    return (step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_BCOPY) &&
+           !step->non_contig.is_pack &&
+           (step->phase->md_attr->cap.max_reg > step->buffer_length) &&
+           (step->phase->md_attr->cap.flags & UCT_MD_FLAG_NEED_MEMH) &&
+           (step->buffer_length != 0);
+}
+
+/* The fragmentation is kept, so the receivers are not affected */
+static ucs_status_t ucg_builtin_step_bcopy_to_zcopy(ucg_builtin_op_step_t *step, ucg_builtin_rcache_t *rcache)
+{
+    ucs_status_t status = ucg_builtin_step_zcopy_prep(step, rcache);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    step->flags &= ~UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_BCOPY;
+    step->flags |=  UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_ZCOPY;
+    if (step->recv_cb == ucg_builtin_comp_reduce_one_cb) {
+        step->recv_cb = ucg_builtin_comp_reduce_many_cb;
+    }
+    return UCS_OK;
+}
+
 static ucs_status_t ucg_builtin_optimize_bcopy_to_zcopy(ucg_builtin_op_t *op)
 {
     /* This function was called because we want to "upgrade" a bcopy-send to
@@ -1793,23 +1934,15 @@ static ucs_status_t ucg_builtin_optimize_bcopy_to_zcopy(ucg_builtin_op_t *op)
     ucg_step_idx_ext_t  step_idx = 0;
     do {
         step = &op->steps[step_idx++];
-        if ((step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_BCOPY) &&
-            (step->phase->md_attr->cap.max_reg > step->buffer_length) &&
-            (step->phase->md_attr->cap.flags & UCT_MD_FLAG_NEED_MEMH) &&
-            step->buffer_length != 0) {
-            status = ucg_builtin_step_zcopy_prep(step);
+        if (ucg_builtin_step_can_zcopy(step)) {
+            status = ucg_builtin_step_bcopy_to_zcopy(step, op->rcache);
             if (status != UCS_OK) {
                 goto bcopy_to_zcopy_cleanup;
             }
-
-            step->flags &= ~UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_BCOPY;
-            step->flags |=  UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_ZCOPY;
-            if (step->recv_cb == ucg_builtin_comp_reduce_one_cb) {
-                step->recv_cb = ucg_builtin_comp_reduce_many_cb;
-            }
         }
     } while (!(step->flags & UCG_BUILTIN_OP_STEP_FLAG_LAST_STEP));
 
+    UCG_BUILTIN_METRICS_INC(op, zcopy_promotions);
     return UCS_OK;
 
 bcopy_to_zcopy_cleanup:
@@ -1826,9 +1959,11 @@ static ucs_status_t ucg_builtin_no_optimization(ucg_builtin_op_t *op)
 
 /*
  * While some buffers are large enough to be registered (as in memory
- * registration) upon first send, others are "buffer-copied" (BCOPY) - unless
- * it is used repeatedly. If an operation is used this many times - its buffers
- * will also be registered, turning it into a zero-copy (ZCOPY) send henceforth.
+ * registration) upon first send, others are "buffer-copied" (BCOPY). Those
+ * past the phase's eager threshold, where copying costs more than registering,
+ * are registered right away. The others only if the operation is used
+ * repeatedly: after this many times, they are turned into zero-copy (ZCOPY)
+ * sends henceforth. Alltoallv registers each peer's block lazily when sending.
  */
 static ucs_status_t ucg_builtin_op_consider_optimization(ucg_builtin_op_t *op,
                                                          ucg_builtin_config_t *config)
@@ -1836,10 +1971,9 @@ static ucs_status_t ucg_builtin_op_consider_optimization(ucg_builtin_op_t *op,
     ucg_builtin_op_step_t *step = NULL;
     ucg_step_idx_ext_t  step_idx = 0;
     unsigned  opt_flag = config->bcopy_to_zcopy_opt;
+    int is_deferred = 0;
 
-    /* Currently, this function is shielded in the
-     * alltoallv scenario because the buffer length changes.
-     */
+    /* the buffer length of alltoallv changes per peer, see ucg_builtin_dynamic_send_recv() */
     if (op->steps[0].phase->method == UCG_PLAN_METHOD_ALLTOALLV_LADD) {
         opt_flag = 0;
     }
@@ -1847,16 +1981,23 @@ static ucs_status_t ucg_builtin_op_consider_optimization(ucg_builtin_op_t *op,
     if (opt_flag && !op->send_dt) {
         do {
             step = &op->steps[step_idx++];
-            if ((step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_BCOPY) &&
-                (step->phase->md_attr->cap.max_reg > step->buffer_length) &&
-                (step->phase->md_attr->cap.flags & UCT_MD_FLAG_NEED_MEMH)) {
-                op->optm_cb = ucg_builtin_optimize_bcopy_to_zcopy;
-                op->opt_cnt = config->mem_reg_opt_cnt;
-                return UCS_OK;
+            if (!ucg_builtin_step_can_zcopy(step)) {
+                continue;
+            }
+
+            if ((step->buffer_length < step->phase->send_thresh.zcopy_eager) ||
+                (ucg_builtin_step_bcopy_to_zcopy(step, op->rcache) != UCS_OK)) {
+                is_deferred = 1;
             }
         } while (!(step->flags & UCG_BUILTIN_OP_STEP_FLAG_LAST_STEP));
     }
 
+    if (is_deferred) {
+        op->optm_cb = ucg_builtin_optimize_bcopy_to_zcopy;
+        op->opt_cnt = config->mem_reg_opt_cnt;
+        return UCS_OK;
+    }
+
     /* Note: This function will be called... after opt_cnt wrap-around */
     op->optm_cb = ucg_builtin_no_optimization;
     op->opt_cnt = 0;
@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Latency histograms and counters of the collectives of a group
+ */
+
+#include <inttypes.h>
+#include <limits.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/math.h>
+#include <ucs/sys/string.h>
+#include <ucs/sys/sys.h>
+
+#include "builtin_ops.h"
+
+#define UCG_BUILTIN_METRICS_SUB_BITS 2 /* HDR-style: 4 buckets per power of two */
+
+static const char *ucg_builtin_metrics_coll_names[COLL_TYPE_NUMS] = {
+    [COLL_TYPE_BARRIER]   = "barrier",
+    [COLL_TYPE_BCAST]     = "bcast",
+    [COLL_TYPE_ALLREDUCE] = "allreduce",
+    [COLL_TYPE_ALLTOALLV] = "alltoallv"
+};
+
+static volatile sig_atomic_t ucg_builtin_metrics_signals = 0;
+static int ucg_builtin_metrics_signo                     = 0;
+
+static void ucg_builtin_metrics_signal_handler(int signo)
+{
+    ucg_builtin_metrics_signals++;
+}
+
+/* The handler only counts, each group prints itself from its own progress */
+static void ucg_builtin_metrics_signal_install(int signo)
+{
+    struct sigaction sigact;
+
+    if (ucg_builtin_metrics_signo == signo) {
+        return;
+    }
+
+    memset(&sigact, 0, sizeof(sigact));
+    sigact.sa_handler = ucg_builtin_metrics_signal_handler;
+    sigemptyset(&sigact.sa_mask);
+    sigact.sa_flags   = SA_RESTART;
+    if (sigaction(signo, &sigact, NULL) != 0) {
+        ucs_warn("failed to set the metrics handler of signal %d: %m", signo);
+        return;
+    }
+
+    ucg_builtin_metrics_signo = signo;
+}
+
+static UCS_F_ALWAYS_INLINE unsigned ucg_builtin_metrics_latency_bucket(uint64_t nsec)
+{
+    unsigned msb;
+
+    if (nsec < UCS_BIT(UCG_BUILTIN_METRICS_SUB_BITS)) {
+        return nsec;
+    }
+
+    msb = ucs_ilog2(nsec);
+    return ucs_min(((msb - UCG_BUILTIN_METRICS_SUB_BITS + 1) << UCG_BUILTIN_METRICS_SUB_BITS) +
+                   ((nsec >> (msb - UCG_BUILTIN_METRICS_SUB_BITS)) &
+                    UCS_MASK(UCG_BUILTIN_METRICS_SUB_BITS)),
+                   UCG_COLLECTIVE_METRICS_BUCKETS - 1);
+}
+
+uint64_t ucg_builtin_metrics_bucket_nsec(unsigned bucket)
+{
+    unsigned msb;
+
+    if (bucket < UCS_BIT(UCG_BUILTIN_METRICS_SUB_BITS)) {
+        return bucket;
+    }
+
+    msb = (bucket >> UCG_BUILTIN_METRICS_SUB_BITS) + UCG_BUILTIN_METRICS_SUB_BITS - 1;
+    return (UCS_BIT(UCG_BUILTIN_METRICS_SUB_BITS) | (bucket & UCS_MASK(UCG_BUILTIN_METRICS_SUB_BITS))) <<
+           (msb - UCG_BUILTIN_METRICS_SUB_BITS);
+}
+
+void ucg_builtin_metrics_init(ucg_builtin_metrics_t *metrics, int enable, int signo, const char *file)
+{
+    ucs_list_head_init(&metrics->entries);
+    metrics->entry_cnt  = 0;
+    metrics->enable     = enable;
+    metrics->file       = file;
+    metrics->signal_cnt = ucg_builtin_metrics_signals;
+
+    if (enable && (signo != 0)) {
+        ucg_builtin_metrics_signal_install(signo);
+    }
+}
+
+void ucg_builtin_metrics_cleanup(ucg_builtin_metrics_t *metrics)
+{
+    ucg_builtin_metrics_entry_t *entry, *tmp;
+
+    ucs_list_for_each_safe(entry, tmp, &metrics->entries, list) {
+        ucs_list_del(&entry->list);
+        ucs_free(entry);
+    }
+    metrics->entry_cnt = 0;
+}
+
+ucg_collective_metrics_t *ucg_builtin_metrics_get(ucg_builtin_metrics_t *metrics, coll_type_t coll_type,
+                                                  int algo, size_t length)
+{
+    unsigned size_log = (length == 0) ? 0 : (ucs_ilog2(length) + 1);
+    ucg_builtin_metrics_entry_t *entry;
+
+    if (!metrics->enable) {
+        return NULL;
+    }
+
+    ucs_list_for_each(entry, &metrics->entries, list) {
+        if ((entry->stats.coll_type == coll_type) && (entry->stats.algo == algo) &&
+            (entry->stats.size_log == size_log)) {
+            return &entry->stats;
+        }
+    }
+
+    /* without memory for a new record, the operation is simply not recorded */
+    entry = ucs_calloc(1, sizeof(*entry), "ucg_builtin_metrics_entry");
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    entry->stats.coll_type = coll_type;
+    entry->stats.algo      = algo;
+    entry->stats.size_log  = size_log;
+    ucs_list_add_tail(&metrics->entries, &entry->list);
+    metrics->entry_cnt++;
+    return &entry->stats;
+}
+
+void ucg_builtin_metrics_record(ucg_collective_metrics_t *stats, ucs_time_t start, size_t length,
+                                ucs_status_t status)
+{
+    uint64_t nsec = (uint64_t)ucs_time_to_nsec(ucs_get_time() - start);
+
+    stats->count++;
+    stats->bytes += length;
+    stats->latency[ucg_builtin_metrics_latency_bucket(nsec)]++;
+    if (status != UCS_OK) {
+        stats->errors++;
+    }
+}
+
+unsigned ucg_builtin_metrics_query(const ucg_builtin_metrics_t *metrics, ucg_collective_metrics_t *out,
+                                   unsigned max)
+{
+    ucg_builtin_metrics_entry_t *entry;
+    unsigned idx = 0;
+
+    ucs_list_for_each(entry, &metrics->entries, list) {
+        if (idx < max) {
+            out[idx] = entry->stats;
+        }
+        idx++;
+    }
+
+    return idx;
+}
+
+/* Lower bound of the bucket holding the given fraction of the completions */
+static double ucg_builtin_metrics_percentile(const ucg_collective_metrics_t *stats, double fraction)
+{
+    uint64_t target = ucs_min((uint64_t)(stats->count * fraction), stats->count - 1);
+    uint64_t sum    = 0;
+    unsigned bucket;
+
+    if (stats->count == 0) {
+        return 0;
+    }
+
+    for (bucket = 0; bucket < UCG_COLLECTIVE_METRICS_BUCKETS - 1; bucket++) {
+        sum += stats->latency[bucket];
+        if (sum > target) {
+            break;
+        }
+    }
+
+    return ucg_builtin_metrics_bucket_nsec(bucket) / 1000.0;
+}
+
+static void ucg_builtin_metrics_format(const ucg_collective_metrics_t *stats, char *buf, size_t max)
+{
+    size_t len;
+
+    snprintf(buf, max, "%-9s algo %-2d size <%-10zu %8" PRIu64 " ops %4" PRIu64 " errors %12" PRIu64
+             " bytes | resends %" PRIu64 " unexpected %" PRIu64 " zcopy %" PRIu64
+             " | usec p50 %.1f p99 %.1f max %.1f",
+             (stats->coll_type < COLL_TYPE_NUMS) ? ucg_builtin_metrics_coll_names[stats->coll_type] : "?",
+             stats->algo, (size_t)UCS_BIT(stats->size_log), stats->count, stats->errors, stats->bytes,
+             stats->resends, stats->unexpected, stats->zcopy_promotions,
+             ucg_builtin_metrics_percentile(stats, 0.5), ucg_builtin_metrics_percentile(stats, 0.99),
+             ucg_builtin_metrics_percentile(stats, 1.0));
+
+    /* only the collectives striped over several rails */
+    if (stats->rail_frags[0] + stats->rail_frags[1] != 0) {
+        len = strlen(buf);
+        snprintf(buf + len, max - len, " | rails %" PRIu64 "/%" PRIu64 "/%" PRIu64 "/%" PRIu64,
+                 stats->rail_frags[0], stats->rail_frags[1], stats->rail_frags[2], stats->rail_frags[3]);
+    }
+}
+
+void ucg_builtin_metrics_print(const ucg_builtin_metrics_t *metrics, ucg_group_id_t group_id, FILE *stream)
+{
+    ucg_builtin_metrics_entry_t *entry;
+    char line[320];
+
+    if (ucs_list_is_empty(&metrics->entries)) {
+        return;
+    }
+
+    fprintf(stream, "[%s:%d] ucg group #%u collectives:\n", ucs_get_host_name(), getpid(), group_id);
+    ucs_list_for_each(entry, &metrics->entries, list) {
+        ucg_builtin_metrics_format(&entry->stats, line, sizeof(line));
+        fprintf(stream, "  %s\n", line);
+    }
+    fflush(stream);
+}
+
+/* Appended to <METRICS_FILE>.<pid> if set, otherwise logged at info level */
+void ucg_builtin_metrics_dump(const ucg_builtin_metrics_t *metrics, ucg_group_id_t group_id)
+{
+    ucg_builtin_metrics_entry_t *entry;
+    char path[PATH_MAX];
+    char line[320];
+    FILE *stream;
+
+    if (ucs_list_is_empty(&metrics->entries)) {
+        return;
+    }
+
+    if (metrics->file[0] != '\0') {
+        snprintf(path, sizeof(path), "%s.%d", metrics->file, getpid());
+        stream = fopen(path, "a");
+        if (stream == NULL) {
+            ucs_warn("failed to open the collective metrics %s: %m", path);
+            return;
+        }
+        ucg_builtin_metrics_print(metrics, group_id, stream);
+        fclose(stream);
+        return;
+    }
+
+    ucs_info("ucg group #%u collectives:", group_id);
+    ucs_list_for_each(entry, &metrics->entries, list) {
+        ucg_builtin_metrics_format(&entry->stats, line, sizeof(line));
+        ucs_info("  %s", line);
+    }
+}
+
+int ucg_builtin_metrics_is_signaled(ucg_builtin_metrics_t *metrics)
+{
+    unsigned signal_cnt = ucg_builtin_metrics_signals;
+
+    if (ucs_likely(metrics->signal_cnt == signal_cnt)) {
+        return 0;
+    }
+
+    metrics->signal_cnt = signal_cnt;
+    return 1;
+}
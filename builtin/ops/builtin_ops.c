@@ -5,6 +5,7 @@
 
 #include <string.h>
 #include <ucp/core/ucp_ep.inl>
+#include <uct/base/uct_md.h> /* for the component of an MD, to unpack remote keys */
 #include <ucg/api/ucg_mpi.h>
 #include <ucg/base/ucg_group.h>
 #include <ucs/datastruct/queue.h>
@@ -16,14 +17,15 @@
 #include "builtin_cb.inl"
 
 /*
-* rank id, used in the phase step calculate algorithm
+* rank id, used in the phase step calculate algorithm. Per thread, since
+* threads create operations concurrently on their own workers.
 */
-ucg_group_member_index_t g_myidx = 0;
-unsigned num_procs = 0;
+__thread ucg_group_member_index_t g_myidx = 0;
+__thread unsigned num_procs = 0;
 
 /* in order to keep the interface ucg_builtin_step_create no change, use the global para to pass the value */
-short g_myposition = 0;
-int g_reduce_coinsidency = 0;
+__thread short g_myposition = 0;
+__thread int g_reduce_coinsidency = 0;
 /******************************************************************************
  *                                                                            *
  *                            Operation Execution                             *
@@ -144,19 +146,88 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_dummy_send(ucg_builtin_
     return UCS_OK;
 }
 
+/*
+ * Non-contig send buffers are packed one fragment at a time, right before it
+ * is sent: short sends pack into a fragment-sized bounce buffer, zero-copy
+ * sends into their place in the registered contig_buffer. The fragment is
+ * addressed by its offset from send_buffer, in packed bytes.
+ */
+static UCS_F_ALWAYS_INLINE const int8_t *ucg_builtin_step_short_frag(ucg_builtin_request_t *req,
+                                                                     ucg_builtin_op_step_t *step,
+                                                                     const int8_t *buffer_iter,
+                                                                     size_t length)
+{
+    void *dt_state = step->non_contig.pack_state;
+    if (ucs_likely(dt_state == NULL)) {
+        return buffer_iter;
+    }
+
+    req->op->send_dt->ops.pack(dt_state, buffer_iter - step->send_buffer,
+                               step->non_contig.contig_buffer, length);
+    return step->non_contig.contig_buffer;
+}
+
+static UCS_F_ALWAYS_INLINE void ucg_builtin_step_zcopy_frag(ucg_builtin_request_t *req,
+                                                            ucg_builtin_op_step_t *step,
+                                                            const uct_iov_t *iov)
+{
+    void *dt_state = step->non_contig.pack_state;
+    if (dt_state != NULL) {
+        req->op->send_dt->ops.pack(dt_state, (int8_t*)iov->buffer - step->non_contig.contig_buffer,
+                                   iov->buffer, iov->length);
+    }
+}
+
+/*
+ * A strided send buffer is not packed for zero-copy: the packed range of a
+ * fragment is mapped back to the blocks it covers in the user buffer.
+ */
+static size_t ucg_builtin_step_strided_iov(const ucg_builtin_op_t *op, ucg_builtin_op_step_t *step,
+                                           size_t offset, size_t length)
+{
+    const ucg_dt_strided_t *strided = &op->send_strided;
+    size_t block_size               = step->non_contig.block_size;
+    size_t extent                   = op->super.params.send.dt_len;
+    uct_iov_t *iov                  = step->non_contig.iov;
+    size_t iovcnt                   = 0;
+    size_t block_idx, within;
+    int8_t *buffer;
+
+    while (length > 0) {
+        block_idx = offset / block_size;
+        within    = offset % block_size;
+        buffer    = step->send_buffer + (block_idx / strided->block_cnt) * extent + strided->block_disp +
+                    (block_idx % strided->block_cnt) * strided->block_stride + within;
+
+        if ((iovcnt > 0) && ((int8_t*)iov[iovcnt - 1].buffer + iov[iovcnt - 1].length == buffer)) {
+            iovcnt--;
+        } else {
+            iov[iovcnt].buffer = buffer;
+            iov[iovcnt].length = 0;
+            iov[iovcnt].memh   = step->zcopy.memh;
+            iov[iovcnt].stride = 0;
+            iov[iovcnt].count  = 1;
+        }
+
+        within                  = ucs_min(block_size - within, length);
+        iov[iovcnt++].length   += within;
+        offset                 += within;
+        length                 -= within;
+    }
+
+    ucs_assert(iovcnt <= step->non_contig.max_iov);
+    return iovcnt;
+}
+
 static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_short_one(ucg_builtin_request_t *req,
                                                                       ucg_builtin_op_step_t *step,
                                                                       uct_ep_h ep, int is_single_send)
 {
     ucg_builtin_step_assert(step, UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_SHORT);
-    ucs_info("am_short_one step %u length %zu", step->am_header.step_idx, step->buffer_length);
+    ucs_trace("am_short_one step %u length %zu", step->am_header.step_idx, step->buffer_length);
 
-    int8_t *send_buffer          = step->send_buffer;
-    void *dt_state               = step->non_contig.pack_state;
-    if (dt_state != NULL) {
-        req->op->send_dt->ops.pack(dt_state, 0, step->non_contig.contig_buffer, step->buffer_length);
-        send_buffer              = step->non_contig.contig_buffer;
-    }
+    const int8_t *send_buffer    = ucg_builtin_step_short_frag(req, step, step->send_buffer,
+                                                               step->buffer_length);
     return ucg_builtin_ep_am_short_pack_rank(ep, step->am_id,
                                             step->am_header.header, send_buffer, step->buffer_length, step);
 }
@@ -169,17 +240,10 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_short_max(ucg_builti
     unsigned am_id               = step->am_id;
     ucg_offset_t frag_size       = step->fragment_length;
     int8_t *send_buffer          = step->send_buffer;
-    void *dt_state               = step->non_contig.pack_state;
-
-    if (dt_state != NULL) {
-        req->op->send_dt->ops.pack(dt_state, 0, step->non_contig.contig_buffer, step->buffer_length);
-        send_buffer              = step->non_contig.contig_buffer;
-    }
-
     int8_t *buffer_iter          = send_buffer + step->iter_offset;
     int8_t *buffer_iter_limit    = send_buffer + step->buffer_length - frag_size;
     ucg_builtin_header_t am_iter = { .header = step->am_header.header };
-    am_iter.remote_offset        = (is_single_send) ? step->iter_offset :
+    am_iter.remote_offset        = (is_single_send) ? step->order_base + step->iter_offset :
                                    am_iter.remote_offset + step->iter_offset;
 
     ucg_builtin_step_assert(step, UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_SHORT);
@@ -189,7 +253,9 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_short_max(ucg_builti
         do {
             ucs_debug("am_short_max step %u offset %" PRIu32 " length %u",
                 step->am_header.step_idx, am_iter.remote_offset, frag_size);
-            status = ucg_builtin_ep_am_short_pack_rank(ep, am_id, am_iter.header, buffer_iter, frag_size, step);
+            status = ucg_builtin_ep_am_short_pack_rank(ep, am_id, am_iter.header,
+                                                       ucg_builtin_step_short_frag(req, step, buffer_iter, frag_size),
+                                                       frag_size, step);
 
             if (is_single_send) {
                 return status;
@@ -209,7 +275,8 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_short_max(ucg_builti
     }
 
     ucs_debug("am_short_max step: %u; offset: %" PRIu32 "", step->am_header.step_idx, am_iter.remote_offset);
-    status = ucg_builtin_ep_am_short_pack_rank(ep, am_id, am_iter.header, buffer_iter,
+    status = ucg_builtin_ep_am_short_pack_rank(ep, am_id, am_iter.header,
+        ucg_builtin_step_short_frag(req, step, buffer_iter, send_buffer + step->buffer_length - buffer_iter),
         send_buffer + step->buffer_length - buffer_iter, step);
     /* iter_offset can not set to be zero for pipelining */
     if (!is_single_send) {
@@ -299,6 +366,153 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_bcopy_one(ucg_builti
     return (ucs_unlikely(len < 0)) ? (ucs_status_t)len : UCS_OK;
 }
 
+/*
+ * Large fragments to a peer with several rails are striped over them, weighted
+ * by the rail weights. The receiver places every fragment by its remote_offset,
+ * so it does not matter which rail a fragment arrives on.
+ */
+static UCS_F_ALWAYS_INLINE unsigned ucg_builtin_step_select_rail(const ucg_builtin_op_step_t *step, uct_ep_h ep,
+                                                                 unsigned frag_idx,
+                                                                 const ucg_builtin_rails_t **rails_p)
+{
+    const ucg_builtin_plan_phase_t *phase = step->phase;
+    const ucg_builtin_rails_t *rails = NULL;
+    unsigned rails_idx, rail, pos;
+
+    if (ucs_likely(phase->rails == NULL) || (step->fragment_length < phase->rail_stripe_min) ||
+        phase->ex_attr.is_variable_len) {
+        return 0;
+    }
+
+    for (rails_idx = 0; rails_idx < phase->rails_cnt; rails_idx++) {
+        if (phase->rails[rails_idx].main_ep == ep) {
+            rails = &phase->rails[rails_idx];
+            break;
+        }
+    }
+
+    if ((rails == NULL) || (rails->cnt <= 1)) {
+        return 0;
+    }
+
+    pos = frag_idx % rails->weight_sum;
+    for (rail = 0; pos >= rails->weights[rail]; rail++) {
+        pos -= rails->weights[rail];
+    }
+
+    *rails_p = rails;
+    return rail;
+}
+
+static UCS_F_ALWAYS_INLINE void ucg_builtin_step_rail_count(ucg_builtin_op_t *op,
+                                                            const ucg_builtin_rails_t *rails, unsigned rail)
+{
+    if (ucs_unlikely(op->metrics != NULL) && (rails != NULL)) {
+        op->metrics->rail_frags[rail]++;
+    }
+}
+
+static UCS_F_ALWAYS_INLINE uct_ep_h ucg_builtin_step_bcopy_rail(ucg_builtin_op_t *op,
+                                                                const ucg_builtin_op_step_t *step, uct_ep_h ep)
+{
+    const ucg_builtin_rails_t *rails = NULL;
+    unsigned rail = ucg_builtin_step_select_rail(step, ep, step->iter_offset / step->fragment_length, &rails);
+
+    ucg_builtin_step_rail_count(op, rails, rail);
+    return (rail == 0) ? ep : rails->eps[rail];
+}
+
+static void ucg_builtin_step_rail_dereg(ucg_builtin_op_step_t *step, ucg_builtin_rcache_t *rcache)
+{
+    unsigned idx;
+
+    for (idx = 0; idx < step->rail_reg.cnt; idx++) {
+        ucg_builtin_rcache_dereg(rcache, step->rail_reg.mds[idx], step->rail_reg.memhs[idx],
+                                 step->rail_reg.regions[idx]);
+    }
+    step->rail_reg.cnt    = 0;
+    step->rail_reg.buffer = NULL;
+    step->rail_reg.length = 0;
+}
+
+/*
+ * The send buffer is registered on the memory domain of another rail through
+ * the group registration cache on first use. A held region whose memory was
+ * unmapped since is dropped from the cache, so it is looked up again.
+ */
+static ucs_status_t ucg_builtin_step_rail_memh(ucg_builtin_op_step_t *step, ucg_builtin_rcache_t *rcache,
+                                               uct_md_h md, void *buffer, uct_mem_h *memh_p)
+{
+    ucg_builtin_rcache_region_t *region;
+    ucs_status_t status;
+    unsigned idx;
+
+    if (md == step->uct_md) {
+        *memh_p = step->zcopy.memh;
+        return UCS_OK;
+    }
+
+    if ((step->rail_reg.buffer != buffer) || (step->rail_reg.length != step->buffer_length)) {
+        ucg_builtin_step_rail_dereg(step, rcache);
+        step->rail_reg.buffer = buffer;
+        step->rail_reg.length = step->buffer_length;
+    }
+
+    for (idx = 0; idx < step->rail_reg.cnt; idx++) {
+        if (step->rail_reg.mds[idx] != md) {
+            continue;
+        }
+
+        region = step->rail_reg.regions[idx];
+        if ((region == NULL) || (region->super.flags & UCS_RCACHE_REGION_FLAG_PGTABLE)) {
+            *memh_p = step->rail_reg.memhs[idx];
+            return UCS_OK;
+        }
+
+        /* invalidated, release it and register again in its place */
+        ucg_builtin_rcache_dereg(rcache, md, step->rail_reg.memhs[idx], region);
+        step->rail_reg.cnt--;
+        step->rail_reg.mds[idx]     = step->rail_reg.mds[step->rail_reg.cnt];
+        step->rail_reg.memhs[idx]   = step->rail_reg.memhs[step->rail_reg.cnt];
+        step->rail_reg.regions[idx] = step->rail_reg.regions[step->rail_reg.cnt];
+        break;
+    }
+
+    if (step->rail_reg.cnt == UCG_BUILTIN_MAX_RAILS) {
+        return UCS_ERR_EXCEEDS_LIMIT;
+    }
+
+    status = ucg_builtin_rcache_reg(rcache, md, buffer, step->buffer_length, memh_p, &region);
+    if (status != UCS_OK) {
+        ucs_debug("failed to register %p on rail md %p, not striping", buffer, md);
+        return status;
+    }
+
+    step->rail_reg.mds[step->rail_reg.cnt]       = md;
+    step->rail_reg.memhs[step->rail_reg.cnt]     = *memh_p;
+    step->rail_reg.regions[step->rail_reg.cnt++] = region;
+    return UCS_OK;
+}
+
+static UCS_F_ALWAYS_INLINE uct_ep_h ucg_builtin_step_zcopy_rail(ucg_builtin_op_t *op, ucg_builtin_op_step_t *step,
+                                                                uct_ep_h ep, int8_t *send_buffer, uct_iov_t *iov)
+{
+    const ucg_builtin_rails_t *rails = NULL;
+    unsigned frag_idx = ((int8_t*)iov->buffer - send_buffer) / step->fragment_length;
+    unsigned rail = ucg_builtin_step_select_rail(step, ep, frag_idx, &rails);
+    uct_mem_h memh;
+
+    iov->memh = step->zcopy.memh;
+    if ((rail == 0) || (ucg_builtin_step_rail_memh(step, op->rcache, rails->mds[rail], send_buffer, &memh) != UCS_OK)) {
+        ucg_builtin_step_rail_count(op, rails, 0);
+        return ep;
+    }
+
+    ucg_builtin_step_rail_count(op, rails, rail);
+    iov->memh = memh;
+    return rails->eps[rail];
+}
+
 static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_bcopy_max(ucg_builtin_request_t *req,
                                                                       ucg_builtin_op_step_t *step,
                                                                       uct_ep_h ep, int is_single_send)
@@ -307,7 +521,7 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_bcopy_max(ucg_builti
     unsigned am_id                = step->am_id;
     ucg_offset_t frag_size        = step->fragment_length;
     ucg_offset_t iter_limit       = step->buffer_length - frag_size;
-    step->am_header.remote_offset = (is_single_send) ? step->iter_offset :
+    step->am_header.remote_offset = (is_single_send) ? step->order_base + step->iter_offset :
                                     step->am_header.remote_offset;
 
     ucg_builtin_step_assert(step, UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_BCOPY);
@@ -318,7 +532,8 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_bcopy_max(ucg_builti
         do {
             ucs_debug("am_bcopy_max step %u offset %" PRIu32 " length %u",
                 step->am_header.step_idx, step->am_header.remote_offset, frag_size);
-            len = uct_ep_am_bcopy(ep, am_id, ucg_builtin_step_am_bcopy_full_frag_packer, req, 0);
+            len = uct_ep_am_bcopy(ucg_builtin_step_bcopy_rail(req->op, step, ep), am_id,
+                                  ucg_builtin_step_am_bcopy_full_frag_packer, req, 0);
 
             if (is_single_send) {
                 return ucs_unlikely(len < 0) ? (ucs_status_t)len : UCS_OK;
@@ -337,12 +552,13 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_bcopy_max(ucg_builti
 
     /* Send last fragment of the message */
     ucs_debug("am_bcopy_max step: %u; offset: %" PRIu32 "", step->am_header.step_idx, step->am_header.remote_offset);
-    len = uct_ep_am_bcopy(ep, am_id, ucg_builtin_step_am_bcopy_partial_frag_packer, req, 0);
+    len = uct_ep_am_bcopy(ucg_builtin_step_bcopy_rail(req->op, step, ep), am_id,
+                          ucg_builtin_step_am_bcopy_partial_frag_packer, req, 0);
     if (ucs_unlikely(len < 0)) {
         return (ucs_status_t)len;
     }
 
-    step->am_header.remote_offset = 0;
+    step->am_header.remote_offset = step->order_base;
     /* iter_offset can not set to be zero for pipelining */
     step->iter_offset = (!is_single_send) ? 0 : step->iter_offset;
 
@@ -373,6 +589,23 @@ static ucs_status_t ucg_builtin_step_am_zcopy_pack_rank(uct_ep_h ep,
     return status;
 }
 
+static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_zcopy_frag(ucg_builtin_request_t *req,
+                                                                       ucg_builtin_op_step_t *step,
+                                                                       uct_ep_h ep, int8_t *send_buffer,
+                                                                       uct_iov_t *iov, uct_completion_t *comp)
+{
+    size_t iovcnt;
+
+    if (step->non_contig.iov != NULL) {
+        iovcnt = ucg_builtin_step_strided_iov(req->op, step, (int8_t*)iov->buffer - send_buffer, iov->length);
+        return ucg_builtin_step_am_zcopy_pack_rank(ep, step, step->non_contig.iov, iovcnt, 0, comp);
+    }
+
+    ucg_builtin_step_zcopy_frag(req, step, iov);
+    return ucg_builtin_step_am_zcopy_pack_rank(ucg_builtin_step_zcopy_rail(req->op, step, ep, send_buffer, iov),
+                                               step, iov, 1, 0, comp);
+}
+
 static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_zcopy_one(ucg_builtin_request_t *req,
                                                                       ucg_builtin_op_step_t *step,
                                                                       uct_ep_h ep, int is_single_send)
@@ -382,7 +615,7 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_zcopy_one(ucg_builti
     int8_t *send_buffer          = step->send_buffer;
     void *dt_state               = step->non_contig.pack_state;
 
-    if (dt_state != NULL) {
+    if ((dt_state != NULL) && (step->non_contig.iov == NULL)) {
         req->op->send_dt->ops.pack(dt_state, 0, step->non_contig.contig_buffer, step->buffer_length);
         send_buffer              = step->non_contig.contig_buffer;
     }
@@ -401,24 +634,87 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_zcopy_one(ucg_builti
 
     ucs_debug("am_zcopy_one step %u length %zu", step->am_header.step_idx, step->buffer_length);
 
-    status = ucg_builtin_step_am_zcopy_pack_rank(ep, step, &iov, 1, 0, &zcomp->comp);
+    if (step->non_contig.iov != NULL) {
+        status = ucg_builtin_step_am_zcopy_pack_rank(ep, step, step->non_contig.iov,
+                                                     ucg_builtin_step_strided_iov(req->op, step, 0,
+                                                                                  step->buffer_length),
+                                                     0, &zcomp->comp);
+    } else {
+        status = ucg_builtin_step_am_zcopy_pack_rank(ep, step, &iov, 1, 0, &zcomp->comp);
+    }
     return ucs_unlikely(status != UCS_INPROGRESS) ? status : UCS_OK;
 }
 
+typedef struct ucg_builtin_rndv_pack {
+    ucg_builtin_op_step_t *step;
+    void                  *buffer;
+    ucg_builtin_zcomp_t   *zcomp;
+} ucg_builtin_rndv_pack_t;
+
+static size_t ucg_builtin_step_rndv_pack(void *dest, void *arg)
+{
+    ucg_builtin_rndv_pack_t *pack = (ucg_builtin_rndv_pack_t*)arg;
+    ucg_builtin_op_step_t *step   = pack->step;
+    ucg_builtin_header_t *header  = (ucg_builtin_header_t*)dest;
+    ucg_builtin_rndv_rts_t *rts   = (ucg_builtin_rndv_rts_t*)(header + 1);
+
+    header->header         = step->am_header.header;
+    header->remote_offset |= UCG_BUILTIN_RNDV_RTS;
+    rts->address           = (uintptr_t)pack->buffer;
+    rts->length            = step->buffer_length;
+    rts->token             = (uintptr_t)pack->zcomp;
+    rts->src_index         = step->rndv.my_index;
+    memcpy(rts->rkey, step->rndv.rkey_buffer, step->rndv.rkey_length);
+
+    return sizeof(*header) + sizeof(*rts) + step->rndv.rkey_length;
+}
+
+/*
+ * Rendezvous send: only the RTS goes out, the zcopy completion of this endpoint
+ * is invoked when the receiver's ATS arrives (see @ref ucg_builtin_rndv_ack).
+ */
+static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_rndv_one(ucg_builtin_request_t *req,
+                                                                  ucg_builtin_op_step_t *step,
+                                                                  uct_ep_h ep, int is_single_send)
+{
+    ucs_status_t status;
+    void *dt_state = step->non_contig.pack_state;
+    ucg_builtin_rndv_pack_t pack = {
+        .step   = step,
+        .buffer = step->send_buffer,
+        .zcomp  = &step->zcopy.zcomp[step->iter_ep]
+    };
+
+    if (dt_state != NULL) {
+        req->op->send_dt->ops.pack(dt_state, 0, step->non_contig.contig_buffer, step->buffer_length);
+        pack.buffer = step->non_contig.contig_buffer;
+    }
+
+    /* the handle changes when a non-contig buffer is registered again */
+    status = uct_md_mkey_pack(step->uct_md, step->zcopy.memh, step->rndv.rkey_buffer);
+    if (ucs_unlikely(status != UCS_OK)) {
+        return status;
+    }
+
+    ucg_builtin_step_assert(step, UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_ZCOPY);
+    pack.zcomp->req = req;
+
+    ucs_debug("rndv_one step %u length %zu", step->am_header.step_idx, step->buffer_length);
+
+    ssize_t len = uct_ep_am_bcopy(ep, step->am_id, ucg_builtin_step_rndv_pack, &pack, 0);
+    return ucs_unlikely(len < 0) ? (ucs_status_t)len : UCS_OK;
+}
+
 static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_zcopy_max(
     ucg_builtin_request_t *req,
     ucg_builtin_op_step_t *step,
     uct_ep_h ep, int is_single_send)
 {
     ucs_status_t status;
-    step->am_header.remote_offset = (is_single_send) ? step->iter_offset :
+    step->am_header.remote_offset = (is_single_send) ? step->order_base + step->iter_offset :
                                     step->am_header.remote_offset;
-    int8_t *send_buffer           = step->send_buffer;
-    void *dt_state                = step->non_contig.pack_state;
-    if (dt_state != NULL) {
-        req->op->send_dt->ops.pack(dt_state, 0, step->non_contig.contig_buffer, step->buffer_length);
-        send_buffer               = step->non_contig.contig_buffer;
-    }
+    int8_t *send_buffer           = ((step->non_contig.pack_state != NULL) && (step->non_contig.iov == NULL)) ?
+                                    step->non_contig.contig_buffer : step->send_buffer;
 
     ucg_offset_t frag_size      = step->fragment_length;
     void* iov_buffer_limit      = send_buffer + step->buffer_length - frag_size;
@@ -449,7 +745,7 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_zcopy_max(
         do {
             ucs_debug("am_zcopy_max step %u offset %" PRIu32 " length %u",
                 step->am_header.step_idx, step->am_header.remote_offset, frag_size);
-            status = ucg_builtin_step_am_zcopy_pack_rank(ep, step, &iov, 1, 0, &zcomp->comp);
+            status = ucg_builtin_step_am_zcopy_frag(req, step, ep, send_buffer, &iov, &zcomp->comp);
             
             (zcomp++)->req = req;
 
@@ -475,7 +771,7 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_zcopy_max(
     iov.length = send_buffer + step->buffer_length - (int8_t*)iov.buffer;
     ucs_debug("am_zcopy_max step %u offset %" PRIu32 " length %zu",
         step->am_header.step_idx, step->am_header.remote_offset, iov.length);
-    status     = ucg_builtin_step_am_zcopy_pack_rank(ep, step, &iov, 1, 0, &zcomp->comp);
+    status     = ucg_builtin_step_am_zcopy_frag(req, step, ep, send_buffer, &iov, &zcomp->comp);
     if (ucs_unlikely(status != UCS_INPROGRESS)) {
         step->iter_offset = (!is_single_send) ? (int8_t*)iov.buffer - send_buffer :
                             step->iter_offset;
@@ -483,7 +779,7 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_zcopy_max(
         return status;
     }
 
-    step->am_header.remote_offset = 0;
+    step->am_header.remote_offset = step->order_base;
     /* iter_offset can not set to be zero for pipelining */
     step->iter_offset = (!is_single_send) ? 0 : step->iter_offset;
 
@@ -503,7 +799,7 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_am_dynamic(ucg_builtin_
     int is_fragmented = step->flags & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED;
 
     if (step->resend_flag & UCG_BUILTIN_OP_STEP_FIRST_SEND) {
-        step->am_header.remote_offset = 0;
+        step->am_header.remote_offset = step->order_base;
         step->iter_offset = 0;
     }
 
@@ -555,6 +851,17 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_update_pending(ucg_buil
     return status;
 }
 
+/* sparse phases list the block of every endpoint, the others walk contiguous blocks */
+static UCS_F_ALWAYS_INLINE unsigned ucg_builtin_dynamic_block_idx(const ucg_builtin_plan_phase_t *phase,
+                                                                  unsigned start_block, unsigned ep_idx,
+                                                                  unsigned ep_base)
+{
+    if (phase->ex_attr.sparse_blocks != NULL) {
+        return phase->ex_attr.sparse_blocks[ep_idx];
+    }
+    return (start_block + ep_idx - ep_base) % phase->ex_attr.member_cnt;
+}
+
 static void ucg_builtin_dynamic_calc_pending(ucg_builtin_request_t *req, ucg_request_t **user_req)
 {
     ucg_collective_params_t *params = &(req->op->super.params);
@@ -569,7 +876,8 @@ static void ucg_builtin_dynamic_calc_pending(ucg_builtin_request_t *req, ucg_req
     while (step->iter_ep < phase->ep_cnt) {
         uct_ep_h *ep_iter = phase->multi_eps + step->iter_ep;
         if (*ep_iter) {
-            block_idx = (recv_start_block + local_member_cnt + step->iter_ep - phase->send_ep_cnt) % local_member_cnt;
+            block_idx = ucg_builtin_dynamic_block_idx(phase, recv_start_block + local_member_cnt,
+                                                      step->iter_ep, phase->send_ep_cnt);
             if (recv_coll_params->counts[block_idx] > 0) {
                 step->buffer_length_recv = recv_coll_params->counts[block_idx] * params->recv.dt_len;
                 ucg_builtin_step_update_pending(req, step->iter_ep);
@@ -595,7 +903,6 @@ static ucs_status_t ucg_builtin_dynamic_send_recv(ucg_builtin_request_t *req, uc
     uint16_t orig_flags = step->flags;
 
     unsigned send_start_block = phase->ex_attr.start_block;
-    unsigned local_member_cnt = phase->ex_attr.member_cnt;
 
     /* initialize the pendings before both sending/receiving */
     if (step->resend_flag & UCG_BUILTIN_OP_STEP_FIRST_SEND) {
@@ -606,7 +913,7 @@ static ucs_status_t ucg_builtin_dynamic_send_recv(ucg_builtin_request_t *req, uc
     while (step->iter_ep < phase->send_ep_cnt) {
         uct_ep_h *ep_iter = phase->multi_eps + step->iter_ep;
         if (*ep_iter) {
-            block_idx = (send_start_block + step->iter_ep) % local_member_cnt;
+            block_idx = ucg_builtin_dynamic_block_idx(phase, send_start_block, step->iter_ep, 0);
             if (step->send_coll_params->counts[block_idx] > 0) {
                 int send_buffer_length = send_coll_params->counts[block_idx] * params->send.dt_len;
                 int send_buffer_displ = send_coll_params->displs[block_idx] * params->send.dt_len;
@@ -624,10 +931,19 @@ static ucs_status_t ucg_builtin_dynamic_send_recv(ucg_builtin_request_t *req, uc
                     return status;
                 }
 
+                /* past the eager threshold, the block is registered instead of copied, same fragments */
+                if ((send_flag & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_BCOPY) &&
+                    (send_buffer_length >= step->phase->ep_thresh[step->iter_ep].zcopy_eager) &&
+                    (send_buffer_length <= step->phase->ep_thresh[step->iter_ep].md_attr_cap_max_reg)) {
+                    send_flag = (send_flag & ~UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_BCOPY) |
+                                UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_ZCOPY;
+                    UCG_BUILTIN_METRICS_INC(req->op, zcopy_promotions);
+                }
+
                 step->flags |= send_flag;
                 /* register memory for zero-copy */
                 if (step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_ZCOPY) {
-                    status = ucg_builtin_dynamic_zcopy_prep(step, step->iter_ep);
+                    status = ucg_builtin_dynamic_zcopy_prep(step, step->iter_ep, req->op->rcache);
                     if (status != UCS_OK) {
                         step->resend_flag = UCG_BUILTIN_OP_STEP_RESEND;
                         step->flags = orig_flags;
@@ -769,6 +1085,7 @@ static ucs_status_t ucg_builtin_dynamic_send_recv(ucg_builtin_request_t *req, uc
         /* Potential completions (the operation may have finished by now) */     \
         if ((!is_recv && !is_zcopy) || ((req)->pending == 0)) {                  \
             /* Nothing else to do - complete this step */                        \
+            UCG_BUILTIN_TRACE_STEP(UCG_BUILTIN_TRACE_SEND_END, step, 0);         \
             if (is_last) {                                                       \
                 if (!(ureq)) {                                                   \
                     ucg_builtin_comp_last_step_cb(req, UCS_OK);                  \
@@ -820,7 +1137,7 @@ UCS_PROFILE_FUNC(ucs_status_t, ucg_builtin_step_execute, (req, user_req),
                  ucg_builtin_request_t *req, ucg_request_t **user_req)
 {
     /* UCT level communication operations */
-    int is_dummy, is_short, is_bcopy, is_zcopy;
+    int is_dummy, is_short, is_bcopy, is_zcopy, is_rndv;
     /* Receive-related indicators, for non-send-only steps */
     int is_recv, is_rs1, is_r1s, is_pipelined;
     /* Step-completion-related indicators */
@@ -835,6 +1152,7 @@ UCS_PROFILE_FUNC(ucs_status_t, ucg_builtin_step_execute, (req, user_req),
     ucg_builtin_comp_slot_t *slot   = ucs_container_of(req, ucg_builtin_comp_slot_t, req);
     step->am_header.coll_id         = slot->coll_id;
     ucs_assert(slot->step_idx == step->am_header.step_idx);
+    UCG_BUILTIN_TRACE_STEP(UCG_BUILTIN_TRACE_SEND_START, step, req->pending);
 
     ucs_debug("step_execute, coll_id:%u, step_idx:%u, step->flags:0x%x, send_buffer:%p, recv_buffer:%p",
               slot->coll_id, slot->step_idx, step->flags, step->send_buffer, step->recv_buffer);
@@ -875,6 +1193,7 @@ UCS_PROFILE_FUNC(ucs_status_t, ucg_builtin_step_execute, (req, user_req),
     is_short      = step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_SHORT;
     is_bcopy      = step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_BCOPY;
     is_zcopy      = step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_ZCOPY;
+    is_rndv       = step->flags & UCG_BUILTIN_OP_STEP_FLAG_RNDV;
     is_fragmented = step->flags & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED;
 
     if (phase->ex_attr.is_variable_len) {
@@ -892,6 +1211,7 @@ UCS_PROFILE_FUNC(ucs_status_t, ucg_builtin_step_execute, (req, user_req),
         ucg_builtin_dynamic_calc_pending(req, user_req);
 
         if (req->pending == 0) {
+            UCG_BUILTIN_TRACE_STEP(UCG_BUILTIN_TRACE_SEND_END, step, 0);
             if (is_last) {
                 if (!user_req) {
                     ucg_builtin_comp_last_step_cb(req, UCS_OK);
@@ -914,6 +1234,8 @@ UCS_PROFILE_FUNC(ucs_status_t, ucg_builtin_step_execute, (req, user_req),
                 case_send(req, user_req, step, phase, ucg_builtin_step_am_short_one);
             } else if (is_bcopy) {
                 case_send(req, user_req, step, phase, ucg_builtin_step_am_bcopy_one);
+            } else if (is_zcopy && is_rndv) {
+                case_send(req, user_req, step, phase, ucg_builtin_step_rndv_one);
             } else if (is_zcopy) {
                 case_send(req, user_req, step, phase, ucg_builtin_step_am_zcopy_one);
             }
@@ -929,6 +1251,7 @@ UCS_PROFILE_FUNC(ucs_status_t, ucg_builtin_step_execute, (req, user_req),
     }
 
 finish_send:
+    UCG_BUILTIN_TRACE_STEP(UCG_BUILTIN_TRACE_SEND_END, step, req->pending);
 
     /* Initialize the users' request object, if applicable */
     INIT_USER_REQUEST_IF_GIVEN(user_req, req);
@@ -936,18 +1259,19 @@ finish_send:
     step->resend_flag = UCG_BUILTIN_OP_STEP_FIRST_SEND;
 
     /* Check pending incoming messages - invoke the callback on each one */
-    if (ucs_likely(ucs_list_is_empty(&slot->msg_head))) {
+    if (ucs_likely((slot->msg_cnt == 0) ||
+                   ucs_list_is_empty(ucg_builtin_slot_msgs(slot, slot->step_idx)))) {
         return UCS_INPROGRESS;
     }
 
-    if (is_zcopy && is_recv) {
+    if (is_zcopy && is_recv && !is_rndv) {
         /* Count pre-arrived zcopy msg to req->step->zcopy.num_store */
         local_id = slot->local_id;
         /* receive from "multiple" EPs with "multiple" fragments */
         unsigned recv_zcopy_cnt = step->fragments_recv * step->phase->ep_cnt;
         ucg_builtin_comp_desc_t *desc = NULL;
         ucg_builtin_comp_desc_t *iter = NULL;
-        ucs_list_for_each_safe(desc, iter, &slot->msg_head, super.tag_list[0]) {
+        ucs_list_for_each_safe(desc, iter, ucg_builtin_slot_msgs(slot, slot->step_idx), super.tag_list[0]) {
             if (ucs_likely(desc->header.local_id == local_id)) {
                 /* The number of store will not bigger than recv fragments */
                 if (++step->zcopy.num_store >= recv_zcopy_cnt) {
@@ -965,6 +1289,8 @@ step_execute_error:
     if (status == UCS_ERR_NO_RESOURCE) {
         /* Special case: send incomplete - enqueue for resend upon progress */
         INIT_USER_REQUEST_IF_GIVEN(user_req, req);
+        UCG_BUILTIN_METRICS_INC(req->op, resends);
+        UCG_BUILTIN_TRACE_STEP(UCG_BUILTIN_TRACE_RESEND, step, req->pending);
 
         if (step->flags & UCG_BUILTIN_OP_STEP_FLAG_PIPELINED) {
             step->fragment_pending[step->iter_offset / step->fragment_length] =
@@ -981,12 +1307,12 @@ step_execute_error:
     return status;
 }
 
+/*
+ * Only the current step's queue is drained, so a completed step leads here
+ * again for the next one, at most once per step of the operation.
+ */
 ucs_status_t ucg_builtin_msg_process(ucg_builtin_comp_slot_t *slot, ucg_builtin_request_t *req)
 {
-    static unsigned loop_cnt = 0;
-    static unsigned is_return = 0;
-    unsigned max_msg_list_size = ((ucg_builtin_config_t*) req->op->super.plan->planner->plan_config)->max_msg_list_size;
-
     /* Look for matches in list of packets waiting on this slot */
     uint16_t local_id = slot->local_id;
     ucg_builtin_op_step_t *step = req->step;
@@ -994,21 +1320,16 @@ ucs_status_t ucg_builtin_msg_process(ucg_builtin_comp_slot_t *slot, ucg_builtin_
     ucg_builtin_comp_desc_t *desc = NULL;
     ucg_builtin_comp_desc_t *iter = NULL;
 
-    ucs_list_for_each_safe(desc, iter, &slot->msg_head, super.tag_list[0]) {
+    ucs_list_for_each_safe(desc, iter, ucg_builtin_slot_msgs(slot, slot->step_idx), super.tag_list[0]) {
         /*
          * Note: stored message coll_id can be either larger or smaller than
          * the one currently handled - due to coll_id wrap-around.
          */
         if (ucs_likely(desc->header.local_id == local_id)) {
-            /* Check loop count - return in_progress if attach max size */
-            if (++loop_cnt > max_msg_list_size) {
-                is_return = 1;
-                loop_cnt--;
-                return UCS_INPROGRESS;
-            }
-
             /* Remove the packet (next call may lead here recursively) */
             ucs_list_del(&desc->super.tag_list[0]);
+            slot->msg_cnt--;
+            UCG_BUILTIN_METRICS_INC(req->op, unexpected);
 
             if (req->step->phase->is_swap) {
                 ucg_builtin_swap_net_recv(&desc->data[0], desc->super.length,
@@ -1016,24 +1337,19 @@ ucs_status_t ucg_builtin_msg_process(ucg_builtin_comp_slot_t *slot, ucg_builtin_
             }
 
             /* Handle this "waiting" packet, possibly completing the step */
-            int is_step_done = step->recv_cb(&slot->req,
-                                             desc->header.remote_offset, &desc->data[0],
-                                             desc->super.length);
+            ucg_builtin_comp_recv_cb_t recv_cb =
+                    ucg_builtin_rndv_is_rts(step, desc->header.remote_offset) ?
+                    ucg_builtin_rndv_recv : step->recv_cb;
+            int is_step_done = recv_cb(&slot->req,
+                                       desc->header.remote_offset, &desc->data[0],
+                                       desc->super.length);
             desc->release(desc);
             desc = NULL;
 
-            loop_cnt--;
-
             /* If the step has indeed completed - check the entire op */
             if (is_step_done) {
-                /* Continue msg processing if return by loop check */
-                if (loop_cnt == 0 && is_return == 1) {
-                    is_return = 0;
-                    return ucg_builtin_msg_process(slot, req);
-                } else {
-                    return (req->comp_req->flags & UCP_REQUEST_FLAG_COMPLETED) ?
-                           req->comp_req->status : UCS_INPROGRESS;
-                }
+                return (req->comp_req->flags & UCP_REQUEST_FLAG_COMPLETED) ?
+                       req->comp_req->status : UCS_INPROGRESS;
             }
         }
     }
@@ -1041,6 +1357,304 @@ ucs_status_t ucg_builtin_msg_process(ucg_builtin_comp_slot_t *slot, ucg_builtin_
     return UCS_INPROGRESS;
 }
 
+/*
+ * Rendezvous receive: the RTS is consumed in place of the data. The data is read
+ * straight into its final place when the step's callback would only copy it
+ * there, and into the scratch arena otherwise. Either way, once the read is done
+ * the callback runs once per fragment this step expects, as if the data had
+ * arrived in active messages. The sender may have chosen otherwise for the same
+ * step, so nothing else here depends on rendezvous being used.
+ */
+typedef struct ucg_builtin_rndv_recv {
+    uct_completion_t       comp;
+    uct_pending_req_t      pending;    /* the read or the ATS, waiting for resources */
+    ucg_builtin_request_t *req;
+    ucg_builtin_scratch_t *scratch;    /* this state and the staged data are borrowed from it */
+    ucg_builtin_rcache_t  *rcache;
+    uct_ep_h               ep;
+    uct_md_h               md;
+    uct_component_h        component;
+    uct_rkey_bundle_t      rkey;
+    uct_mem_h              memh;
+    ucg_builtin_rcache_region_t *region;
+    uint64_t               address;
+    uint64_t               token;
+    uint64_t               offset;
+    size_t                 length;
+    size_t                 get_offset; /* how much of the read is posted */
+    size_t                 max_get;    /* longest read the interface takes */
+    void                  *buffer;
+    int                    is_staged;  /* buffer is borrowed from the scratch arena */
+    int                    is_fetched; /* the read is done, the ATS is next */
+    uint32_t               am_id;
+    ucg_builtin_header_t   ats_header;
+} ucg_builtin_rndv_recv_t;
+
+static void *ucg_builtin_rndv_recv_dest(const ucg_builtin_op_step_t *step, uint64_t offset)
+{
+    if ((step->recv_cb == ucg_builtin_comp_recv_one_cb) ||
+        (step->recv_cb == ucg_builtin_comp_recv_one_then_send_cb)) {
+        return step->recv_buffer;
+    }
+
+    if ((step->recv_cb == ucg_builtin_comp_recv_many_cb) ||
+        (step->recv_cb == ucg_builtin_comp_recv_many_then_send_cb)) {
+        return step->recv_buffer + offset;
+    }
+
+    return NULL;
+}
+
+static void ucg_builtin_rndv_release(ucg_builtin_rndv_recv_t *rndv)
+{
+    ucg_builtin_scratch_put(rndv->scratch, rndv, sizeof(*rndv));
+}
+
+/* Post the rest of the read, in pieces the interface takes, and drop the guard count once all are out */
+static ucs_status_t ucg_builtin_rndv_get(ucg_builtin_rndv_recv_t *rndv)
+{
+    ucs_status_t status;
+    uct_iov_t iov;
+
+    iov.memh   = rndv->memh;
+    iov.stride = 0;
+    iov.count  = 1;
+    while (rndv->get_offset < rndv->length) {
+        iov.buffer = (int8_t*)rndv->buffer + rndv->get_offset;
+        iov.length = ucs_min(rndv->length - rndv->get_offset, rndv->max_get);
+        status     = uct_ep_get_zcopy(rndv->ep, &iov, 1, rndv->address + rndv->get_offset,
+                                      rndv->rkey.rkey, &rndv->comp);
+        if (status == UCS_INPROGRESS) {
+            rndv->comp.count++;
+        } else if (status != UCS_OK) {
+            return status;
+        }
+        rndv->get_offset += iov.length;
+    }
+
+    return (--rndv->comp.count == 0) ? UCS_OK : UCS_INPROGRESS;
+}
+
+static ucs_status_t ucg_builtin_rndv_send_ats(ucg_builtin_rndv_recv_t *rndv)
+{
+    return uct_ep_am_short(rndv->ep, rndv->am_id, rndv->ats_header.header,
+                           &rndv->token, sizeof(rndv->token));
+}
+
+static ucs_status_t ucg_builtin_rndv_pending_cb(uct_pending_req_t *self);
+
+/* Issue the read or the ATS, queueing it on the endpoint when out of resources */
+static ucs_status_t ucg_builtin_rndv_post(ucg_builtin_rndv_recv_t *rndv)
+{
+    ucs_status_t status;
+
+    do {
+        status = rndv->is_fetched ? ucg_builtin_rndv_send_ats(rndv) : ucg_builtin_rndv_get(rndv);
+        if (status != UCS_ERR_NO_RESOURCE) {
+            return status;
+        }
+
+        rndv->pending.func = ucg_builtin_rndv_pending_cb;
+        status = uct_ep_pending_add(rndv->ep, &rndv->pending, 0);
+    } while (status == UCS_ERR_BUSY);
+
+    return (status == UCS_OK) ? UCS_ERR_NO_RESOURCE : status;
+}
+
+static void ucg_builtin_rndv_fail(ucg_builtin_rndv_recv_t *rndv, ucs_status_t status)
+{
+    ucg_builtin_request_t *req = rndv->req;
+
+    ucs_error("rendezvous read of %zu bytes failed: %s", rndv->length, ucs_status_string(status));
+    uct_rkey_release(rndv->component, &rndv->rkey);
+    ucg_builtin_rcache_dereg(rndv->rcache, rndv->md, rndv->memh, rndv->region);
+    if (rndv->is_staged) {
+        ucg_builtin_scratch_put(rndv->scratch, rndv->buffer, rndv->length);
+    }
+    ucg_builtin_rndv_release(rndv);
+
+    ucg_builtin_comp_last_step_cb(req, status);
+}
+
+static int ucg_builtin_rndv_fetched(ucg_builtin_rndv_recv_t *rndv)
+{
+    ucg_builtin_request_t *req = rndv->req;
+    size_t frag_length         = req->step->rndv.recv_frag_length;
+    size_t frag_offset;
+    ucs_status_t status;
+    int is_step_done = 0;
+
+    uct_rkey_release(rndv->component, &rndv->rkey);
+    ucg_builtin_rcache_dereg(rndv->rcache, rndv->md, rndv->memh, rndv->region);
+
+    /* the sender's buffer is free once read, so ack before consuming the data */
+    rndv->is_fetched = 1;
+    status = ucg_builtin_rndv_post(rndv);
+
+    for (frag_offset = 0; frag_offset < rndv->length; frag_offset += frag_length) {
+        is_step_done = req->step->recv_cb(req, rndv->offset + frag_offset,
+                                          (int8_t*)rndv->buffer + frag_offset,
+                                          ucs_min(frag_length, rndv->length - frag_offset));
+    }
+    if (rndv->is_staged) {
+        ucg_builtin_scratch_put(rndv->scratch, rndv->buffer, rndv->length);
+    }
+
+    if (status == UCS_ERR_NO_RESOURCE) {
+        return is_step_done; /* released once the ATS is out */
+    }
+
+    if (ucs_unlikely(status != UCS_OK)) {
+        ucs_error("failed to acknowledge a rendezvous read: %s", ucs_status_string(status));
+    }
+    ucg_builtin_rndv_release(rndv);
+    return is_step_done;
+}
+
+static void ucg_builtin_rndv_get_comp(uct_completion_t *self)
+{
+    ucg_builtin_rndv_recv_t *rndv = ucs_container_of(self, ucg_builtin_rndv_recv_t, comp);
+
+    if (ucs_unlikely(self->status != UCS_OK)) {
+        ucg_builtin_rndv_fail(rndv, self->status);
+    } else {
+        (void) ucg_builtin_rndv_fetched(rndv);
+    }
+}
+
+static ucs_status_t ucg_builtin_rndv_pending_cb(uct_pending_req_t *self)
+{
+    ucg_builtin_rndv_recv_t *rndv = ucs_container_of(self, ucg_builtin_rndv_recv_t, pending);
+    ucs_status_t status = rndv->is_fetched ? ucg_builtin_rndv_send_ats(rndv) : ucg_builtin_rndv_get(rndv);
+
+    if (status == UCS_ERR_NO_RESOURCE) {
+        return status; /* stays queued */
+    }
+
+    if (rndv->is_fetched) {
+        if (ucs_unlikely(status != UCS_OK)) {
+            ucs_error("failed to acknowledge a rendezvous read: %s", ucs_status_string(status));
+        }
+        ucg_builtin_rndv_release(rndv);
+    } else if (status == UCS_OK) {
+        (void) ucg_builtin_rndv_fetched(rndv);
+    } else if (status != UCS_INPROGRESS) {
+        ucg_builtin_rndv_fail(rndv, status);
+    }
+
+    return UCS_OK;
+}
+
+int ucg_builtin_rndv_recv(ucg_builtin_request_t *req, uint64_t offset,
+                          const void *data, size_t length)
+{
+    const ucg_builtin_rndv_rts_t *rts = (const ucg_builtin_rndv_rts_t*)data;
+    ucg_builtin_comp_slot_t *slot     = ucs_container_of(req, ucg_builtin_comp_slot_t, req);
+    ucg_builtin_op_step_t *step       = req->step;
+    ucg_builtin_rndv_recv_t *rndv;
+    ucs_status_t status;
+
+    ucs_assert(length >= sizeof(*rts));
+#if ENABLE_DEBUG_DATA
+    ucs_assert(step->phase->indexes[0] == rts->src_index);
+#endif
+    rndv = (ucg_builtin_rndv_recv_t*)ucg_builtin_scratch_get(req->op->scratch, sizeof(*rndv));
+    if (rndv == NULL) {
+        ucg_builtin_comp_last_step_cb(req, UCS_ERR_NO_MEMORY);
+        return 1;
+    }
+
+    /* the endpoint was resolved when the step was created */
+    rndv->req                      = req;
+    rndv->scratch                  = req->op->scratch;
+    rndv->rcache                   = req->op->rcache;
+    rndv->ep                       = step->rndv.recv_ep;
+    rndv->md                       = step->uct_md;
+    rndv->component                = step->uct_md->component;
+    rndv->address                  = rts->address;
+    rndv->length                   = rts->length;
+    rndv->token                    = rts->token;
+    rndv->offset                   = offset & ~(uint64_t)UCG_BUILTIN_RNDV_MASK;
+    rndv->get_offset               = 0;
+    rndv->max_get                  = step->phase->ep_attr->cap.get.max_zcopy;
+    rndv->is_fetched               = 0;
+    rndv->am_id                    = step->am_id;
+    rndv->comp.func                = ucg_builtin_rndv_get_comp;
+    rndv->comp.count               = 1; /* guard, see ucg_builtin_rndv_get() */
+    rndv->comp.status              = UCS_OK;
+    rndv->ats_header.header        = step->am_header.header;
+    rndv->ats_header.local_id      = slot->local_id;
+    rndv->ats_header.remote_offset = UCG_BUILTIN_RNDV_ATS;
+
+    if (ucs_unlikely(!(step->phase->ep_attr->cap.flags & UCT_IFACE_FLAG_GET_ZCOPY) ||
+                     (rndv->max_get == 0))) {
+        status = UCS_ERR_UNSUPPORTED;
+        goto err_free;
+    }
+
+    status = uct_rkey_unpack(rndv->component, rts->rkey, &rndv->rkey);
+    if (ucs_unlikely(status != UCS_OK)) {
+        goto err_free;
+    }
+
+    rndv->buffer    = ucg_builtin_rndv_recv_dest(step, rndv->offset);
+    rndv->is_staged = (rndv->buffer == NULL);
+    if (rndv->is_staged) {
+        rndv->buffer = ucg_builtin_scratch_get(rndv->scratch, rndv->length);
+        if (rndv->buffer == NULL) {
+            status = UCS_ERR_NO_MEMORY;
+            goto err_rkey;
+        }
+    }
+
+    status = ucg_builtin_rcache_reg(rndv->rcache, rndv->md, rndv->buffer, rndv->length,
+                                    &rndv->memh, &rndv->region);
+    if (ucs_unlikely(status != UCS_OK)) {
+        goto err_buffer;
+    }
+
+    ucs_debug("rndv recv step %u offset %" PRIu64 " length %zu", step->am_header.step_idx,
+              rndv->offset, rndv->length);
+
+    status = ucg_builtin_rndv_post(rndv);
+    if (status == UCS_OK) {
+        return ucg_builtin_rndv_fetched(rndv);
+    } else if ((status == UCS_INPROGRESS) || (status == UCS_ERR_NO_RESOURCE)) {
+        return 0;
+    }
+
+    ucg_builtin_rndv_fail(rndv, status);
+    return 1;
+
+err_buffer:
+    if (rndv->is_staged) {
+        ucg_builtin_scratch_put(rndv->scratch, rndv->buffer, rndv->length);
+    }
+err_rkey:
+    uct_rkey_release(rndv->component, &rndv->rkey);
+err_free:
+    ucs_error("rendezvous receive of %zu bytes failed: %s", rndv->length, ucs_status_string(status));
+    ucg_builtin_rndv_release(rndv);
+    ucg_builtin_comp_last_step_cb(req, status);
+    return 1;
+}
+
+/* The receiver has read my buffer: complete the send to it, as a zcopy would */
+void ucg_builtin_rndv_ack(ucg_builtin_request_t *req, const void *data, size_t length)
+{
+    ucg_builtin_zcomp_t *zcomp;
+    uint64_t token;
+
+    ucs_assert(length == sizeof(token));
+    memcpy(&token, data, sizeof(token));
+    zcomp = (ucg_builtin_zcomp_t*)(uintptr_t)token;
+    ucs_assert(zcomp->req == req);
+
+    if (--zcomp->comp.count == 0) {
+        zcomp->comp.func(&zcomp->comp);
+    }
+}
+
 void *ucg_builtin_pack_rank(void *step, const void *send_buffer, size_t buffer_len, size_t *new_buffer_len)
 {
     ucg_builtin_op_step_t *temp_step = (ucg_builtin_op_step_t *)step;
@@ -1059,12 +1673,18 @@ ucg_group_member_index_t ucg_builtin_unpack_rank(const void *send_buffer, size_t
     return *(ucg_group_member_index_t *)send_buffer;
 }
 
-ucs_status_t ucg_builtin_step_alloc_pack_rank_buffer(ucg_builtin_op_step_t *step, size_t buffer_length)
+ucs_status_t ucg_builtin_step_alloc_pack_rank_buffer(ucg_builtin_op_step_t *step, ucg_builtin_scratch_t *scratch,
+                                                     size_t buffer_length)
 {
     if (step->variable_length.pack_rank_buffer == NULL) {
+        step->variable_length.pack_rank_length = buffer_length +
+                                                 sizeof(ucg_group_member_index_t) * step->phase->send_ep_cnt;
         step->variable_length.pack_rank_buffer =
-           (int8_t *)UCS_ALLOC_CHECK(buffer_length + sizeof(ucg_group_member_index_t) * step->phase->send_ep_cnt,
-                                    "pack rank buffer");
+           (int8_t *)ucg_builtin_scratch_get(scratch, step->variable_length.pack_rank_length);
+        if (step->variable_length.pack_rank_buffer == NULL) {
+            step->variable_length.pack_rank_length = 0;
+            return UCS_ERR_NO_MEMORY;
+        }
         step->variable_length.pack_rank_func = ucg_builtin_pack_rank;
         step->variable_length.unpack_rank_func = ucg_builtin_unpack_rank;
     }
@@ -1072,31 +1692,105 @@ ucs_status_t ucg_builtin_step_alloc_pack_rank_buffer(ucg_builtin_op_step_t *step
     return UCS_OK;
 }
 
-void ucg_builtin_step_free_pack_rank_buffer(ucg_builtin_op_step_t *step)
+void ucg_builtin_step_free_pack_rank_buffer(ucg_builtin_op_step_t *step, ucg_builtin_scratch_t *scratch)
 {
-    ucg_builtin_free((void **)&step->variable_length.pack_rank_buffer);
+    ucg_builtin_scratch_release(scratch, &step->variable_length.pack_rank_buffer,
+                                &step->variable_length.pack_rank_length);
     step->variable_length.pack_rank_func = NULL;
     step->variable_length.unpack_rank_func = NULL;
 }
 
-ucs_status_t ucg_builtin_step_set_contig(ucg_builtin_op_step_t *step,
-                                         int is_contig)
+/*
+ * Zero-copy steps of a strided send buffer are sent as iov lists of its
+ * blocks, if the blocks of any fragment fit in one zcopy call. The buffer is
+ * registered from send_buffer to the end of its last block.
+ */
+static int ucg_builtin_step_set_strided(ucg_builtin_op_t *op, ucg_builtin_op_step_t *step,
+                                        const ucg_collective_params_t *params)
+{
+    const ucg_dt_strided_t *strided = &op->send_strided;
+    size_t max_iov                  = step->phase->ep_attr->cap.am.max_iov;
+    size_t frag_size                = (step->flags & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED) ?
+                                      step->fragment_length : step->buffer_length;
+    size_t packed_len, block_size, span;
+    ucs_status_t status;
+
+    if ((strided->block_cnt == 0) || (params->send.count <= 0) ||
+        !(step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_ZCOPY) ||
+        (step->flags & UCG_BUILTIN_OP_STEP_FLAG_RNDV) ||
+        step->phase->ex_attr.is_variable_len || (step->zcopy.zcomp == NULL)) {
+        return 0;
+    }
+
+    packed_len = ucg_builtin_get_dt_len(op->send_dt);
+    block_size = packed_len / strided->block_cnt;
+    if ((step->buffer_length != packed_len * params->send.count) ||
+        (frag_size / block_size + 2 > max_iov)) {
+        return 0;
+    }
+
+    span = (params->send.count - 1) * params->send.dt_len + strided->block_disp +
+           (strided->block_cnt - 1) * strided->block_stride + block_size;
+
+    ucg_builtin_rcache_dereg(op->rcache, step->uct_md, step->zcopy.memh, step->zcopy.region);
+    step->zcopy.memh   = NULL;
+    step->zcopy.region = NULL;
+    status = ucg_builtin_rcache_reg(op->rcache, step->uct_md, step->send_buffer, span,
+                                    &step->zcopy.memh, &step->zcopy.region);
+    if (status != UCS_OK) {
+        ucs_debug("strided send buffer %p not registered, it will be packed", step->send_buffer);
+        return 0;
+    }
+
+    step->non_contig.iov        = UCS_ALLOC_CHECK(max_iov * sizeof(uct_iov_t), "ucg_strided_iov");
+    step->non_contig.max_iov    = max_iov;
+    step->non_contig.block_size = block_size;
+    step->non_contig.span       = span;
+    step->non_contig.is_pack    = 1;
+    ucs_debug("step %u sends %zu strided blocks of %zu bytes by zcopy",
+              step->am_header.step_idx, step->buffer_length / block_size, block_size);
+    return 1;
+}
+
+ucs_status_t ucg_builtin_step_set_contig(ucg_builtin_op_step_t *step, ucg_builtin_scratch_t *scratch,
+                                         ucg_builtin_rcache_t *rcache, int is_contig)
 {
     ucs_status_t status = UCS_OK;
     if (is_contig) {
         return status;
     }
 
-    /* only non-contig dt will malloc contig_buffer and malloc only once. */
-    if (!is_contig && step->non_contig.contig_buffer == NULL) {
-        step->non_contig.contig_buffer = (int8_t *)UCS_ALLOC_CHECK(step->buffer_length, "contig_buffer");
+    /*
+     * Bcopy packs straight into the transport's buffer, short sends need one
+     * fragment of bounce buffer, zero-copy the whole registered length.
+     * Variable-length steps may change the send type per peer.
+     */
+    size_t contig_length = step->buffer_length;
+    step->non_contig.is_pack = 1;
+    if (!step->phase->ex_attr.is_variable_len) {
+        if (step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_BCOPY) {
+            contig_length = 0;
+        } else if ((step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_SHORT) &&
+                   (step->flags & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED)) {
+            contig_length = step->fragment_length;
+        }
+    }
+
+    /* only non-contig dt will borrow contig_buffer and borrow only once. */
+    if ((contig_length != 0) && (step->non_contig.contig_buffer == NULL)) {
+        step->non_contig.contig_buffer = (int8_t *)ucg_builtin_scratch_get(scratch, contig_length);
+        if (step->non_contig.contig_buffer == NULL) {
+            ucs_fatal("no memory for contig_buffer, length:%lu", contig_length);
+        }
+        step->non_contig.contig_length = contig_length;
     }
 
     if (step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_ZCOPY) {
         /* The send buffer changed, reregister it */
-        uct_md_mem_dereg(step->uct_md, step->zcopy.memh);
-        status = uct_md_mem_reg(step->uct_md, step->non_contig.contig_buffer,
-                                step->buffer_length, UCT_MD_MEM_ACCESS_ALL, &step->zcopy.memh);
+        ucg_builtin_rcache_dereg(rcache, step->uct_md, step->zcopy.memh, step->zcopy.region);
+        step->zcopy.region = NULL;
+        status = ucg_builtin_rcache_reg(rcache, step->uct_md, step->non_contig.contig_buffer,
+                                        step->buffer_length, &step->zcopy.memh, &step->zcopy.region);
         if (status != UCS_OK) {
             if (step->zcopy.zcomp != NULL) {
                 ucs_free(step->zcopy.zcomp);
@@ -1110,9 +1804,11 @@ ucs_status_t ucg_builtin_step_set_contig(ucg_builtin_op_step_t *step,
     return status;
 }
 
-void ucg_builtin_step_release_contig(ucg_builtin_op_step_t *step)
+void ucg_builtin_step_release_contig(ucg_builtin_op_step_t *step, ucg_builtin_scratch_t *scratch)
 {
-    ucg_builtin_free((void **)&step->non_contig.contig_buffer);
+    ucg_builtin_scratch_put(scratch, step->non_contig.contig_buffer, step->non_contig.contig_length);
+    step->non_contig.contig_buffer = NULL;
+    ucg_builtin_free((void **)&step->non_contig.iov);
 }
 
 static void free_zcomp(ucg_builtin_op_step_t *step)
@@ -1120,13 +1816,14 @@ static void free_zcomp(ucg_builtin_op_step_t *step)
     ucg_builtin_free((void **)&step->zcopy.zcomp);
 }
 
-static void free_zcopy_info(ucg_builtin_op_step_t *step)
+static void free_zcopy_info(ucg_builtin_op_step_t *step, ucg_builtin_rcache_t *rcache)
 {
     if (step->zcopys != NULL) {
         unsigned i;
         for (i = 0; i < step->phase->send_ep_cnt; i++) {
             if (step->zcopys[i].zcomp != NULL) {
-                uct_md_mem_dereg(step->zcopys[i].uct_md, step->zcopys[i].memh);
+                ucg_builtin_rcache_dereg(rcache, step->zcopys[i].uct_md, step->zcopys[i].memh,
+                                         step->zcopys[i].region);
                 ucs_free(step->zcopys[i].zcomp);
             }
         }
@@ -1141,47 +1838,82 @@ static void free_fragment_pending(ucg_builtin_op_step_t *step)
     }
 }
 
+void ucg_builtin_op_cancel_wait(ucg_builtin_op_t *builtin_op)
+{
+    ucg_request_t *user_req = builtin_op->queued_req;
+
+    builtin_op->queued_req = NULL;
+    if (user_req == &builtin_op->own_req + 1) {
+        return; /* goes away with the operation */
+    }
+
+    (user_req - 1)->status = UCS_ERR_CANCELED;
+    (user_req - 1)->flags |= UCP_REQUEST_FLAG_COMPLETED;
+}
+
 void ucg_builtin_op_discard(ucg_op_t *op)
 {
     ucg_builtin_op_t *builtin_op = (ucg_builtin_op_t*)op;
     ucg_builtin_op_step_t *step = &builtin_op->steps[0];
+    ucs_queue_iter_t iter;
+    ucg_builtin_op_t *waiting;
+
+    /* an operation still waiting for its slot must not be started once freed */
+    if (ucs_unlikely(builtin_op->queued_req != NULL)) {
+        ucs_queue_for_each_safe(waiting, iter, &builtin_op->window->waiting, queue) {
+            if (waiting == builtin_op) {
+                ucs_queue_del_iter(&builtin_op->window->waiting, iter);
+                break;
+            }
+        }
+        ucg_builtin_op_cancel_wait(builtin_op);
+    }
+
     do {
         if ((step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_ZCOPY) && (step->phase->ex_attr.is_variable_len == 0)) {
-            uct_md_mem_dereg(step->uct_md, step->zcopy.memh);
+            ucg_builtin_rcache_dereg(builtin_op->rcache, step->uct_md, step->zcopy.memh, step->zcopy.region);
             free_zcomp(step);
         } else {
-            free_zcopy_info(step); //for dynamic sending, dereg for all zcopys
+            free_zcopy_info(step, builtin_op->rcache); //for dynamic sending, dereg for all zcopys
         }
 
         if (step->flags & UCG_BUILTIN_OP_STEP_FLAG_PIPELINED) {
             free_fragment_pending(step);
         }
 
+        ucg_builtin_step_rail_dereg(step, builtin_op->rcache);
+        ucg_builtin_free((void **)&step->rndv.rkey_buffer);
+
         /* Free the allreduce buffer */
         if (step->reduce_buff != NULL) {
-            free(step->reduce_buff);
+            ucg_builtin_scratch_put(builtin_op->scratch, step->reduce_buff, step->rbuf_length);
             step->rbuf_count = 0;
             step->reduce_buff = NULL;
+            ucg_builtin_free((void **)&step->rbuf_held);
+            ucg_builtin_free((void **)&step->rbuf_frags);
         }
 
-        ucg_builtin_step_release_contig(step);
+        ucg_builtin_step_release_contig(step, builtin_op->scratch);
     } while (!((step++)->flags & UCG_BUILTIN_OP_STEP_FLAG_LAST_STEP));
     
-    ucg_builtin_free((void **)&builtin_op->temp_data_buffer);
-    
+    ucg_builtin_scratch_release(builtin_op->scratch, &builtin_op->temp_data_buffer,
+                                &builtin_op->temp_data_length);
+    ucg_builtin_scratch_release(builtin_op->scratch, &builtin_op->temp_data_buffer1,
+                                &builtin_op->temp_data_length1);
+    ucg_builtin_scratch_release(builtin_op->scratch, &builtin_op->temp_exchange_buffer,
+                                &builtin_op->temp_exchange_length);
+    ucg_builtin_scratch_release(builtin_op->scratch, &builtin_op->temp_exchange_buffer1,
+                                &builtin_op->temp_exchange_length1);
+
     ucs_mpool_put_inline(op);
 }
 
-ucs_status_t ucg_builtin_op_trigger(ucg_op_t *op, ucg_coll_id_t coll_id, ucg_request_t **request)
+static ucs_status_t ucg_builtin_op_start(ucg_builtin_op_t *builtin_op, ucg_coll_id_t coll_id,
+                                         ucg_request_t **request)
 {
-    /* Allocate a "slot" for this operation, from a per-group array of slots */
-    ucg_builtin_op_t *builtin_op  = (ucg_builtin_op_t*)op;
-    ucg_builtin_comp_slot_t *slot = &builtin_op->slots[coll_id % UCG_BUILTIN_MAX_CONCURRENT_OPS];
+    /* Take the "slot" of this operation, from the per-group window of slots */
+    ucg_builtin_comp_slot_t *slot = ucg_builtin_window_slot(builtin_op->window, coll_id);
     slot->coll_id                 = coll_id;
-    if (ucs_unlikely(slot->cb != NULL)) {
-        ucs_error("UCG Builtin planner exceeded the max concurrent collectives.");
-        return UCS_ERR_NO_RESOURCE;
-    }
 
     /* Initialize the request structure, located inside the selected slot s */
     ucg_builtin_request_t *builtin_req = &slot->req;
@@ -1226,7 +1958,99 @@ ucs_status_t ucg_builtin_op_trigger(ucg_op_t *op, ucg_coll_id_t coll_id, ucg_req
         /* Need to return original status, because it can be OK or INPROGRESS */
     }
     /* Start the first step, which may actually complete the entire operation */
-    return ucg_builtin_step_execute(builtin_req, request);
+    ucs_status_t status = ucg_builtin_step_execute(builtin_req, request);
+    if (status != UCS_INPROGRESS) {
+        ucg_builtin_metrics_complete(builtin_op, status);
+    }
+    /* errors are traced by ucg_builtin_comp_last_step_cb() */
+    if (status == UCS_OK) {
+        UCG_BUILTIN_TRACE(UCG_BUILTIN_TRACE_COMPLETE, builtin_op->super.plan->group_id, coll_id, 0, status);
+    }
+    return status;
+}
+
+/*
+ * The slot of this collective is still taken by an earlier one: wait in the
+ * order of coll_id, through a request the caller can already check.
+ */
+static ucs_status_t ucg_builtin_op_wait_slot(ucg_builtin_op_t *builtin_op, ucg_coll_id_t coll_id,
+                                             ucg_request_t **request)
+{
+    ucg_builtin_slot_window_t *window = builtin_op->window;
+
+    if (ucs_unlikely(builtin_op->queued_req != NULL)) {
+        ucs_error("UCG Builtin operation %p is already waiting for a slot.", builtin_op);
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    if (*request == NULL) {
+        *request = &builtin_op->own_req + 1;
+    }
+    (*request - 1)->flags  = 0;
+    builtin_op->queued_id  = coll_id;
+    builtin_op->queued_req = *request;
+
+    if (window->mask + 1 < window->limit) {
+        window->is_grow = 1;
+    }
+
+    ucs_queue_push(&window->waiting, &builtin_op->queue);
+    ucs_debug("op %p waits for the slot of coll id %u", builtin_op, coll_id);
+    return UCS_INPROGRESS;
+}
+
+unsigned ucg_builtin_window_progress(ucg_builtin_slot_window_t *window)
+{
+    ucg_builtin_op_t *builtin_op;
+    ucg_request_t *user_req;
+    ucg_request_t *req;
+    ucs_status_t status;
+    unsigned count = 0;
+
+    while (!ucs_queue_is_empty(&window->waiting)) {
+        builtin_op = ucs_queue_head_elem_non_empty(&window->waiting, ucg_builtin_op_t, queue);
+        if (ucg_builtin_window_slot(window, builtin_op->queued_id)->cb != NULL) {
+            break;
+        }
+
+        (void) ucs_queue_pull_non_empty(&window->waiting);
+        user_req               = builtin_op->queued_req;
+        req                    = user_req;
+        builtin_op->queued_req = NULL;
+
+        status = ucg_builtin_op_start(builtin_op, builtin_op->queued_id, &req);
+        if (status != UCS_INPROGRESS) {
+            (user_req - 1)->status = status;
+            (user_req - 1)->flags |= UCP_REQUEST_FLAG_COMPLETED;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+ucs_status_t ucg_builtin_op_trigger(ucg_op_t *op, ucg_coll_id_t coll_id, ucg_request_t **request)
+{
+    ucg_builtin_op_t *builtin_op      = (ucg_builtin_op_t*)op;
+    ucg_builtin_slot_window_t *window = builtin_op->window;
+
+    if (ucs_unlikely(builtin_op->async != NULL)) {
+        ucg_builtin_async_kick(builtin_op->async);
+    }
+
+    if (ucs_unlikely(builtin_op->metrics != NULL)) {
+        builtin_op->metrics_start = ucs_get_time();
+    }
+
+    UCG_BUILTIN_TRACE(UCG_BUILTIN_TRACE_TRIGGER, builtin_op->super.plan->group_id, coll_id, 0,
+                      builtin_op->metrics_len);
+
+    if (ucs_unlikely(!ucs_queue_is_empty(&window->waiting) ||
+                     (ucg_builtin_window_slot(window, coll_id)->cb != NULL))) {
+        return ucg_builtin_op_wait_slot(builtin_op, coll_id, request);
+    }
+
+    return ucg_builtin_op_start(builtin_op, coll_id, request);
 }
 
 static size_t ucg_builtin_get_inc_data_length(const ucg_collective_params_t *params)
@@ -1246,6 +2070,35 @@ static size_t ucg_builtin_get_inc_data_length(const ucg_collective_params_t *par
  *                            Operation Creation                              *
  *                                                                            *
  ******************************************************************************/
+/*
+ * Rendezvous is decided by the sender alone, from its own threshold. The receiver
+ * takes an RTS in place of the fragments it expects, so both sides only need to
+ * agree on the steps that may carry one, which depends on the plan alone. Those
+ * are the broadcast and recursive-doubling allgather steps: their receivers copy
+ * the data out as is, into a buffer of the same length, from a single peer.
+ */
+static UCS_F_ALWAYS_INLINE int ucg_builtin_step_may_rndv(const ucg_builtin_op_step_t *step,
+                                                         const ucg_builtin_plan_phase_t *phase,
+                                                         const ucg_collective_params_t *params)
+{
+    /* no data offset of the step may reach the RTS and ATS bits */
+    if (phase->ex_attr.is_variable_len || phase->ex_attr.is_partial ||
+        ((uint64_t)num_procs * step->buffer_length >= UCG_BUILTIN_RNDV_ATS)) {
+        return 0;
+    }
+
+    switch (phase->method) {
+        case UCG_PLAN_METHOD_ALLGATHER_RECURSIVE:
+            return phase->ep_cnt == 1;
+        case UCG_PLAN_METHOD_SEND_TERMINAL:
+        case UCG_PLAN_METHOD_RECV_TERMINAL:
+        case UCG_PLAN_METHOD_BCAST_WAYPOINT:
+            return ucg_builtin_get_coll_type(&params->type) == COLL_TYPE_BCAST;
+        default:
+            return 0;
+    }
+}
+
 static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_send_flags(ucg_builtin_op_step_t *step,
                                                                     ucg_builtin_plan_phase_t *phase,
                                                                     const ucg_collective_params_t *params,
@@ -1302,6 +2155,16 @@ static UCS_F_ALWAYS_INLINE ucs_status_t ucg_builtin_step_send_flags(ucg_builtin_
             step->fragments = length / step->fragment_length + partial_length;
         }
 
+        /* Rendezvous - a single RTS, while a peer sending otherwise would send the above */
+        if (ucs_unlikely((length >= phase->send_thresh.rndv_thresh) &&
+                         ucg_builtin_step_may_rndv(step, phase, params))) {
+            step->rndv.fragments  = step->fragments;
+            step->rndv.recv_flags = *send_flag & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED;
+            *send_flag            = (enum ucg_builtin_op_step_flags)(UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_ZCOPY |
+                                                                     UCG_BUILTIN_OP_STEP_FLAG_RNDV);
+            step->fragments       = 1;
+        }
+
     /*
      * Medium messages
      */
@@ -1493,6 +2356,7 @@ ucs_status_t ucg_builtin_step_create(ucg_builtin_op_t *op,
                                      ucg_builtin_op_step_t *step)
 {
     ucs_status_t status;
+    int is_ordered_frags;
     
     /* Set the parameters determining the send-flags later on */
     int is_send_contig       = UCG_DT_IS_CONTIG(params, send_dtype);
@@ -1517,6 +2381,7 @@ ucs_status_t ucg_builtin_step_create(ucg_builtin_op_t *op,
     step->send_coll_params = NULL;
     step->recv_coll_params = NULL;
     step->variable_length.pack_rank_buffer = NULL;
+    step->variable_length.pack_rank_length = 0;
     step->variable_length.pack_rank_func = NULL;
     step->variable_length.unpack_rank_func = NULL;
     /* allocate the zcopy_info array for dynamic sending */
@@ -1538,10 +2403,14 @@ ucs_status_t ucg_builtin_step_create(ucg_builtin_op_t *op,
     }
 
     step->non_contig.contig_buffer = NULL;
+    step->non_contig.contig_length = 0;
+    step->non_contig.is_pack      = 0;
+    step->non_contig.iov          = NULL;
     step->non_contig.pack_state   = NULL;
     step->non_contig.unpack_state = NULL;
     step->non_contig.pack_state_recv = NULL;
     step->reduce_buff = NULL;
+    step->rbuf_length = 0;
 
     ucg_builtin_plan_t *builtin_plan = (ucg_builtin_plan_t*)op->super.plan;
 
@@ -1701,7 +2570,7 @@ ucs_status_t ucg_builtin_step_create(ucg_builtin_op_t *op,
     send_flag = (enum ucg_builtin_op_step_flags) 0;
     /* Note: in principle, step->send_buffer should not be changed after this function */
     status = ucg_builtin_step_send_flags(step, phase, params, send_dt_len, &send_flag);
-    extra_flags |= (send_flag & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED);
+    extra_flags |= (send_flag & (UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED | UCG_BUILTIN_OP_STEP_FLAG_RNDV));
     if (ucs_unlikely(status != UCS_OK)) {
         return status;
     }
@@ -1731,7 +2600,9 @@ ucs_status_t ucg_builtin_step_create(ucg_builtin_op_t *op,
             if (phase->ex_attr.is_partial) {
                 step->buffer_length = params->send.dt_len * params->send.count;
             }
-            extra_flags  = ((send_flag & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED) && builtin_plan->ucg_algo.pipeline) ?
+            /* forwarding fragments as they are reduced would reduce the children in arrival order */
+            extra_flags  = ((send_flag & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED) && builtin_plan->ucg_algo.pipeline &&
+                            !g_reduce_coinsidency) ?
                            (extra_flags | UCG_BUILTIN_OP_STEP_FLAG_PIPELINED) : extra_flags;
             extra_flags |= UCG_BUILTIN_OP_STEP_FLAG_RECV_BEFORE_SEND1;
             step->flags  = send_flag | extra_flags;
@@ -1760,11 +2631,14 @@ ucs_status_t ucg_builtin_step_create(ucg_builtin_op_t *op,
             extra_flags |= UCG_BUILTIN_OP_STEP_FLAG_RECV1_BEFORE_SEND;
             extra_flags |= UCG_BUILTIN_OP_STEP_FLAG_LENGTH_PER_REQUEST;
             step->flags  = send_flag | extra_flags;
+            /* current_data_buffer is the op's temp_data_buffer, returned at discard */
             if (*current_data_buffer == NULL) {
-                *current_data_buffer = (int8_t *)ucs_calloc(1, step->buffer_length, "ucg_fanout_waypoint_buffer");
+                *current_data_buffer = (int8_t *)ucg_builtin_scratch_get(op->scratch, step->buffer_length);
                 if (*current_data_buffer == NULL) {
                     return UCS_ERR_NO_MEMORY;
                 }
+                memset(*current_data_buffer, 0, step->buffer_length);
+                op->temp_data_length = step->buffer_length;
             }
             step->send_buffer = *current_data_buffer;
             step->recv_buffer = step->send_buffer;
@@ -1800,6 +2674,7 @@ ucs_status_t ucg_builtin_step_create(ucg_builtin_op_t *op,
         case UCG_PLAN_METHOD_REDUCE_SCATTER_RING:
         case UCG_PLAN_METHOD_ALLGATHER_RING:
         case UCG_PLAN_METHOD_EXCHANGE:
+        case UCG_PLAN_METHOD_DISSEMINATION:
             extra_flags |= UCG_BUILTIN_OP_STEP_FLAG_RECV_AFTER_SEND;
             step->flags = send_flag | extra_flags;
             break;
@@ -1818,7 +2693,7 @@ ucs_status_t ucg_builtin_step_create(ucg_builtin_op_t *op,
         if (phase->method != UCG_PLAN_METHOD_RECV_TERMINAL &&
             phase->method != UCG_PLAN_METHOD_REDUCE_TERMINAL ) {
                 /* memory registration (using the memory registration cache)*/
-                status = ucg_builtin_step_zcopy_prep(step);
+                status = ucg_builtin_step_zcopy_prep(step, op->rcache);
                 if (ucs_unlikely(status != UCS_OK)) {
                     ucs_error("Failed to register the buffer in zcopy");
                     return status;
@@ -1826,6 +2701,13 @@ ucs_status_t ucg_builtin_step_create(ucg_builtin_op_t *op,
             }
     }
 
+    if ((step->flags & UCG_BUILTIN_OP_STEP_FLAG_RNDV) &&
+        (step->flags & UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_ZCOPY)) {
+        step->rndv.rkey_length = phase->md_attr->rkey_packed_size;
+        step->rndv.rkey_buffer = UCS_ALLOC_CHECK(ucs_max(step->rndv.rkey_length, 1), "rndv rkey buffer");
+        step->rndv.my_index    = ucg_group_get_params(op->super.plan->group)->member_index;
+    }
+
     status = ucg_builtin_step_recv_flags(step, phase, params, recv_dt_len, &recv_flag);
     if (status != UCS_OK) {
         return status;
@@ -1844,24 +2726,53 @@ ucs_status_t ucg_builtin_step_create(ucg_builtin_op_t *op,
         }
     }
 
-    /* create allreduce buffer */
+    /*
+     * create allreduce buffer: a slot per child, in rank order. Fragmented
+     * children add the offset of their slot to the fragment offsets, which
+     * must fit in the header offset on every rank alike. No step of an
+     * allreduce is sent by rendezvous, so all the bits of the offset are data.
+     */
+    is_ordered_frags = (send_flag & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED) &&
+                       ((uint64_t)num_procs * step->buffer_length <= UINT32_MAX);
+    if ((phase->method == UCG_PLAN_METHOD_REDUCE_TERMINAL || phase->method == UCG_PLAN_METHOD_REDUCE_WAYPOINT)
+        && (send_flag & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED) && !is_ordered_frags && g_reduce_coinsidency
+        && (extra_flags & UCG_BUILTIN_OP_STEP_FLAG_FIRST_STEP)) {
+        ucs_warn("allreduce of %zu bytes over %u members is too long to order its children, "
+                 "they are reduced as they arrive despite REDUCE_CONSISTENCY",
+                 step->buffer_length, num_procs);
+    }
     if ((phase->method == UCG_PLAN_METHOD_REDUCE_TERMINAL || phase->method == UCG_PLAN_METHOD_REDUCE_WAYPOINT)
-        && !(send_flag & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED) && g_reduce_coinsidency
+        && (!(send_flag & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED) || is_ordered_frags) && g_reduce_coinsidency
         && (extra_flags & UCG_BUILTIN_OP_STEP_FLAG_FIRST_STEP)) {
-            step->rbuf_count = step->fragments_recv
+            step->rbuf_count = (is_ordered_frags ? 1 : step->fragments_recv)
             * (phase->ep_cnt - ((phase->method == UCG_PLAN_METHOD_REDUCE_TERMINAL) ? 0 : 1));
-            step->reduce_buff = (void *)UCS_ALLOC_CHECK(step->buffer_length * step->rbuf_count, "reduce buffer for child");
+            step->rbuf_length = step->buffer_length * step->rbuf_count;
+            step->reduce_buff = ucg_builtin_scratch_get(op->scratch, step->rbuf_length);
+            step->rbuf_held = (uint8_t *)ucs_calloc(step->rbuf_count, sizeof(uint8_t), "reduce buffer held flags");
+            step->rbuf_frags = is_ordered_frags ?
+                               (uint32_t *)ucs_calloc(step->rbuf_count, sizeof(uint32_t), "reduce buffer fragments") :
+                               NULL;
+            if ((step->reduce_buff == NULL) || (step->rbuf_held == NULL) ||
+                (is_ordered_frags && (step->rbuf_frags == NULL))) {
+                ucg_builtin_scratch_put(op->scratch, step->reduce_buff, step->rbuf_length);
+                step->reduce_buff = NULL;
+                ucg_builtin_free((void **)&step->rbuf_held);
+                ucg_builtin_free((void **)&step->rbuf_frags);
+                return UCS_ERR_NO_MEMORY;
+            }
+            step->rbuf_next = 0;
             ucs_debug("rb count:%d, ep count:%u", step->rbuf_count, phase->ep_cnt);
     }
 
     /* send my offset to up tree node, in order to keep the reduce sequence */
-    if (!(send_flag & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED)
+    if ((!(send_flag & UCG_BUILTIN_OP_STEP_FLAG_FRAGMENTED) || is_ordered_frags)
          && ((phase->method == UCG_PLAN_METHOD_REDUCE_WAYPOINT) || (phase->method == UCG_PLAN_METHOD_SEND_TERMINAL))
          && g_reduce_coinsidency) {
         unsigned is_allreduce = (ucg_builtin_get_coll_type(&params->type) == COLL_TYPE_ALLREDUCE);
         if (is_allreduce) {
             ucs_debug("my postion:%d", g_myposition);
-            step->am_header.remote_offset = g_myposition;
+            step->order_base = is_ordered_frags ? g_myposition * step->buffer_length : 0;
+            step->am_header.remote_offset = is_ordered_frags ? step->order_base : g_myposition;
         }
     }
 
@@ -1878,6 +2789,18 @@ ucs_status_t ucg_builtin_step_create(ucg_builtin_op_t *op,
         !phase->ex_attr.is_inequal) {
         recv_flag = (enum ucg_builtin_op_step_flags)step->flags;
         step->fragments_recv = step->fragments;
+        if (step->flags & UCG_BUILTIN_OP_STEP_FLAG_RNDV) {
+            /* my own RTS says nothing of what the peer sends me */
+            recv_flag = (enum ucg_builtin_op_step_flags)((recv_flag & ~UCG_BUILTIN_OP_STEP_FLAG_RNDV) |
+                                                         step->rndv.recv_flags);
+            step->fragments_recv = step->rndv.fragments;
+        }
+    }
+
+    /* the peer an RTS may come from, which is first in the layout of a waypoint */
+    if ((phase->method != UCG_PLAN_METHOD_SEND_TERMINAL) && ucg_builtin_step_may_rndv(step, phase, params)) {
+        step->rndv.recv_ep          = (phase->ep_cnt == 1) ? phase->single_ep : phase->multi_eps[0];
+        step->rndv.recv_frag_length = (step->fragments_recv > 1) ? step->fragment_length : step->buffer_length;
     }
 
     if (phase->segmented) {
@@ -1887,7 +2810,9 @@ ucs_status_t ucg_builtin_step_create(ucg_builtin_op_t *op,
         phase->recv_cache_buffer = NULL;
     }
 
-    ucg_builtin_step_set_contig(step, (is_send_contig || is_recv_contig));
+    if (is_send_contig || !ucg_builtin_step_set_strided(op, step, params)) {
+        ucg_builtin_step_set_contig(step, op->scratch, op->rcache, is_send_contig);
+    }
 
     /* Select the right completion callback */
     return ucg_builtin_step_select_callbacks(phase, is_recv_contig, &step->recv_cb,
@@ -1924,7 +2849,7 @@ void ucg_builtin_swap_net_recv(char *netdata, size_t length, size_t offset,
         return;
     }
 
-    tmp_buffer = (char *)ucs_malloc(length, "temp swap buffer");
+    tmp_buffer = (char *)ucg_builtin_scratch_get(req->op->scratch, length);
     if (tmp_buffer == NULL) {
         ucs_fatal("no memory for malloc, length:%lu", length);
     }
@@ -1942,7 +2867,7 @@ void ucg_builtin_swap_net_recv(char *netdata, size_t length, size_t offset,
         memcpy(recv_buffer + offset, tmp_buffer, length);
     }
 
-    free(tmp_buffer);
+    ucg_builtin_scratch_put(req->op->scratch, tmp_buffer, length);
 }
 
 ucs_status_t ucg_builtin_op_create(ucg_plan_t *plan,
@@ -1969,10 +2894,26 @@ ucs_status_t ucg_builtin_op_create(ucg_plan_t *plan,
     op->dtspan_f = builtin_plan->dtspan_f;
     op->send_dt = NULL;
     op->recv_dt = NULL;
+    op->reduce_kernel = NULL;
+    op->reduce_strided_kernel = NULL;
+    op->send_strided.block_cnt = 0;
+    op->scratch = ucg_builtin_group_scratch(builtin_ctx);
+    op->rcache = ucg_builtin_group_rcache(builtin_ctx);
+    op->async = ucg_builtin_group_async(builtin_ctx);
+    op->rpool = ucg_builtin_group_rpool(builtin_ctx);
+    op->rpool_min_cnt = UINT_MAX;
+    op->metrics_len = (size_t)ucs_max(params->send.count, 0) * params->send.dt_len;
+    op->metrics_start = 0;
+    op->metrics = ucg_builtin_metrics_get(ucg_builtin_group_metrics(builtin_ctx), params->coll_type,
+                                          builtin_plan->algo_id, op->metrics_len);
     op->temp_data_buffer = NULL;
     op->temp_data_buffer1 = NULL;
     op->temp_exchange_buffer = NULL;
     op->temp_exchange_buffer1 = NULL;
+    op->temp_data_length = 0;
+    op->temp_data_length1 = 0;
+    op->temp_exchange_length = 0;
+    op->temp_exchange_length1 = 0;
 
     if (params->send.count > 0 && params->send.dt_len > 0) {
         status = ucg_builtin_convert_datatype(builtin_plan, params->send.dt_ext, &send_dtype);
@@ -1981,6 +2922,11 @@ ucs_status_t ucg_builtin_op_create(ucg_plan_t *plan,
         }
         op->send_dt = (!UCG_DT_IS_CONTIG(params, send_dtype)) ? ucp_dt_to_generic(send_dtype) :
                       op->send_dt;
+        if (op->send_dt != NULL) {
+            ucg_builtin_send_strided_find(ucg_group_get_params(plan->group), params->send.dt_ext,
+                                          ucg_builtin_get_dt_len(op->send_dt), params->send.dt_len,
+                                          &op->send_strided);
+        }
     }
 
     if (params->recv.count > 0 && params->recv.dt_len > 0) {
@@ -1992,6 +2938,26 @@ ucs_status_t ucg_builtin_op_create(ucg_plan_t *plan,
                       op->recv_dt;
     }
 
+    if ((params->type.modifiers & UCG_GROUP_COLLECTIVE_MODIFIER_AGGREGATE) && (params->recv.count > 0)) {
+        const ucg_group_params_t *group_params = ucg_group_get_params(plan->group);
+        if (op->recv_dt == NULL) {
+            op->reduce_kernel = ucg_builtin_reduce_kernel_find(group_params, params->recv.op_ext,
+                                                               params->recv.dt_ext, params->recv.dt_len);
+        } else {
+            /* the base kernel of a strided type reduces one block, never a whole element */
+            op->reduce_strided_kernel = ucg_builtin_reduce_strided_find(group_params, params->recv.op_ext,
+                                                                        params->recv.dt_ext,
+                                                                        ucg_builtin_get_dt_len(op->recv_dt),
+                                                                        &op->reduce_strided);
+        }
+        /* only the native kernels are reentrant, the MPI callback stays on this thread */
+        if ((op->rpool != NULL) && (op->reduce_kernel != NULL)) {
+            const ucg_builtin_config_t *config = (const ucg_builtin_config_t*)plan->planner->plan_config;
+            op->rpool_dt_len  = params->recv.dt_len;
+            op->rpool_min_cnt = ucs_max(config->reduce_threads_thresh / params->recv.dt_len, 1);
+        }
+    }
+
     /* get number of processes */
     num_procs = (unsigned)(ucg_group_get_params(plan->group))->member_count;
     g_myidx = plan->my_index;
@@ -2049,10 +3015,12 @@ ucs_status_t ucg_builtin_op_create(ucg_plan_t *plan,
 
     UCS_STATIC_ASSERT(sizeof(ucg_builtin_header_t) <= UCP_WORKER_HEADROOM_PRIV_SIZE);
     UCS_STATIC_ASSERT(sizeof(ucg_builtin_header_t) == sizeof(uint64_t));
+    UCS_STATIC_ASSERT(UCG_BUILTIN_MAX_RAILS <= UCG_COLLECTIVE_METRICS_RAILS);
 
-    op->slots  = (ucg_builtin_comp_slot_t*)builtin_plan->slots;
-    op->resend = builtin_plan->resend;
-    *new_op    = &op->super;
+    op->window     = (ucg_builtin_slot_window_t*)builtin_plan->window;
+    op->queued_req = NULL;
+    op->resend     = builtin_plan->resend;
+    *new_op        = &op->super;
     return UCS_OK;
 
 op_cleanup:
@@ -10,6 +10,8 @@
 #include <ucg/builtin/plan/builtin_algo_mgr.h>
 #include <ucp/core/ucp_request.h>
 #include <ucp/dt/dt_contig.h>
+#include <ucs/memory/rcache.h>
+#include <ucs/time/time.h>
 
 BEGIN_C_DECLS
 
@@ -34,11 +36,14 @@ typedef void (*mpi_reduce_f)(void *mpi_op, char *src_buffer,
                              void* mpi_datatype);
 typedef void(*ucg_builtin_op_complete_cb_f)(void *complete_cb_arg);
 
+/* Native reduction of a predefined (operation, datatype) pair: dst = src op dst */
+typedef void (*ucg_builtin_reduce_kernel_f)(const void *src, void *dst, unsigned count);
+
 extern ucg_plan_component_t ucg_builtin_component;
 extern mpi_reduce_f ucg_builtin_mpi_reduce_cb;
 extern unsigned builtin_base_am_id;
-extern ucg_group_member_index_t g_myidx;
-extern unsigned num_procs;
+extern __thread ucg_group_member_index_t g_myidx;
+extern __thread unsigned num_procs;
 
 typedef union ucg_builtin_header {
     struct {
@@ -81,8 +86,29 @@ enum ucg_builtin_op_step_flags {
     UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_BCOPY      = UCS_BIT(10),
     UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_ZCOPY      = UCS_BIT(11),
     UCG_BUILTIN_OP_STEP_FLAG_SEND_AM_DYNAMIC    = UCS_BIT(12),
+
+    /* Data is read by the receiver, set by the sender only (see rndv.recv_ep) */
+    UCG_BUILTIN_OP_STEP_FLAG_RNDV               = UCS_BIT(13),
 };
 
+/*
+ * Rendezvous: instead of the data, the sender sends a "ready-to-send" (RTS)
+ * describing its registered buffer. The receiver reads it with RMA get and
+ * answers with an "ack-to-send" (ATS), which completes the send. Both are
+ * marked in the header offset, which is otherwise zero or small for such steps.
+ */
+#define UCG_BUILTIN_RNDV_RTS  ((ucg_offset_t)UCS_BIT(31))
+#define UCG_BUILTIN_RNDV_ATS  ((ucg_offset_t)UCS_BIT(30))
+#define UCG_BUILTIN_RNDV_MASK (UCG_BUILTIN_RNDV_RTS | UCG_BUILTIN_RNDV_ATS)
+
+typedef struct ucg_builtin_rndv_rts {
+    uint64_t                 address;   /* sender's buffer */
+    uint64_t                 length;
+    uint64_t                 token;     /* sender's completion, echoed in the ATS */
+    ucg_group_member_index_t src_index;
+    uint8_t                  rkey[];    /* packed remote key of the buffer */
+} UCS_S_PACKED ucg_builtin_rndv_rts_t;
+
 enum ucg_builtin_op_step_displs_rule {
     /* rule of displacement for bruck plan with alltoall  */
     UCG_BUILTIN_OP_STEP_DISPLS_RULE_BRUCK_ALLTOALL
@@ -135,9 +161,12 @@ typedef struct ucg_builtin_coll_params {
 ucg_builtin_coll_params_t *ucg_builtin_allocate_coll_params(unsigned local_member_cnt);
 void ucg_builtin_free_coll_params(ucg_builtin_coll_params_t **params);
 
+typedef struct ucg_builtin_rcache_region ucg_builtin_rcache_region_t;
+
 typedef struct ucg_builtin_zcopy_info {
     uct_md_h              uct_md;
     uct_mem_h             memh;
+    ucg_builtin_rcache_region_t *region; /* < cache entry of memh, NULL if not cached */
     ucg_builtin_zcomp_t  *zcomp;
     uint32_t              num_store;  /* < number of step's store zcopy messages */
     uint32_t              zcopy_pending;
@@ -152,6 +181,7 @@ typedef struct ucg_builtin_op_step {
     uint32_t                   iter_ep;          /* iterator, somewhat volatile */
     ucg_offset_t               iter_offset;      /* iterator, somewhat volatile */
     ucg_offset_t               remote_offset;    /*  for algorithm like ring    */
+    ucg_offset_t               order_base;       /* slot of a tree child at its parent, see reduce_buff */
 #define UCG_BUILTIN_OFFSET_PIPELINE_READY   ((ucg_offset_t)-1)
 #define UCG_BUILTIN_OFFSET_PIPELINE_PENDING ((ucg_offset_t)-2)
 
@@ -192,7 +222,8 @@ typedef struct ucg_builtin_op_step {
 
     /* Fields intended for send and receive variable length */
     struct {
-        int8_t                          *pack_rank_buffer;
+        int8_t                          *pack_rank_buffer; /* borrowed from the scratch arena */
+        size_t                           pack_rank_length;
         ucg_builtin_pack_rank_cb_t       pack_rank_func;
         ucg_builtin_unpack_rank_cb_t     unpack_rank_func;
     } variable_length;
@@ -200,6 +231,12 @@ typedef struct ucg_builtin_op_step {
     /* Fields intended for non-contig datatypes */
     struct {
         int8_t                *contig_buffer;
+        size_t                 contig_length; /* borrowed length of contig_buffer */
+        int                    is_pack;       /* send buffer is packed, fragment by fragment */
+        uct_iov_t             *iov;           /* blocks of a strided send buffer, NULL to pack */
+        size_t                 max_iov;
+        size_t                 block_size;    /* packed length of a block */
+        size_t                 span;          /* registered length from send_buffer */
         void                  *pack_state;
         void                  *unpack_state;
         void                  *pack_state_recv;
@@ -208,6 +245,7 @@ typedef struct ucg_builtin_op_step {
     /* Fields intended for zero-copy */
     struct {
         uct_mem_h              memh;
+        ucg_builtin_rcache_region_t *region; /* < cache entry of memh, NULL if not cached */
         ucg_builtin_zcomp_t   *zcomp;
         uint32_t               num_store; /* < number of step's store zcopy messages */
     } zcopy;
@@ -215,13 +253,177 @@ typedef struct ucg_builtin_op_step {
     /* for dynamic sending, the array of zcopy is used */
     ucg_builtin_zcopy_info_t *zcopys;
 
+    /* Fields intended for rendezvous (the send buffer is registered as for zcopy) */
+    struct {
+        void                  *rkey_buffer; /* packed key of zcopy.memh, sent in the RTS */
+        size_t                 rkey_length;
+        ucg_group_member_index_t my_index;  /* lets the receiver check where the RTS is from */
+        uint32_t               fragments;   /* what a peer sends instead, if it does not use RTS */
+        uint16_t               recv_flags;  /* FRAGMENTED if it sends more than one fragment */
+        uct_ep_h               recv_ep;     /* the single peer an RTS comes from, NULL if none can */
+        size_t                 recv_frag_length; /* a read is handed over in fragments this long */
+    } rndv;
+
+    /* send buffer registrations on the memory domains of the other rails, held from the rcache */
+    struct {
+        void                  *buffer;   /* < buffer the handles are registered for */
+        size_t                 length;
+        unsigned               cnt;
+        uct_md_h               mds[UCG_BUILTIN_MAX_RAILS];
+        uct_mem_h              memhs[UCG_BUILTIN_MAX_RAILS];
+        ucg_builtin_rcache_region_t *regions[UCG_BUILTIN_MAX_RAILS]; /* < NULL if not cached */
+    } rail_reg;
+
     /* Terminal or Waypoint node of the allreduce tree-algo need to
        alloc the buffer to save the child rank value */
-    void                       *reduce_buff;
+    void                       *reduce_buff; /* borrowed from the scratch arena */
+    size_t                      rbuf_length; /* bytes of the reduce_buff */
     uint32_t                    rbuf_count; /* element count of the reduce_buff */
+    uint32_t                    rbuf_next;  /* next child position to reduce, in rank order */
+    uint8_t                    *rbuf_held;  /* whether a child arrived early and waits in reduce_buff */
+    uint32_t                   *rbuf_frags; /* fragments received per child, NULL if children send one message */
 } ucg_builtin_op_step_t;
 
+/*
+ * Per-group arena for temporary buffers on the datapath. Buffers are rounded up
+ * to a power-of-two size class, each class being a memory pool backed by huge
+ * pages when available. Pages are first touched, hence placed, by the thread
+ * progressing the group.
+ */
+#define UCG_BUILTIN_SCRATCH_MIN_SHIFT   12 /* 4KB */
+#define UCG_BUILTIN_SCRATCH_CHUNK_SHIFT 21 /* grow the small classes a huge page at a time */
+#define UCG_BUILTIN_SCRATCH_CLASSES     15 /* up to 64MB, larger buffers are not cached */
+
+typedef struct ucg_builtin_scratch_class {
+    ucs_mpool_t                 mp;
+    ucg_builtin_scratch_t      *scratch;
+    int                         is_init;
+} ucg_builtin_scratch_class_t;
+
+struct ucg_builtin_scratch {
+    ucg_builtin_scratch_class_t classes[UCG_BUILTIN_SCRATCH_CLASSES];
+    uint64_t                    alloc_cnt; /* memory taken from the system, flat in steady state */
+    uint64_t                    get_cnt;   /* buffers borrowed from the arena */
+};
+
+void ucg_builtin_scratch_init(ucg_builtin_scratch_t *scratch);
+void ucg_builtin_scratch_cleanup(ucg_builtin_scratch_t *scratch);
+void *ucg_builtin_scratch_get(ucg_builtin_scratch_t *scratch, size_t size);
+void ucg_builtin_scratch_put(ucg_builtin_scratch_t *scratch, void *buffer, size_t size);
+/* Returns a buffer held with its length, if any, and clears both */
+void ucg_builtin_scratch_release(ucg_builtin_scratch_t *scratch, int8_t **buffer_p, size_t *length_p);
+
+/*
+ * Per-group cache of zero-copy memory registrations, one interval tree per
+ * memory domain. Reusing a buffer finds its registration instead of paying for
+ * a new one; regions are invalidated when their memory is unmapped.
+ */
+#define UCG_BUILTIN_RCACHE_MAX_MDS 8
+
+struct ucg_builtin_rcache_region {
+    ucs_rcache_region_t         super;
+    uct_mem_h                   memh;
+};
+
+typedef struct ucg_builtin_rcache_md {
+    uct_md_h                    md;
+    ucs_rcache_t               *rcache; /* NULL if the memory hooks are unavailable */
+    ucg_builtin_rcache_t       *owner;
+} ucg_builtin_rcache_md_t;
+
+struct ucg_builtin_rcache {
+    ucg_builtin_rcache_md_t     mds[UCG_BUILTIN_RCACHE_MAX_MDS];
+    unsigned                    md_cnt;
+    int                         enable;
+    int                         is_cleanup;
+    uint64_t                    hit_cnt;   /* registrations found in the cache */
+    uint64_t                    miss_cnt;  /* registrations done on the memory domain */
+    uint64_t                    inval_cnt; /* regions dropped because their memory was unmapped */
+};
+
+void ucg_builtin_rcache_init(ucg_builtin_rcache_t *rcache, int enable);
+void ucg_builtin_rcache_cleanup(ucg_builtin_rcache_t *rcache);
+ucs_status_t ucg_builtin_rcache_reg(ucg_builtin_rcache_t *rcache, uct_md_h md, void *address,
+                                    size_t length, uct_mem_h *memh_p,
+                                    ucg_builtin_rcache_region_t **region_p);
+void ucg_builtin_rcache_dereg(ucg_builtin_rcache_t *rcache, uct_md_h md, uct_mem_h memh,
+                              ucg_builtin_rcache_region_t *region);
+
+/*
+ * Per-worker threads splitting native reductions of at least
+ * REDUCE_THREADS_THRESH bytes, pinned to the other CPUs of the rank.
+ */
+ucs_status_t ucg_builtin_rpool_create(unsigned thread_cnt, ucg_builtin_rpool_t **pool_p);
+void ucg_builtin_rpool_destroy(ucg_builtin_rpool_t *pool);
+void ucg_builtin_rpool_reduce(ucg_builtin_rpool_t *pool, ucg_builtin_reduce_kernel_f kernel,
+                              const void *src, void *dst, unsigned count, size_t dt_len);
+
+/*
+ * Per-group metrics, one record per collective type, algorithm and power-of-two
+ * message length. Operations find their record once, on creation, so the
+ * datapath only reads the clock and bumps counters.
+ */
+typedef struct ucg_builtin_metrics_entry {
+    ucs_list_link_t             list;
+    ucg_collective_metrics_t    stats;
+} ucg_builtin_metrics_entry_t;
+
+struct ucg_builtin_metrics {
+    ucs_list_link_t             entries;
+    unsigned                    entry_cnt;
+    int                         enable;
+    unsigned                    signal_cnt; /* dump signals seen by this group */
+    const char                 *file;       /* prefix of the dump files, empty to log them */
+};
+
+void ucg_builtin_metrics_init(ucg_builtin_metrics_t *metrics, int enable, int signo, const char *file);
+void ucg_builtin_metrics_cleanup(ucg_builtin_metrics_t *metrics);
+ucg_collective_metrics_t *ucg_builtin_metrics_get(ucg_builtin_metrics_t *metrics, coll_type_t coll_type,
+                                                  int algo, size_t length);
+void ucg_builtin_metrics_record(ucg_collective_metrics_t *stats, ucs_time_t start, size_t length,
+                                ucs_status_t status);
+unsigned ucg_builtin_metrics_query(const ucg_builtin_metrics_t *metrics, ucg_collective_metrics_t *out,
+                                   unsigned max);
+void ucg_builtin_metrics_print(const ucg_builtin_metrics_t *metrics, ucg_group_id_t group_id, FILE *stream);
+void ucg_builtin_metrics_dump(const ucg_builtin_metrics_t *metrics, ucg_group_id_t group_id);
+int ucg_builtin_metrics_is_signaled(ucg_builtin_metrics_t *metrics);
+uint64_t ucg_builtin_metrics_bucket_nsec(unsigned bucket);
+
+/*
+ * Timeline of the collectives, recorded per thread with UCX_BUILTIN_TRACE_FILE
+ * set, and written on worker cleanup as a Chrome trace with a track per rank.
+ */
+typedef enum ucg_builtin_trace_type {
+    UCG_BUILTIN_TRACE_TRIGGER,
+    UCG_BUILTIN_TRACE_SEND_START,
+    UCG_BUILTIN_TRACE_SEND_END,
+    UCG_BUILTIN_TRACE_RECV,
+    UCG_BUILTIN_TRACE_STEP_DONE,
+    UCG_BUILTIN_TRACE_RESEND,
+    UCG_BUILTIN_TRACE_COMPLETE,
+    UCG_BUILTIN_TRACE_LAST
+} ucg_builtin_trace_type_t;
+
+extern int ucg_builtin_trace_enable;
+
+void ucg_builtin_trace_init(const char *file, unsigned events, ucg_group_member_index_t rank);
+void ucg_builtin_trace_record(ucg_builtin_trace_type_t type, ucg_group_id_t group_id,
+                              ucg_coll_id_t coll_id, ucg_step_idx_t step_idx, uint64_t arg);
+void ucg_builtin_trace_write(void);
+
+#define UCG_BUILTIN_TRACE(_type, _group_id, _coll_id, _step_idx, _arg) do {        \
+        if (ucs_unlikely(ucg_builtin_trace_enable)) {                              \
+            ucg_builtin_trace_record(_type, _group_id, _coll_id, _step_idx, _arg); \
+        }                                                                          \
+    } while (0)
+
+/* The step's header holds the ids of the collective from its first execution on */
+#define UCG_BUILTIN_TRACE_STEP(_type, _step, _arg) \
+    UCG_BUILTIN_TRACE(_type, (_step)->am_header.group_id, (_step)->am_header.coll_id, \
+                      (_step)->am_header.step_idx, _arg)
+
 typedef struct ucg_builtin_comp_slot ucg_builtin_comp_slot_t;
+typedef struct ucg_builtin_slot_window ucg_builtin_slot_window_t;
 struct ucg_builtin_op {
     ucg_op_t                  super;
     unsigned                  opt_cnt;  /**< optimization count-down */
@@ -231,16 +433,52 @@ struct ucg_builtin_op {
     ucp_dt_generic_t         *send_dt;  /**< Generic send datatype (if non-contig) */
     ucp_dt_generic_t         *recv_dt;  /**< Generic receive datatype (if non-contig) */
     dt_span_f                 dtspan_f;
-    ucg_builtin_comp_slot_t  *slots;    /**< slots pointer, for faster initialization */
+    ucg_builtin_reduce_kernel_f reduce_kernel; /**< native reduction of contiguous data, NULL to call MPI */
+    ucg_builtin_reduce_kernel_f reduce_strided_kernel; /**< reduction of one block if recv_dt is strided */
+    ucg_dt_strided_t          reduce_strided; /**< block layout if recv_dt is strided */
+    ucg_dt_strided_t          send_strided; /**< block layout if send_dt is strided, block_cnt 0 if not */
+    ucg_builtin_scratch_t    *scratch;  /**< per-group arena for temporary buffers */
+    ucg_builtin_rcache_t     *rcache;   /**< per-group cache of zcopy registrations */
+    ucg_builtin_async_t      *async;    /**< progress thread of the worker, NULL if none */
+    ucg_builtin_rpool_t      *rpool;    /**< reduction threads of the worker, NULL if none */
+    unsigned                  rpool_min_cnt; /**< elements reduced by rpool, UINT_MAX if not used */
+    size_t                    rpool_dt_len; /**< element size of the reductions split by rpool */
+    ucg_collective_metrics_t *metrics;  /**< record of the group's metrics, NULL if disabled */
+    ucs_time_t                metrics_start; /**< start of the outstanding operation, 0 if none */
+    size_t                    metrics_len; /**< local message length */
+    ucg_builtin_slot_window_t *window;  /**< slots of the group, for faster initialization */
+    ucs_queue_elem_t          queue;    /**< member of the window's waiting operations */
+    ucg_coll_id_t             queued_id; /**< id of the operation waiting for its slot */
+    ucg_request_t            *queued_req; /**< user request of the waiting operation */
+    ucg_request_t             own_req;  /**< handed out to a waiting operation given no request, valid until discarded */
     ucs_list_link_t          *resend;   /**< resend pointer, for faster resend */
     ucs_status_t              inc_init_status;
     int8_t                   *temp_data_buffer; /**< temp buffer for reduce and scatter way-point*/
     int8_t                   *temp_data_buffer1;  /**< temp buffer for reduce and scatter way-point*/
     int8_t                   *temp_exchange_buffer;  /**< temp buffer exchange data */
     int8_t                   *temp_exchange_buffer1; /**< temp buffer exchange data */
+    size_t                    temp_data_length; /**< the temp buffers are borrowed from the scratch arena */
+    size_t                    temp_data_length1;
+    size_t                    temp_exchange_length;
+    size_t                    temp_exchange_length1;
     ucg_builtin_op_step_t     steps[];  /**< steps required to complete the operation */
 };
 
+/* Recorded once per operation, by whichever of its completions comes first */
+static UCS_F_ALWAYS_INLINE void ucg_builtin_metrics_complete(ucg_builtin_op_t *op, ucs_status_t status)
+{
+    if (ucs_unlikely(op->metrics_start != 0)) {
+        ucg_builtin_metrics_record(op->metrics, op->metrics_start, op->metrics_len, status);
+        op->metrics_start = 0;
+    }
+}
+
+#define UCG_BUILTIN_METRICS_INC(_op, _counter) do { \
+        if (ucs_unlikely((_op)->metrics != NULL)) {  \
+            (_op)->metrics->_counter++;               \
+        }                                             \
+    } while (0)
+
 /*
  * For every instance of the builtin collective operation (op), we create allocate
  * a request to handle completion and interaction with the user (via API).
@@ -281,14 +519,44 @@ ucs_status_t ucg_builtin_op_trigger(ucg_op_t *op,
                                     ucg_request_t **request);
 ucs_status_t ucg_builtin_msg_process(ucg_builtin_comp_slot_t *slot, ucg_builtin_request_t *req);
 
+int ucg_builtin_rndv_recv(ucg_builtin_request_t *req, uint64_t offset,
+                          const void *data, size_t length);
+void ucg_builtin_rndv_ack(ucg_builtin_request_t *req, const void *data, size_t length);
+
+static UCS_F_ALWAYS_INLINE int ucg_builtin_rndv_is_ctl(const ucg_builtin_op_step_t *step,
+                                                       ucg_offset_t remote_offset, ucg_offset_t ctl)
+{
+    return (step->flags & UCG_BUILTIN_OP_STEP_FLAG_RNDV) && (remote_offset & ctl);
+}
+
+/* Whether the sender chose rendezvous is only known from the message itself */
+static UCS_F_ALWAYS_INLINE int ucg_builtin_rndv_is_rts(const ucg_builtin_op_step_t *step,
+                                                       ucg_offset_t remote_offset)
+{
+    return (step->rndv.recv_ep != NULL) && (remote_offset & UCG_BUILTIN_RNDV_RTS);
+}
+
 void ucg_builtin_swap_net_recv(char *netdata, size_t length, size_t offset,
                                ucg_builtin_request_t *req);
 
 size_t ucg_builtin_get_dt_len(ucp_dt_generic_t *dt_gen);
 
 ucs_status_t ucg_builtin_step_alloc_pack_rank_buffer(ucg_builtin_op_step_t *step,
+                                                     ucg_builtin_scratch_t *scratch,
                                                      size_t buffer_length);
-void ucg_builtin_step_free_pack_rank_buffer(ucg_builtin_op_step_t *step);
+void ucg_builtin_step_free_pack_rank_buffer(ucg_builtin_op_step_t *step, ucg_builtin_scratch_t *scratch);
+
+void ucg_builtin_reduce_init(int native_reduce);
+ucg_builtin_reduce_kernel_f ucg_builtin_reduce_kernel_find(const ucg_group_params_t *group_params,
+                                                          void *mpi_op, void *mpi_dt, size_t dt_len);
+int ucg_builtin_reduce_is_exact(const ucg_group_params_t *group_params, void *mpi_op, void *mpi_dt);
+ucg_builtin_reduce_kernel_f ucg_builtin_reduce_strided_find(const ucg_group_params_t *group_params,
+                                                           void *mpi_op, void *mpi_dt, size_t packed_len,
+                                                           ucg_dt_strided_t *strided);
+void ucg_builtin_send_strided_find(const ucg_group_params_t *group_params, void *mpi_dt,
+                                   size_t packed_len, size_t extent, ucg_dt_strided_t *strided);
+void ucg_builtin_reduce_strided(const ucg_builtin_op_t *op, const void *src, void *dst, unsigned count,
+                                size_t packed_len, size_t extent);
 
 /*
  * Incoming messages are processed for one of the collective operations
@@ -310,6 +578,13 @@ typedef struct ucg_builtin_comp_desc {
     char                 data[0];
 } ucg_builtin_comp_desc_t;
 
+/*
+ * Messages arriving ahead of their step are stored in a small ring of queues,
+ * indexed by step. Matching or draining a step only looks at its own queue,
+ * which holds other messages only on wrap-around of the step or coll_id.
+ */
+#define UCG_BUILTIN_MSG_BUCKETS 16 /* power of 2 */
+
 struct ucg_builtin_comp_slot {
     ucg_builtin_request_t      req;
     union {
@@ -320,20 +595,51 @@ struct ucg_builtin_comp_slot {
         uint16_t               local_id;
     };
     ucg_builtin_comp_recv_cb_t cb;
-    ucs_list_link_t            msg_head;
+    ucs_list_link_t            msg_head[UCG_BUILTIN_MSG_BUCKETS]; /* early messages, per step */
+    unsigned                   msg_cnt;  /* stored messages, over all the steps */
     ucs_mpool_t               *mp; /* pool of @ref ucg_builtin_comp_desc_t */
 };
 
+static UCS_F_ALWAYS_INLINE ucs_list_link_t *ucg_builtin_slot_msgs(ucg_builtin_comp_slot_t *slot,
+                                                                  ucg_step_idx_t step_idx)
+{
+    return &slot->msg_head[step_idx & (UCG_BUILTIN_MSG_BUCKETS - 1)];
+}
+
 
 /*
- * This number sets the number of slots available for collective operations.
- * Each operation occupies a slot, so no more than this number of collectives
- * can take place at the same time. The slot is determined by the collective
- * operation id (ucg_coll_id_t) - modulo this constant. Translating "coll_id"
- * to slot# happens on every incoming packet, so this constant is best kept
- * determinable at compile time, and set to a power of 2.
+ * The slots of a group form a window over the collective operation ids. Each
+ * operation occupies a slot, determined by its id (ucg_coll_id_t) modulo the
+ * window size, a power of 2 so that translating "coll_id" to slot# on every
+ * incoming packet is a mask. Operations finding their slot busy wait in order,
+ * and make the window double - once the group is idle - up to its limit. The
+ * window never exceeds half of the coll_id space, so the ids of operations in
+ * flight never alias (the 64-bit header has no room for a wider coll_id).
  */
-#define UCG_BUILTIN_MAX_CONCURRENT_OPS 16
+#define UCG_BUILTIN_MAX_CONCURRENT_OPS 128
+#define UCG_BUILTIN_MAX_WINDOW_GROWTH  7   /* doublings from 1 to the largest window */
+
+struct ucg_builtin_slot_window {
+    ucg_builtin_comp_slot_t    *slots;
+    unsigned                    mask;     /* window size - 1 */
+    unsigned                    limit;    /* largest window size */
+    int                         is_grow;  /* an operation waited for its slot, double when idle */
+    ucs_mpool_t                *mp;       /* pool of @ref ucg_builtin_comp_desc_t */
+    ucs_queue_head_t            waiting;  /* operations waiting for their slot, by coll_id */
+    unsigned                    retired_cnt;
+    ucg_builtin_comp_slot_t    *retired[UCG_BUILTIN_MAX_WINDOW_GROWTH]; /* user requests may point there */
+};
+
+static UCS_F_ALWAYS_INLINE ucg_builtin_comp_slot_t *ucg_builtin_window_slot(ucg_builtin_slot_window_t *window,
+                                                                            ucg_coll_id_t coll_id)
+{
+    return &window->slots[coll_id & window->mask];
+}
+
+unsigned ucg_builtin_window_progress(ucg_builtin_slot_window_t *window);
+
+/* Completes the request of an operation waiting for its slot as canceled */
+void ucg_builtin_op_cancel_wait(ucg_builtin_op_t *builtin_op);
 
 #define UCG_BUILTIN_NUM_PROCS_DOUBLE 2
 
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Memory registration cache for zero-copy buffers
+ */
+
+#include <string.h>
+#include <sys/mman.h>
+#include <ucm/api/ucm.h>
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/sys.h>
+
+#include "builtin_ops.h"
+
+#define UCG_BUILTIN_RCACHE_EVENT_PRIORITY 1000 /* same as the UCT memory domains */
+
+static ucs_status_t ucg_builtin_rcache_mem_reg_cb(void *context, ucs_rcache_t *ucs_rcache, void *arg,
+                                                  ucs_rcache_region_t *rregion, uint16_t flags)
+{
+    ucg_builtin_rcache_md_t *entry = (ucg_builtin_rcache_md_t*)context;
+    ucg_builtin_rcache_region_t *region = ucs_derived_of(rregion, ucg_builtin_rcache_region_t);
+
+    entry->owner->miss_cnt++;
+    return uct_md_mem_reg(entry->md, (void*)region->super.super.start,
+                          region->super.super.end - region->super.super.start,
+                          UCT_MD_MEM_ACCESS_ALL, &region->memh);
+}
+
+static void ucg_builtin_rcache_mem_dereg_cb(void *context, ucs_rcache_t *ucs_rcache,
+                                            ucs_rcache_region_t *rregion)
+{
+    ucg_builtin_rcache_md_t *entry = (ucg_builtin_rcache_md_t*)context;
+    ucg_builtin_rcache_region_t *region = ucs_derived_of(rregion, ucg_builtin_rcache_region_t);
+
+    /* outside of cleanup, a region only goes away when its memory was released */
+    if (!entry->owner->is_cleanup) {
+        entry->owner->inval_cnt++;
+    }
+    (void) uct_md_mem_dereg(entry->md, region->memh);
+}
+
+static void ucg_builtin_rcache_dump_region_cb(void *context, ucs_rcache_t *ucs_rcache,
+                                              ucs_rcache_region_t *rregion, char *buf, size_t max)
+{
+    ucg_builtin_rcache_region_t *region = ucs_derived_of(rregion, ucg_builtin_rcache_region_t);
+
+    snprintf(buf, max, "memh %p", region->memh);
+}
+
+static ucs_rcache_ops_t ucg_builtin_rcache_ops = {
+    .mem_reg     = ucg_builtin_rcache_mem_reg_cb,
+    .mem_dereg   = ucg_builtin_rcache_mem_dereg_cb,
+    .dump_region = ucg_builtin_rcache_dump_region_cb
+};
+
+void ucg_builtin_rcache_init(ucg_builtin_rcache_t *rcache, int enable)
+{
+    rcache->md_cnt     = 0;
+    rcache->enable     = enable;
+    rcache->is_cleanup = 0;
+    rcache->hit_cnt    = 0;
+    rcache->miss_cnt   = 0;
+    rcache->inval_cnt  = 0;
+}
+
+void ucg_builtin_rcache_cleanup(ucg_builtin_rcache_t *rcache)
+{
+    unsigned md_idx;
+
+    rcache->is_cleanup = 1;
+    for (md_idx = 0; md_idx < rcache->md_cnt; md_idx++) {
+        if (rcache->mds[md_idx].rcache != NULL) {
+            ucs_rcache_destroy(rcache->mds[md_idx].rcache);
+        }
+    }
+    rcache->md_cnt = 0;
+
+    ucs_debug("registration cache %p: %lu hits, %lu misses, %lu invalidations",
+              rcache, rcache->hit_cnt, rcache->miss_cnt, rcache->inval_cnt);
+}
+
+/* Find the cache of a memory domain, creating it on first use. NULL to register directly. */
+static ucg_builtin_rcache_md_t *ucg_builtin_rcache_md(ucg_builtin_rcache_t *rcache, uct_md_h md,
+                                                      int is_create)
+{
+    ucg_builtin_rcache_md_t *entry;
+    ucs_rcache_params_t params;
+    ucs_status_t status;
+    unsigned md_idx;
+
+    if ((rcache == NULL) || !rcache->enable) {
+        return NULL;
+    }
+
+    for (md_idx = 0; md_idx < rcache->md_cnt; md_idx++) {
+        if (rcache->mds[md_idx].md == md) {
+            return (rcache->mds[md_idx].rcache != NULL) ? &rcache->mds[md_idx] : NULL;
+        }
+    }
+
+    if (!is_create || (rcache->md_cnt == UCG_BUILTIN_RCACHE_MAX_MDS)) {
+        return NULL;
+    }
+
+    entry         = &rcache->mds[rcache->md_cnt++];
+    entry->md     = md;
+    entry->owner  = rcache;
+    entry->rcache = NULL;
+
+    memset(&params, 0, sizeof(params));
+    params.region_struct_size = sizeof(ucg_builtin_rcache_region_t);
+    params.alignment          = ucs_get_page_size();
+    params.max_alignment      = ucs_get_page_size();
+    params.ucm_events         = UCM_EVENT_VM_UNMAPPED;
+    params.ucm_event_priority = UCG_BUILTIN_RCACHE_EVENT_PRIORITY;
+    params.context            = entry;
+    params.ops                = &ucg_builtin_rcache_ops;
+
+    /* without memory hooks there is no invalidation, so this memory domain is not cached */
+    status = ucs_rcache_create(&params, "ucg_builtin", NULL, &entry->rcache);
+    if (status != UCS_OK) {
+        ucs_debug("registration cache disabled for md %p: %s", md, ucs_status_string(status));
+        entry->rcache = NULL;
+        return NULL;
+    }
+
+    return entry;
+}
+
+ucs_status_t ucg_builtin_rcache_reg(ucg_builtin_rcache_t *rcache, uct_md_h md, void *address,
+                                    size_t length, uct_mem_h *memh_p,
+                                    ucg_builtin_rcache_region_t **region_p)
+{
+    ucg_builtin_rcache_md_t *entry = ucg_builtin_rcache_md(rcache, md, 1);
+    ucs_rcache_region_t *rregion;
+    uint64_t miss_cnt;
+    ucs_status_t status;
+
+    if (entry == NULL) {
+        *region_p = NULL;
+        return uct_md_mem_reg(md, address, length, UCT_MD_MEM_ACCESS_ALL, memh_p);
+    }
+
+    miss_cnt = rcache->miss_cnt;
+    status   = ucs_rcache_get(entry->rcache, address, length, PROT_READ | PROT_WRITE, NULL, &rregion);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    if (rcache->miss_cnt == miss_cnt) {
+        rcache->hit_cnt++;
+    }
+
+    *region_p = ucs_derived_of(rregion, ucg_builtin_rcache_region_t);
+    *memh_p   = (*region_p)->memh;
+    return UCS_OK;
+}
+
+void ucg_builtin_rcache_dereg(ucg_builtin_rcache_t *rcache, uct_md_h md, uct_mem_h memh,
+                              ucg_builtin_rcache_region_t *region)
+{
+    ucg_builtin_rcache_md_t *entry;
+
+    if (region == NULL) {
+        (void) uct_md_mem_dereg(md, memh);
+        return;
+    }
+
+    entry = ucg_builtin_rcache_md(rcache, md, 0);
+    ucs_assert(entry != NULL);
+    ucs_rcache_region_release(entry->rcache, &region->super);
+}
@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Native reduction kernels for predefined operations and datatypes
+ */
+
+#include <stdint.h>
+#include <ucs/debug/log.h>
+#include <ucs/sys/compiler_def.h>
+
+#if defined(__aarch64__)
+#include <sys/auxv.h>
+#endif
+
+#include "builtin_ops.h"
+
+/*
+ * Predefined (operation, datatype) pairs are reduced here instead of through the
+ * MPI callback. The kernels are plain loops the compiler vectorises; each loop
+ * is built once per instruction set and the widest one the CPU supports is
+ * selected at init. Half and bfloat16 are reduced in float and rounded back.
+ */
+
+#define UCG_BUILTIN_REDUCE_OP_SUM(_a, _b)  ((_a) + (_b))
+#define UCG_BUILTIN_REDUCE_OP_PROD(_a, _b) ((_a) * (_b))
+#define UCG_BUILTIN_REDUCE_OP_MIN(_a, _b)  (((_a) < (_b)) ? (_a) : (_b))
+#define UCG_BUILTIN_REDUCE_OP_MAX(_a, _b)  (((_a) > (_b)) ? (_a) : (_b))
+#define UCG_BUILTIN_REDUCE_OP_BAND(_a, _b) ((_a) & (_b))
+#define UCG_BUILTIN_REDUCE_OP_BOR(_a, _b)  ((_a) | (_b))
+#define UCG_BUILTIN_REDUCE_OP_BXOR(_a, _b) ((_a) ^ (_b))
+
+typedef union {
+    uint32_t u;
+    float    f;
+} ucg_builtin_reduce_f32_t;
+
+static UCS_F_ALWAYS_INLINE float ucg_builtin_half_to_float(uint16_t half)
+{
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exp  = (half >> 10) & 0x1f;
+    uint32_t mant = half & 0x3ff;
+    ucg_builtin_reduce_f32_t val;
+
+    if (exp == 0x1f) {
+        /* inf or nan */
+        val.u = sign | 0x7f800000 | (mant << 13);
+    } else if (exp != 0) {
+        val.u = sign | ((exp + (127 - 15)) << 23) | (mant << 13);
+    } else {
+        /* subnormal: mant * 2^-24 */
+        val.f  = (float)mant * 5.9604644775390625e-8f;
+        val.u |= sign;
+    }
+
+    return val.f;
+}
+
+static UCS_F_ALWAYS_INLINE uint16_t ucg_builtin_float_to_half(float value)
+{
+    ucg_builtin_reduce_f32_t val = {.f = value};
+    uint32_t sign = (val.u >> 16) & 0x8000;
+    uint32_t abs  = val.u & 0x7fffffff;
+
+    if (abs >= 0x7f800000) {
+        /* inf or nan, keep nan quiet */
+        return sign | 0x7c00 | ((abs > 0x7f800000) ? 0x200 : 0);
+    }
+
+    if (abs >= 0x477ff000) {
+        /* rounds beyond 65504 */
+        return sign | 0x7c00;
+    }
+
+    if (abs < 0x38800000) {
+        /* below 2^-14: adding 0.5 lines the mantissa up with the half subnormal ulp */
+        val.u  = abs;
+        val.f += 0.5f;
+        return sign | (uint16_t)(val.u - 0x3f000000);
+    }
+
+    /* rebias and round to nearest even */
+    abs += 0xfff + ((abs >> 13) & 1) - ((uint32_t)(127 - 15) << 23);
+    return sign | (uint16_t)(abs >> 13);
+}
+
+static UCS_F_ALWAYS_INLINE float ucg_builtin_bf16_to_float(uint16_t bf16)
+{
+    ucg_builtin_reduce_f32_t val = {.u = (uint32_t)bf16 << 16};
+    return val.f;
+}
+
+static UCS_F_ALWAYS_INLINE uint16_t ucg_builtin_float_to_bf16(float value)
+{
+    ucg_builtin_reduce_f32_t val = {.f = value};
+
+    if ((val.u & 0x7fffffff) > 0x7f800000) {
+        return (uint16_t)(val.u >> 16) | 0x40;
+    }
+
+    /* round to nearest even */
+    return (uint16_t)((val.u + 0x7fff + ((val.u >> 16) & 1)) >> 16);
+}
+
+#define UCG_BUILTIN_REDUCE_LOOP(_isa, _attr, _op, _dt, _type) \
+    static _attr void ucg_builtin_reduce_##_isa##_##_op##_##_dt(const void *src, void *dst, unsigned count) \
+    { \
+        const _type *in = (const _type*)src; \
+        _type *inout    = (_type*)dst; \
+        unsigned idx; \
+        for (idx = 0; idx < count; idx++) { \
+            inout[idx] = UCG_BUILTIN_REDUCE_OP_##_op(in[idx], inout[idx]); \
+        } \
+    }
+
+#define UCG_BUILTIN_REDUCE_LOOP_16BIT(_isa, _attr, _op, _dt, _to_float, _from_float) \
+    static _attr void ucg_builtin_reduce_##_isa##_##_op##_##_dt(const void *src, void *dst, unsigned count) \
+    { \
+        const uint16_t *in = (const uint16_t*)src; \
+        uint16_t *inout    = (uint16_t*)dst; \
+        unsigned idx; \
+        for (idx = 0; idx < count; idx++) { \
+            inout[idx] = _from_float(UCG_BUILTIN_REDUCE_OP_##_op(_to_float(in[idx]), _to_float(inout[idx]))); \
+        } \
+    }
+
+#define UCG_BUILTIN_REDUCE_INT_KERNELS(_isa, _attr, _dt, _type) \
+    UCG_BUILTIN_REDUCE_LOOP(_isa, _attr, SUM,  _dt, _type) \
+    UCG_BUILTIN_REDUCE_LOOP(_isa, _attr, PROD, _dt, _type) \
+    UCG_BUILTIN_REDUCE_LOOP(_isa, _attr, MIN,  _dt, _type) \
+    UCG_BUILTIN_REDUCE_LOOP(_isa, _attr, MAX,  _dt, _type) \
+    UCG_BUILTIN_REDUCE_LOOP(_isa, _attr, BAND, _dt, _type) \
+    UCG_BUILTIN_REDUCE_LOOP(_isa, _attr, BOR,  _dt, _type) \
+    UCG_BUILTIN_REDUCE_LOOP(_isa, _attr, BXOR, _dt, _type)
+
+#define UCG_BUILTIN_REDUCE_FLOAT_KERNELS(_isa, _attr, _dt, _type) \
+    UCG_BUILTIN_REDUCE_LOOP(_isa, _attr, SUM,  _dt, _type) \
+    UCG_BUILTIN_REDUCE_LOOP(_isa, _attr, PROD, _dt, _type) \
+    UCG_BUILTIN_REDUCE_LOOP(_isa, _attr, MIN,  _dt, _type) \
+    UCG_BUILTIN_REDUCE_LOOP(_isa, _attr, MAX,  _dt, _type)
+
+#define UCG_BUILTIN_REDUCE_16BIT_KERNELS(_isa, _attr, _dt, _to_float, _from_float) \
+    UCG_BUILTIN_REDUCE_LOOP_16BIT(_isa, _attr, SUM,  _dt, _to_float, _from_float) \
+    UCG_BUILTIN_REDUCE_LOOP_16BIT(_isa, _attr, PROD, _dt, _to_float, _from_float) \
+    UCG_BUILTIN_REDUCE_LOOP_16BIT(_isa, _attr, MIN,  _dt, _to_float, _from_float) \
+    UCG_BUILTIN_REDUCE_LOOP_16BIT(_isa, _attr, MAX,  _dt, _to_float, _from_float)
+
+#define UCG_BUILTIN_REDUCE_ENTRY(_isa, _op, _dt) \
+    [UCG_OP_##_op][UCG_DT_##_dt] = ucg_builtin_reduce_##_isa##_##_op##_##_dt
+
+#define UCG_BUILTIN_REDUCE_INT_ENTRIES(_isa, _dt) \
+    UCG_BUILTIN_REDUCE_ENTRY(_isa, SUM,  _dt), \
+    UCG_BUILTIN_REDUCE_ENTRY(_isa, PROD, _dt), \
+    UCG_BUILTIN_REDUCE_ENTRY(_isa, MIN,  _dt), \
+    UCG_BUILTIN_REDUCE_ENTRY(_isa, MAX,  _dt), \
+    UCG_BUILTIN_REDUCE_ENTRY(_isa, BAND, _dt), \
+    UCG_BUILTIN_REDUCE_ENTRY(_isa, BOR,  _dt), \
+    UCG_BUILTIN_REDUCE_ENTRY(_isa, BXOR, _dt)
+
+#define UCG_BUILTIN_REDUCE_FLOAT_ENTRIES(_isa, _dt) \
+    UCG_BUILTIN_REDUCE_ENTRY(_isa, SUM,  _dt), \
+    UCG_BUILTIN_REDUCE_ENTRY(_isa, PROD, _dt), \
+    UCG_BUILTIN_REDUCE_ENTRY(_isa, MIN,  _dt), \
+    UCG_BUILTIN_REDUCE_ENTRY(_isa, MAX,  _dt)
+
+/* All the kernels for one instruction set, and their table */
+#define UCG_BUILTIN_REDUCE_ISA(_isa, _attr) \
+    UCG_BUILTIN_REDUCE_INT_KERNELS(_isa, _attr, INT8,   int8_t) \
+    UCG_BUILTIN_REDUCE_INT_KERNELS(_isa, _attr, UINT8,  uint8_t) \
+    UCG_BUILTIN_REDUCE_INT_KERNELS(_isa, _attr, INT16,  int16_t) \
+    UCG_BUILTIN_REDUCE_INT_KERNELS(_isa, _attr, UINT16, uint16_t) \
+    UCG_BUILTIN_REDUCE_INT_KERNELS(_isa, _attr, INT32,  int32_t) \
+    UCG_BUILTIN_REDUCE_INT_KERNELS(_isa, _attr, UINT32, uint32_t) \
+    UCG_BUILTIN_REDUCE_INT_KERNELS(_isa, _attr, INT64,  int64_t) \
+    UCG_BUILTIN_REDUCE_INT_KERNELS(_isa, _attr, UINT64, uint64_t) \
+    UCG_BUILTIN_REDUCE_FLOAT_KERNELS(_isa, _attr, FLOAT,  float) \
+    UCG_BUILTIN_REDUCE_FLOAT_KERNELS(_isa, _attr, DOUBLE, double) \
+    UCG_BUILTIN_REDUCE_16BIT_KERNELS(_isa, _attr, FLOAT16, ucg_builtin_half_to_float, ucg_builtin_float_to_half) \
+    UCG_BUILTIN_REDUCE_16BIT_KERNELS(_isa, _attr, BFLOAT16, ucg_builtin_bf16_to_float, ucg_builtin_float_to_bf16) \
+    \
+    static const ucg_builtin_reduce_kernel_f ucg_builtin_reduce_table_##_isa[UCG_OP_NUMS][UCG_DT_NUMS] = { \
+        UCG_BUILTIN_REDUCE_INT_ENTRIES(_isa, INT8), \
+        UCG_BUILTIN_REDUCE_INT_ENTRIES(_isa, UINT8), \
+        UCG_BUILTIN_REDUCE_INT_ENTRIES(_isa, INT16), \
+        UCG_BUILTIN_REDUCE_INT_ENTRIES(_isa, UINT16), \
+        UCG_BUILTIN_REDUCE_INT_ENTRIES(_isa, INT32), \
+        UCG_BUILTIN_REDUCE_INT_ENTRIES(_isa, UINT32), \
+        UCG_BUILTIN_REDUCE_INT_ENTRIES(_isa, INT64), \
+        UCG_BUILTIN_REDUCE_INT_ENTRIES(_isa, UINT64), \
+        UCG_BUILTIN_REDUCE_FLOAT_ENTRIES(_isa, FLOAT), \
+        UCG_BUILTIN_REDUCE_FLOAT_ENTRIES(_isa, DOUBLE), \
+        UCG_BUILTIN_REDUCE_FLOAT_ENTRIES(_isa, FLOAT16), \
+        UCG_BUILTIN_REDUCE_FLOAT_ENTRIES(_isa, BFLOAT16), \
+    };
+
+/* baseline: SSE2 on x86_64, NEON on aarch64 */
+UCG_BUILTIN_REDUCE_ISA(base, )
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define UCG_BUILTIN_REDUCE_X86 1
+UCG_BUILTIN_REDUCE_ISA(avx2, __attribute__((target("avx2"))))
+UCG_BUILTIN_REDUCE_ISA(avx512, __attribute__((target("avx512f,avx512bw"))))
+#endif
+
+#if defined(__aarch64__) && defined(__GNUC__) && (__GNUC__ >= 10) && defined(HWCAP_SVE)
+#define UCG_BUILTIN_REDUCE_SVE 1
+UCG_BUILTIN_REDUCE_ISA(sve, __attribute__((target("+sve"))))
+#endif
+
+static const size_t ucg_builtin_reduce_dt_size[UCG_DT_NUMS] = {
+    [UCG_DT_INT8]     = sizeof(int8_t),
+    [UCG_DT_UINT8]    = sizeof(uint8_t),
+    [UCG_DT_INT16]    = sizeof(int16_t),
+    [UCG_DT_UINT16]   = sizeof(uint16_t),
+    [UCG_DT_INT32]    = sizeof(int32_t),
+    [UCG_DT_UINT32]   = sizeof(uint32_t),
+    [UCG_DT_INT64]    = sizeof(int64_t),
+    [UCG_DT_UINT64]   = sizeof(uint64_t),
+    [UCG_DT_FLOAT]    = sizeof(float),
+    [UCG_DT_DOUBLE]   = sizeof(double),
+    [UCG_DT_FLOAT16]  = sizeof(uint16_t),
+    [UCG_DT_BFLOAT16] = sizeof(uint16_t),
+};
+
+static const ucg_builtin_reduce_kernel_f (*ucg_builtin_reduce_table)[UCG_DT_NUMS] = NULL;
+
+void ucg_builtin_reduce_init(int native_reduce)
+{
+    const char *isa = "base";
+
+    if (!native_reduce) {
+        ucg_builtin_reduce_table = NULL;
+        ucs_info("native reduction disabled, using the MPI reduce callback");
+        return;
+    }
+
+    ucg_builtin_reduce_table = ucg_builtin_reduce_table_base;
+#ifdef UCG_BUILTIN_REDUCE_X86
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        ucg_builtin_reduce_table = ucg_builtin_reduce_table_avx512;
+        isa = "avx512";
+    } else if (__builtin_cpu_supports("avx2")) {
+        ucg_builtin_reduce_table = ucg_builtin_reduce_table_avx2;
+        isa = "avx2";
+    }
+#elif defined(UCG_BUILTIN_REDUCE_SVE)
+    if (getauxval(AT_HWCAP) & HWCAP_SVE) {
+        ucg_builtin_reduce_table = ucg_builtin_reduce_table_sve;
+        isa = "sve";
+    }
+#endif
+
+    ucs_debug("native reduction kernels: %s", isa);
+}
+
+ucg_builtin_reduce_kernel_f ucg_builtin_reduce_kernel_find(const ucg_group_params_t *group_params,
+                                                          void *mpi_op, void *mpi_dt, size_t dt_len)
+{
+    int op, dt;
+
+    if ((ucg_builtin_reduce_table == NULL) || (group_params->get_operate_param_f == NULL) || (mpi_op == NULL)) {
+        return NULL;
+    }
+
+    if ((group_params->mpi_dt_is_predefine != NULL) && !group_params->mpi_dt_is_predefine(mpi_dt)) {
+        return NULL;
+    }
+
+    /* user-defined operations have no code and keep the MPI callback */
+    if (group_params->get_operate_param_f(mpi_op, mpi_dt, &op, &dt) != 0) {
+        return NULL;
+    }
+
+    if ((op < 0) || (op >= UCG_OP_NUMS) || (dt < 0) || (dt >= UCG_DT_NUMS) ||
+        (ucg_builtin_reduce_dt_size[dt] != dt_len)) {
+        return NULL;
+    }
+
+    return ucg_builtin_reduce_table[op][dt];
+}
+
+/* Integer and bitwise reductions give the same bits in any order, floating-point ones do not */
+int ucg_builtin_reduce_is_exact(const ucg_group_params_t *group_params, void *mpi_op, void *mpi_dt)
+{
+    int op, dt;
+
+    if ((group_params->get_operate_param_f == NULL) || (mpi_op == NULL) ||
+        ((group_params->mpi_dt_is_predefine != NULL) && !group_params->mpi_dt_is_predefine(mpi_dt)) ||
+        (group_params->get_operate_param_f(mpi_op, mpi_dt, &op, &dt) != 0)) {
+        return 0;
+    }
+
+    return (op >= 0) && (op < UCG_OP_NUMS) && (dt >= UCG_DT_INT8) && (dt <= UCG_DT_UINT64);
+}
+
+/*
+ * A strided datatype is reduced block by block straight from the packed payload
+ * into the receive buffer, instead of unpacking it into a temporary buffer first.
+ */
+ucg_builtin_reduce_kernel_f ucg_builtin_reduce_strided_find(const ucg_group_params_t *group_params,
+                                                           void *mpi_op, void *mpi_dt, size_t packed_len,
+                                                           ucg_dt_strided_t *strided)
+{
+    size_t elem_cnt;
+
+    if ((group_params->mpi_datatype_strided == NULL) ||
+        (group_params->mpi_datatype_strided(mpi_dt, strided) != 0)) {
+        return NULL;
+    }
+
+    elem_cnt = (size_t)strided->block_cnt * strided->block_len;
+    if ((elem_cnt == 0) || (packed_len % elem_cnt != 0)) {
+        return NULL;
+    }
+
+    return ucg_builtin_reduce_kernel_find(group_params, mpi_op, strided->base_dt, packed_len / elem_cnt);
+}
+
+/* The blocks of a strided send layout, sent in place when they do not overlap */
+void ucg_builtin_send_strided_find(const ucg_group_params_t *group_params, void *mpi_dt,
+                                   size_t packed_len, size_t extent, ucg_dt_strided_t *strided)
+{
+    if ((group_params->mpi_datatype_strided == NULL) ||
+        (group_params->mpi_datatype_strided(mpi_dt, strided) != 0) ||
+        (strided->block_cnt == 0) || (packed_len == 0) || (packed_len % strided->block_cnt != 0) ||
+        (strided->block_disp < 0) || (extent == 0) ||
+        ((strided->block_cnt > 1) && (strided->block_stride < (ptrdiff_t)(packed_len / strided->block_cnt)))) {
+        strided->block_cnt = 0;
+    }
+}
+
+void ucg_builtin_reduce_strided(const ucg_builtin_op_t *op, const void *src, void *dst, unsigned count,
+                                size_t packed_len, size_t extent)
+{
+    const ucg_dt_strided_t *strided = &op->reduce_strided;
+    size_t block_size = packed_len / strided->block_cnt;
+    const int8_t *in  = (const int8_t*)src;
+    int8_t *out;
+    unsigned idx, block_idx;
+
+    for (idx = 0; idx < count; idx++) {
+        out = (int8_t*)dst + idx * extent + strided->block_disp;
+        for (block_idx = 0; block_idx < strided->block_cnt; block_idx++) {
+            op->reduce_strided_kernel(in, out, strided->block_len);
+            in  += block_size;
+            out += strided->block_stride;
+        }
+    }
+}
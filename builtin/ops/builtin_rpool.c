@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Thread pool splitting large native reductions
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <ucs/arch/atomic.h>
+#include <ucs/arch/cpu.h>
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/math.h>
+#include <ucs/sys/sys.h>
+
+#include "builtin_ops.h"
+
+/*
+ * A reduction is cut into one part per thread, plus one for the caller. Every
+ * thread takes part in every job, so a job never starts before all threads are
+ * done with the previous one, and the job fields are stable while they run.
+ */
+struct ucg_builtin_rpool {
+    pthread_mutex_t             lock;
+    pthread_cond_t              cond;
+    uint64_t                    job_sn;     /* bumped to start a job */
+    int                         is_stop;
+    ucg_builtin_reduce_kernel_f kernel;
+    const char                 *src;
+    char                       *dst;
+    unsigned                    count;
+    size_t                      dt_len;
+    uint32_t                    done_cnt;   /* threads done with the job */
+    uint32_t                    start_cnt;  /* threads started, to number their parts */
+    uint64_t                    job_cnt;
+    unsigned                    thread_cnt;
+    pthread_t                   threads[0];
+};
+
+static void ucg_builtin_rpool_part(const ucg_builtin_rpool_t *pool, ucg_builtin_reduce_kernel_f kernel,
+                                   const char *src, char *dst, unsigned count, size_t dt_len,
+                                   unsigned part_idx)
+{
+    unsigned part_len = (count + pool->thread_cnt) / (pool->thread_cnt + 1);
+    size_t start      = (size_t)part_idx * part_len;
+
+    if (start < count) {
+        kernel(src + start * dt_len, dst + start * dt_len, ucs_min(part_len, count - start));
+    }
+}
+
+static void *ucg_builtin_rpool_thread(void *arg)
+{
+    ucg_builtin_rpool_t *pool = (ucg_builtin_rpool_t*)arg;
+    unsigned part_idx         = ucs_atomic_fadd32(&pool->start_cnt, 1) + 1;
+    uint64_t job_sn           = 0;
+    ucg_builtin_reduce_kernel_f kernel;
+    const char *src;
+    unsigned count;
+    size_t dt_len;
+    char *dst;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while ((pool->job_sn == job_sn) && !pool->is_stop) {
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        }
+        if (pool->is_stop) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        job_sn = pool->job_sn;
+        kernel = pool->kernel;
+        src    = pool->src;
+        dst    = pool->dst;
+        count  = pool->count;
+        dt_len = pool->dt_len;
+        pthread_mutex_unlock(&pool->lock);
+
+        ucg_builtin_rpool_part(pool, kernel, src, dst, count, dt_len, part_idx);
+        ucs_memory_cpu_store_fence();
+        ucs_atomic_add32(&pool->done_cnt, 1);
+    }
+}
+
+static void ucg_builtin_rpool_stop(ucg_builtin_rpool_t *pool, unsigned thread_cnt)
+{
+    unsigned thread_idx;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->is_stop = 1;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (thread_idx = 0; thread_idx < thread_cnt; thread_idx++) {
+        pthread_join(pool->threads[thread_idx], NULL);
+    }
+
+    pthread_cond_destroy(&pool->cond);
+    pthread_mutex_destroy(&pool->lock);
+    ucs_free(pool);
+}
+
+/* Next CPU of the set after the given one, other than the caller's */
+static int ucg_builtin_rpool_next_cpu(const ucs_sys_cpuset_t *cpuset, int cpu, int cpu_self)
+{
+    do {
+        cpu = (cpu + 1) % CPU_SETSIZE;
+    } while (!CPU_ISSET(cpu, cpuset) || (cpu == cpu_self));
+
+    return cpu;
+}
+
+ucs_status_t ucg_builtin_rpool_create(unsigned thread_cnt, ucg_builtin_rpool_t **pool_p)
+{
+    int cpu_self = sched_getcpu();
+    int cpu      = ucs_max(cpu_self, 0);
+    ucs_sys_cpuset_t cpuset, thread_cpuset;
+    ucg_builtin_rpool_t *pool;
+    unsigned thread_idx;
+    pthread_attr_t attr;
+    int ret;
+
+    /* the threads run on the rank's other CPUs, none if it is bound to a single one */
+    if ((ucs_sys_getaffinity(&cpuset) != 0) ||
+        (CPU_COUNT(&cpuset) - ((cpu_self >= 0) && CPU_ISSET(cpu_self, &cpuset)) <= 0)) {
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    pool = ucs_calloc(1, sizeof(*pool) + thread_cnt * sizeof(pthread_t), "ucg_builtin_rpool");
+    if (pool == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    pool->thread_cnt = thread_cnt;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+
+    for (thread_idx = 0; thread_idx < thread_cnt; thread_idx++) {
+        cpu = ucg_builtin_rpool_next_cpu(&cpuset, cpu, cpu_self);
+        CPU_ZERO(&thread_cpuset);
+        CPU_SET(cpu, &thread_cpuset);
+
+        pthread_attr_init(&attr);
+        pthread_attr_setaffinity_np(&attr, sizeof(thread_cpuset), &thread_cpuset);
+        ret = pthread_create(&pool->threads[thread_idx], &attr, ucg_builtin_rpool_thread, pool);
+        pthread_attr_destroy(&attr);
+        if (ret != 0) {
+            ucg_builtin_rpool_stop(pool, thread_idx);
+            return UCS_ERR_IO_ERROR;
+        }
+        ucs_debug("reduction pool %p: thread %u on cpu %d", pool, thread_idx, cpu);
+    }
+
+    *pool_p = pool;
+    return UCS_OK;
+}
+
+void ucg_builtin_rpool_destroy(ucg_builtin_rpool_t *pool)
+{
+    ucs_debug("reduction pool %p: %lu reductions split over %u threads",
+              pool, pool->job_cnt, pool->thread_cnt);
+    ucg_builtin_rpool_stop(pool, pool->thread_cnt);
+}
+
+void ucg_builtin_rpool_reduce(ucg_builtin_rpool_t *pool, ucg_builtin_reduce_kernel_f kernel,
+                              const void *src, void *dst, unsigned count, size_t dt_len)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->kernel   = kernel;
+    pool->src      = (const char*)src;
+    pool->dst      = (char*)dst;
+    pool->count    = count;
+    pool->dt_len   = dt_len;
+    pool->done_cnt = 0;
+    pool->job_sn++;
+    pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    ucg_builtin_rpool_part(pool, kernel, (const char*)src, (char*)dst, count, dt_len, 0);
+
+    /* the threads are busy with their own parts, and finish about when we do */
+    while (__atomic_load_n(&pool->done_cnt, __ATOMIC_ACQUIRE) < pool->thread_cnt) {
+        ucs_arch_wait_mem(&pool->done_cnt);
+    }
+    pool->job_cnt++;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Scratch-buffer arena for the collective datapath
+ */
+
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/math.h>
+#include <ucs/sys/stubs.h>
+
+#include "builtin_ops.h"
+
+static ucs_status_t ucg_builtin_scratch_chunk_alloc(ucs_mpool_t *mp, size_t *size_p, void **chunk_p)
+{
+    ucg_builtin_scratch_class_t *sclass = ucs_container_of(mp, ucg_builtin_scratch_class_t, mp);
+
+    sclass->scratch->alloc_cnt++;
+    return ucs_mpool_hugetlb_malloc(mp, size_p, chunk_p);
+}
+
+static ucs_mpool_ops_t ucg_builtin_scratch_mpool_ops = {
+    .chunk_alloc   = ucg_builtin_scratch_chunk_alloc,
+    .chunk_release = ucs_mpool_hugetlb_free,
+    .obj_init      = ucs_empty_function,
+    .obj_cleanup   = ucs_empty_function
+};
+
+static UCS_F_ALWAYS_INLINE unsigned ucg_builtin_scratch_class_idx(size_t size)
+{
+    if (size <= UCS_BIT(UCG_BUILTIN_SCRATCH_MIN_SHIFT)) {
+        return 0;
+    }
+
+    return ucs_ilog2(size - 1) + 1 - UCG_BUILTIN_SCRATCH_MIN_SHIFT;
+}
+
+void ucg_builtin_scratch_init(ucg_builtin_scratch_t *scratch)
+{
+    unsigned class_idx;
+
+    for (class_idx = 0; class_idx < UCG_BUILTIN_SCRATCH_CLASSES; class_idx++) {
+        scratch->classes[class_idx].scratch = scratch;
+        scratch->classes[class_idx].is_init = 0;
+    }
+    scratch->alloc_cnt = 0;
+    scratch->get_cnt   = 0;
+}
+
+void ucg_builtin_scratch_cleanup(ucg_builtin_scratch_t *scratch)
+{
+    unsigned class_idx;
+
+    for (class_idx = 0; class_idx < UCG_BUILTIN_SCRATCH_CLASSES; class_idx++) {
+        if (scratch->classes[class_idx].is_init) {
+            ucs_mpool_cleanup(&scratch->classes[class_idx].mp, 1);
+            scratch->classes[class_idx].is_init = 0;
+        }
+    }
+
+    ucs_debug("scratch arena %p: %lu buffers borrowed, %lu system allocations",
+              scratch, scratch->get_cnt, scratch->alloc_cnt);
+}
+
+void *ucg_builtin_scratch_get(ucg_builtin_scratch_t *scratch, size_t size)
+{
+    unsigned class_idx = ucg_builtin_scratch_class_idx(size);
+    unsigned shift = class_idx + UCG_BUILTIN_SCRATCH_MIN_SHIFT;
+    ucg_builtin_scratch_class_t *sclass;
+    ucs_status_t status;
+
+    scratch->get_cnt++;
+    if (ucs_unlikely(class_idx >= UCG_BUILTIN_SCRATCH_CLASSES)) {
+        scratch->alloc_cnt++;
+        return ucs_malloc(size, "ucg scratch buffer");
+    }
+
+    sclass = &scratch->classes[class_idx];
+    if (ucs_unlikely(!sclass->is_init)) {
+        status = ucs_mpool_init(&sclass->mp, 0, UCS_BIT(shift), 0, UCS_SYS_CACHE_LINE_SIZE,
+                                (shift < UCG_BUILTIN_SCRATCH_CHUNK_SHIFT) ?
+                                UCS_BIT(UCG_BUILTIN_SCRATCH_CHUNK_SHIFT - shift) : 1,
+                                UINT_MAX, &ucg_builtin_scratch_mpool_ops, "ucg_builtin_scratch_mp");
+        if (status != UCS_OK) {
+            return NULL;
+        }
+        sclass->is_init = 1;
+    }
+
+    return ucs_mpool_get_inline(&sclass->mp);
+}
+
+void ucg_builtin_scratch_put(ucg_builtin_scratch_t *scratch, void *buffer, size_t size)
+{
+    if (buffer == NULL) {
+        return;
+    }
+
+    if (ucs_unlikely(ucg_builtin_scratch_class_idx(size) >= UCG_BUILTIN_SCRATCH_CLASSES)) {
+        ucs_free(buffer);
+        return;
+    }
+
+    ucs_mpool_put_inline(buffer);
+}
+
+void ucg_builtin_scratch_release(ucg_builtin_scratch_t *scratch, int8_t **buffer_p, size_t *length_p)
+{
+    ucg_builtin_scratch_put(scratch, *buffer_p, *length_p);
+    *buffer_p = NULL;
+    *length_p = 0;
+}
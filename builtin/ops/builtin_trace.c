@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Timeline of the collective steps, written as a Chrome trace
+ */
+
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/math.h>
+#include <ucs/sys/string.h>
+#include <ucs/sys/sys.h>
+
+#include "builtin_ops.h"
+
+/*
+ * Each thread records into its own ring, so recording takes no lock: only the
+ * first event of a thread does, to add its ring to the list. Rings keep the
+ * latest events, and are read when the trace is written on worker cleanup -
+ * each cleanup rewrites the whole file.
+ */
+typedef struct ucg_builtin_trace_event {
+    ucs_time_t                  time;
+    uint64_t                    arg;      /* length, offset or status, depending on the type */
+    ucg_group_id_t              group_id;
+    ucg_coll_id_t               coll_id;
+    ucg_step_idx_t              step_idx;
+    uint8_t                     type;
+} ucg_builtin_trace_event_t;
+
+typedef struct ucg_builtin_trace_ring {
+    ucs_list_link_t             list;
+    unsigned                    tid;
+    uint64_t                    head;     /* events recorded so far */
+    uint64_t                    mask;
+    ucg_builtin_trace_event_t   events[0];
+} ucg_builtin_trace_ring_t;
+
+static const char *ucg_builtin_trace_names[UCG_BUILTIN_TRACE_LAST] = {
+    [UCG_BUILTIN_TRACE_TRIGGER]    = "collective",
+    [UCG_BUILTIN_TRACE_SEND_START] = "send start",
+    [UCG_BUILTIN_TRACE_SEND_END]   = "send end",
+    [UCG_BUILTIN_TRACE_RECV]       = "recv",
+    [UCG_BUILTIN_TRACE_STEP_DONE]  = "step done",
+    [UCG_BUILTIN_TRACE_RESEND]     = "resend",
+    [UCG_BUILTIN_TRACE_COMPLETE]   = "collective"
+};
+
+int ucg_builtin_trace_enable = 0;
+
+static struct {
+    pthread_mutex_t             lock;     /* for the list of rings */
+    ucs_list_link_t             rings;
+    unsigned                    ring_cnt;
+    uint64_t                    ring_size;
+    char                        file[PATH_MAX];
+    ucg_group_member_index_t    rank;
+    double                      base_usec; /* wall clock at base_time, to merge the ranks */
+    ucs_time_t                  base_time;
+} ucg_builtin_trace = {
+    .lock  = PTHREAD_MUTEX_INITIALIZER,
+    .rings = UCS_LIST_INITIALIZER(&ucg_builtin_trace.rings, &ucg_builtin_trace.rings)
+};
+
+static __thread ucg_builtin_trace_ring_t *ucg_builtin_trace_ring = NULL;
+
+void ucg_builtin_trace_init(const char *file, unsigned events, ucg_group_member_index_t rank)
+{
+    struct timeval tv;
+
+    if (ucg_builtin_trace_enable || (file[0] == '\0')) {
+        return;
+    }
+
+    gettimeofday(&tv, NULL);
+    ucg_builtin_trace.base_time = ucs_get_time();
+    ucg_builtin_trace.base_usec = (tv.tv_sec * 1e6) + tv.tv_usec;
+    ucg_builtin_trace.ring_size = ucs_roundup_pow2(ucs_max(events, 1));
+    ucg_builtin_trace.rank      = rank;
+    ucs_strncpy_zero(ucg_builtin_trace.file, file, sizeof(ucg_builtin_trace.file));
+    ucg_builtin_trace_enable    = 1;
+}
+
+static ucg_builtin_trace_ring_t *ucg_builtin_trace_ring_create(void)
+{
+    ucg_builtin_trace_ring_t *ring;
+
+    ring = ucs_malloc(sizeof(*ring) + ucg_builtin_trace.ring_size * sizeof(ucg_builtin_trace_event_t),
+                      "ucg_builtin_trace_ring");
+    if (ring == NULL) {
+        return NULL;
+    }
+
+    ring->head = 0;
+    ring->mask = ucg_builtin_trace.ring_size - 1;
+
+    pthread_mutex_lock(&ucg_builtin_trace.lock);
+    ring->tid = ucg_builtin_trace.ring_cnt++;
+    ucs_list_add_tail(&ucg_builtin_trace.rings, &ring->list);
+    pthread_mutex_unlock(&ucg_builtin_trace.lock);
+    return ring;
+}
+
+void ucg_builtin_trace_record(ucg_builtin_trace_type_t type, ucg_group_id_t group_id,
+                              ucg_coll_id_t coll_id, ucg_step_idx_t step_idx, uint64_t arg)
+{
+    ucg_builtin_trace_ring_t *ring = ucg_builtin_trace_ring;
+    ucg_builtin_trace_event_t *event;
+
+    if (ucs_unlikely(ring == NULL)) {
+        ring = ucg_builtin_trace_ring = ucg_builtin_trace_ring_create();
+        if (ring == NULL) {
+            return;
+        }
+    }
+
+    event           = &ring->events[ring->head & ring->mask];
+    event->time     = ucs_get_time();
+    event->arg      = arg;
+    event->group_id = group_id;
+    event->coll_id  = coll_id;
+    event->step_idx = step_idx;
+    event->type     = type;
+    ring->head++;
+}
+
+static void ucg_builtin_trace_write_event(FILE *stream, unsigned tid, const ucg_builtin_trace_event_t *event)
+{
+    double usec = ucg_builtin_trace.base_usec +
+                  ucs_time_to_usec(event->time - ucg_builtin_trace.base_time);
+
+    fprintf(stream, ",\n{\"name\":\"%s\",\"cat\":\"ucg\",\"ts\":%.3f,\"pid\":%" PRIu64 ",\"tid\":%u,",
+            ucg_builtin_trace_names[event->type], usec, (uint64_t)ucg_builtin_trace.rank, tid);
+
+    /* a collective is an async slice, which may overlap others on the same thread */
+    switch (event->type) {
+    case UCG_BUILTIN_TRACE_TRIGGER:
+        fprintf(stream, "\"ph\":\"b\",\"id\":\"%u.%u\",\"args\":{\"group\":%u,\"coll_id\":%u,"
+                "\"length\":%" PRIu64 "}}", event->group_id, event->coll_id, event->group_id,
+                event->coll_id, event->arg);
+        break;
+    case UCG_BUILTIN_TRACE_COMPLETE:
+        fprintf(stream, "\"ph\":\"e\",\"id\":\"%u.%u\",\"args\":{\"status\":\"%s\"}}",
+                event->group_id, event->coll_id, ucs_status_string((ucs_status_t)(int64_t)event->arg));
+        break;
+    default:
+        fprintf(stream, "\"ph\":\"i\",\"s\":\"t\",\"args\":{\"group\":%u,\"coll_id\":%u,\"step\":%u,"
+                "\"%s\":%" PRIu64 "}}", event->group_id, event->coll_id, event->step_idx,
+                (event->type == UCG_BUILTIN_TRACE_RECV) ? "length" : "pending", event->arg);
+        break;
+    }
+}
+
+void ucg_builtin_trace_write(void)
+{
+    ucg_builtin_trace_ring_t *ring;
+    char path[PATH_MAX];
+    uint64_t idx;
+    FILE *stream;
+
+    if (!ucg_builtin_trace_enable) {
+        return;
+    }
+
+    pthread_mutex_lock(&ucg_builtin_trace.lock);
+    if (ucs_list_is_empty(&ucg_builtin_trace.rings)) {
+        goto out;
+    }
+
+    snprintf(path, sizeof(path), "%s.%" PRIu64 ".json", ucg_builtin_trace.file,
+             (uint64_t)ucg_builtin_trace.rank);
+    stream = fopen(path, "w");
+    if (stream == NULL) {
+        ucs_warn("failed to open the collective trace %s: %m", path);
+        goto out;
+    }
+
+    /* the files of all the ranks merge by concatenating their event arrays */
+    fprintf(stream, "{\"traceEvents\":[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%" PRIu64
+            ",\"args\":{\"name\":\"rank %" PRIu64 " (%s:%d)\"}}", (uint64_t)ucg_builtin_trace.rank,
+            (uint64_t)ucg_builtin_trace.rank, ucs_get_host_name(), getpid());
+    ucs_list_for_each(ring, &ucg_builtin_trace.rings, list) {
+        for (idx = (ring->head > ring->mask) ? (ring->head - ring->mask - 1) : 0; idx < ring->head; idx++) {
+            ucg_builtin_trace_write_event(stream, ring->tid, &ring->events[idx & ring->mask]);
+        }
+    }
+    fprintf(stream, "\n]}\n");
+    fclose(stream);
+    ucs_debug("collective trace written to %s", path);
+
+out:
+    pthread_mutex_unlock(&ucg_builtin_trace.lock);
+}
@@ -476,6 +476,8 @@ chkfb_tbl_t chkfb_barrier[UCG_ALGORITHM_BARRIER_LAST] = {
     {CHKFB_BARRIER(8), CHKFB_SIZE_BARRIER(8)}, /* algo 8 */
     {CHKFB_BARRIER(9), CHKFB_SIZE_BARRIER(9)}, /* algo 9 */
     {CHKFB_BARRIER(10), CHKFB_SIZE_BARRIER(10)}, /* algo 10 */
+    {NULL, 0}, /* algo 11 */
+    {NULL, 0}, /* algo 12 */
 };
 
 chkfb_tbl_t chkfb_bcast[UCG_ALGORITHM_BCAST_LAST] = {
@@ -491,6 +493,7 @@ chkfb_tbl_t chkfb_alltoallv[UCG_ALGORITHM_ALLTOALLV_LAST] = {
     {NULL, 0}, /* algo 0 */
     {NULL, 0}, /* algo 1 */
     {CHKFB_ALLTOALLV(2), CHKFB_SIZE_ALLTOALLV(2)}, /* algo 2 */
+    {NULL, 0}, /* algo 3 */
 };
 
 chkfb_tbl_t chkfb_allreduce[UCG_ALGORITHM_ALLREDUCE_LAST] = {
@@ -556,6 +559,22 @@ static chk_fb_arr_f check_fallback[COLL_TYPE_NUMS] = {
     ucg_builtin_alltoallv_check_fallback_array, /* COLL_TYPE_ALLTOALLV */
 };
 
+static inline void ucg_builtin_algo_audit_fallback(int algo, int algo_fb, const char *reason)
+{
+    ucg_builtin_algo_audit_t *audit = ucg_builtin_algo_audit_rec;
+
+    if (ucs_likely(audit == NULL)) {
+        return;
+    }
+
+    if (audit->fallback_cnt < UCG_BUILTIN_ALGO_AUDIT_FALLBACKS) {
+        audit->fallbacks[audit->fallback_cnt].algo    = algo;
+        audit->fallbacks[audit->fallback_cnt].algo_fb = algo_fb;
+        audit->fallbacks[audit->fallback_cnt].reason  = reason;
+    }
+    audit->fallback_cnt++;
+}
+
 static check_fallback_t *ucg_builtin_get_check_fallback_array(coll_type_t coll_type, int algo, int *arr_size)
 {
     return check_fallback[coll_type](algo, arr_size);
@@ -581,8 +600,7 @@ int ucg_builtin_algo_check_fallback(const ucg_group_params_t *group_params,
             chk_fun = check_fun_array[chk_item];
             if (chk_fun(group_params, coll_params, algo)) {
                 algo_fb = chk_fb[i].algo_fb;
-                ucs_info("current algo is %d, check item is %s, fallback to algo %d",
-                        algo, check_item_str_array[chk_item], algo_fb);
+                ucg_builtin_algo_audit_fallback(algo, algo_fb, check_item_str_array[chk_item]);
                 break;
             }
         }
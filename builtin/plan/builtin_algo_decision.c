@@ -5,6 +5,8 @@
  * Create: 2021-07-16
  */
 
+#include <inttypes.h>
+#include <ucs/arch/atomic.h>
 #include <ucs/debug/log.h>
 #include <ucs/debug/assert.h>
 #include <ucg/api/ucg_mpi.h>
@@ -19,6 +21,10 @@ static const char *coll_type_str_array[COLL_TYPE_NUMS] = {
     "alltoallv",
 };
 
+__thread ucg_builtin_algo_audit_t *ucg_builtin_algo_audit_rec = NULL;
+
+static uint32_t ucg_builtin_algo_audit_cnt = 0;
+
 typedef struct {
     int low;
     int up;
@@ -92,21 +98,62 @@ STATIC_GTEST coll_type_t ucg_builtin_get_coll_type(const ucg_collective_type_t *
 
 int ucg_builtin_algo_decision(const ucg_group_params_t *group_params, const ucg_collective_params_t *coll_params)
 {
-    int algo, algo_final;
+    int algo;
 
     algo = ucg_builtin_get_custom_algo(coll_params->coll_type);
-    ucs_info("current coll_type is %s", coll_type_str_array[coll_params->coll_type]);
     /* Algorithm auto select occurs only if the user does not provide a valid algorithm parameter */
-    if (algo) {
-        ucs_info("custom algorithm is %d", algo);
-    } else {
+    if (!algo) {
         algo = ucg_builtin_algo_auto_select(group_params, coll_params);
-        ucs_info("auto select algorithm is %d", algo);
     }
 
     /* Check whether this algo can use, fall back if not */
-    algo_final = ucg_builtin_algo_check_fallback(group_params, coll_params, algo);
-    ucs_info("final algorithm is %d", algo_final);
+    return ucg_builtin_algo_check_fallback(group_params, coll_params, algo);
+}
 
-    return algo_final;
-}
\ No newline at end of file
+/*
+ * Decisions are taken on every collective, so they log nothing. Instead, the
+ * decision behind a new plan cache entry is taken again, recording its inputs
+ * and fallbacks, and logged as a single line - up to a number per process.
+ */
+void ucg_builtin_algo_audit(ucg_group_id_t group_id, const ucg_group_params_t *group_params,
+                            const ucg_collective_params_t *coll_params)
+{
+    ucg_builtin_config_t *config = (ucg_builtin_config_t *)ucg_builtin_component.plan_config;
+    ucg_builtin_algo_audit_t audit = {.size = -1, .ppn = -1, .nodes = -1};
+    char fallbacks[256] = "none";
+    int custom, selected, algo_final;
+    uint32_t audit_idx;
+    size_t pos = 0;
+    unsigned i;
+
+    if (ucg_builtin_algo_audit_cnt >= config->decision_audit) {
+        return;
+    }
+
+    audit_idx = ucs_atomic_fadd32(&ucg_builtin_algo_audit_cnt, 1);
+    if (audit_idx >= config->decision_audit) {
+        return;
+    }
+
+    ucg_builtin_algo_audit_rec = &audit;
+    custom                     = ucg_builtin_get_custom_algo(coll_params->coll_type);
+    selected                   = custom ? custom : ucg_builtin_algo_auto_select(group_params, coll_params);
+    algo_final                 = ucg_builtin_algo_check_fallback(group_params, coll_params, selected);
+    ucg_builtin_algo_audit_rec = NULL;
+
+    /* a truncated entry ends the list, snprintf returns the length it would have taken */
+    for (i = 0; (i < ucs_min(audit.fallback_cnt, UCG_BUILTIN_ALGO_AUDIT_FALLBACKS)) && (pos < sizeof(fallbacks));
+         i++) {
+        pos += snprintf(fallbacks + pos, sizeof(fallbacks) - pos, "%s%d->%d (%s)", i ? ", " : "",
+                        audit.fallbacks[i].algo, audit.fallbacks[i].algo_fb, audit.fallbacks[i].reason);
+    }
+
+    ucs_info("group #%u %s decision: size %d ppn %d nodes %d root %" PRIu64 " | %s algorithm %d | "
+             "fallbacks %s%s | final algorithm %d", group_id, coll_type_str_array[coll_params->coll_type],
+             audit.size, audit.ppn, audit.nodes, (uint64_t)coll_params->type.root,
+             custom ? "custom" : "auto selected", selected, fallbacks,
+             (audit.fallback_cnt > UCG_BUILTIN_ALGO_AUDIT_FALLBACKS) ? ", ..." : "", algo_final);
+    if (audit_idx == config->decision_audit - 1) {
+        ucs_info("last algorithm decision audited, raise UCX_BUILTIN_DECISION_AUDIT to log more");
+    }
+}
@@ -10,9 +10,27 @@
 
 #include <ucs/sys/compiler.h>
 #include <ucg/api/ucg.h>
+#include <ucg/api/ucg_plan_component.h>
 
 BEGIN_C_DECLS
 
+#define UCG_BUILTIN_ALGO_AUDIT_FALLBACKS 4
+
+/* Inputs and fallbacks of a decision, recorded only while it is audited */
+typedef struct ucg_builtin_algo_audit {
+    int             size;          /* -1 if not an input of the selection */
+    int             ppn;
+    int             nodes;
+    unsigned        fallback_cnt;
+    struct {
+        int         algo;
+        int         algo_fb;
+        const char *reason;        /* the failed check */
+    } fallbacks[UCG_BUILTIN_ALGO_AUDIT_FALLBACKS];
+} ucg_builtin_algo_audit_t;
+
+extern __thread ucg_builtin_algo_audit_t *ucg_builtin_algo_audit_rec;
+
 coll_type_t ucg_builtin_get_coll_type(const ucg_collective_type_t *coll_type);
 
 
@@ -26,6 +44,9 @@ int ucg_builtin_algo_check_fallback(const ucg_group_params_t *group_params,
 int ucg_builtin_algo_decision(const ucg_group_params_t *group_params,
                               const ucg_collective_params_t *coll_params);
 
+void ucg_builtin_algo_audit(ucg_group_id_t group_id, const ucg_group_params_t *group_params,
+                            const ucg_collective_params_t *coll_params);
+
 END_C_DECLS
 
 #endif /* !UCG_BUILTIN_ALGO_DECISION_H */
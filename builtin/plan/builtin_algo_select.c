@@ -381,7 +381,9 @@ static size_level_t ucg_builtin_get_size_level(const ucg_group_params_t *group_p
     dt_len = UCP_DT_IS_CONTIG(ucp_datatype) ? coll_params->send.dt_len :
              ucg_builtin_get_dt_len(ucp_dt_to_generic(ucp_datatype));
     size = dt_len * coll_params->send.count;
-    ucs_info("The SIZE parameter of auto select algorithm is %d", size);
+    if (ucs_unlikely(ucg_builtin_algo_audit_rec != NULL)) {
+        ucg_builtin_algo_audit_rec->size = size;
+    }
     
     if (size <= size_lev_small) {
         return SIZE_LEVEL_4B;
@@ -402,7 +404,9 @@ static ppn_level_t ucg_builtin_get_ppn_level(const ucg_group_params_t *group_par
     int ppn_max;
     
     ppn_max = group_params->topo_args.ppn_max;
-    ucs_info("The PPN parameter of auto select algorithm is %d", ppn_max);
+    if (ucs_unlikely(ucg_builtin_algo_audit_rec != NULL)) {
+        ucg_builtin_algo_audit_rec->ppn = ppn_max;
+    }
     if (ppn_max <= ppn_lev_small) {
         return PPN_LEVEL_4;
     }
@@ -421,7 +425,9 @@ static node_level_t ucg_builtin_get_node_level(const ucg_group_params_t *group_p
     int node_nums;
     
     node_nums = group_params->topo_args.node_nums;
-    ucs_info("The NODE parameter of auto select algorithm is %d", node_nums);
+    if (ucs_unlikely(ucg_builtin_algo_audit_rec != NULL)) {
+        ucg_builtin_algo_audit_rec->nodes = node_nums;
+    }
     if (node_nums <= node_lev_small) {
         return NODE_LEVEL_4;
     }
@@ -359,12 +359,6 @@ STATIC_GTEST ucs_status_t ucg_builtin_reduce_scatter_phase_cb(ucg_builtin_plan_p
 {
     ucs_assert(phase != NULL && coll_params != NULL);
 
-    static unsigned next_start_block = 0;
-    // first phase: static variable reset
-    if (phase->raben_extend.first_step_flag) {
-        next_start_block = 0;
-    }
-
     unsigned block_cnt                  = coll_params->send.count;
     unsigned total_group_cnt            = phase->raben_extend.index_group.total_group_cnt;
     unsigned total_group_process_cnt    = phase->raben_extend.index_group.total_group_process_cnt;
@@ -387,10 +381,10 @@ STATIC_GTEST ucs_status_t ucg_builtin_reduce_scatter_phase_cb(ucg_builtin_plan_p
 
     /* send && receive blocks index */
     unsigned send_num_blocks     = (cur_group_process_cnt / factor) >> phase->raben_extend.step_index;
+    unsigned next_start_block    = phase->raben_extend.start_block;
     unsigned send_start_block    = next_start_block + ((local_group_index < local_group_peer) ? send_num_blocks : 0);
     unsigned recv_num_blocks     = send_num_blocks;
     unsigned recv_start_block    = next_start_block + ((local_group_index < local_group_peer) ? 0 : send_num_blocks);
-    next_start_block            += ((local_group_index < local_group_peer) ? 0 : send_num_blocks);
 
     /* send && receive real blocks */
     phase->ex_attr.start_block       = ucg_builtin_calc_disp(block_buffers[ahead_group_cnt], 0, send_start_block);
@@ -420,6 +414,7 @@ STATIC_GTEST ucs_status_t ucg_builtin_intra_reduce_scatter(ucg_builtin_index_gro
     ucg_group_member_index_t local_group_index = index_group->local_group_index - index_group->cur_group_begin_index;
     unsigned step_cnt = ucs_ilog2(index_group->cur_group_process_cnt);
     unsigned high = ucg_builtin_keep_highest_1_bit(index_group->total_group_process_cnt);
+    unsigned start_block = 0; /* the blocks kept so far start here */
     for (idx = 0; idx < step_cnt && status == UCS_OK; idx++, (*phase)++, step_size *= factor) {
         (*phase)->step_index = *step_idx + idx;
         (*phase)->method     = UCG_PLAN_METHOD_REDUCE_SCATTER_RECURSIVE;
@@ -438,9 +433,12 @@ STATIC_GTEST ucs_status_t ucg_builtin_intra_reduce_scatter(ucg_builtin_index_gro
         ucg_group_member_index_t real_peer_index = index_group->my_index + local_group_peer_index - local_group_index;
         status = ucg_builtin_connect(ctx, real_peer_index, *phase, UCG_BUILTIN_CONNECT_SINGLE_EP);
         (*phase)->raben_extend.step_index      = idx;
-        (*phase)->raben_extend.first_step_flag = (idx ? 0 : 1);
+        (*phase)->raben_extend.start_block     = start_block;
         (*phase)->raben_extend.index_group     = *index_group;
         (*phase)->init_phase_cb                = ucg_builtin_reduce_scatter_phase_cb;
+        if (local_group_index > local_group_peer_index) {
+            start_block += (index_group->cur_group_process_cnt / factor) >> idx;
+        }
     }
     *step_idx += ucs_ilog2(high);
     return status;
@@ -750,12 +748,8 @@ STATIC_GTEST ucs_status_t ucg_builtin_extra_allgather_cb(ucg_builtin_plan_phase_
     unsigned step_base               = local_group_idx -local_group_idx % (step_size * factor);
     unsigned local_group_peer        = step_base + (local_group_idx - step_base + step_size) % (step_size * factor);
 
-    static unsigned send_start_block = 0;
-    if (phase->raben_extend.step_index == 0) {
-        send_start_block = phase->raben_extend.index_group.recv_block_index;
-    }
-
     /* send && receive block */
+    unsigned send_start_block    = phase->raben_extend.start_block;
     unsigned recv_start_block    = send_start_block;
     unsigned num_blocks          = 1 << phase->raben_extend.step_index;
     recv_start_block             = (local_group_idx < local_group_peer) ? (recv_start_block + num_blocks) :
@@ -773,10 +767,6 @@ STATIC_GTEST ucs_status_t ucg_builtin_extra_allgather_cb(ucg_builtin_plan_phase_
     phase->ex_attr.is_inequal        = 1;
     phase->ex_attr.is_partial        = 1;
 
-    if (local_group_idx > local_group_peer) {
-        send_start_block = recv_start_block;
-    }
-
     ucg_builtin_destory_block_buffers(total_group_cnt, block_buffers);
     return UCS_OK;
 }
@@ -795,6 +785,7 @@ STATIC_GTEST ucs_status_t ucg_builtin_intra_allgather(ucg_builtin_index_group_t
     unsigned step_size = index_group->cur_group_process_cnt / factor;
     unsigned high = ucg_builtin_keep_highest_1_bit(index_group->total_group_process_cnt);
     ucg_group_member_index_t local_group_index = index_group->local_group_index - index_group->cur_group_begin_index;
+    unsigned start_block = index_group->recv_block_index; /* the blocks gathered so far start here */
     for (idx = 0; idx < step_cnt && status == UCS_OK; idx++, step_size/= factor) {
         (*phase)->step_index = *step_idx + idx;
         (*phase)->method     = UCG_PLAN_METHOD_EXCHANGE;
@@ -812,9 +803,13 @@ STATIC_GTEST ucs_status_t ucg_builtin_intra_allgather(ucg_builtin_index_group_t
         status = ucg_builtin_connect(ctx, real_peer_index, *phase, UCG_BUILTIN_CONNECT_SINGLE_EP);
 
         (*phase)->raben_extend.step_index      = idx;
+        (*phase)->raben_extend.start_block     = start_block;
         (*phase)->raben_extend.index_group     = *index_group;
         (*phase)->init_phase_cb                = ucg_builtin_extra_allgather_cb;
         (*phase)++;
+        if (local_group_index > local_group_peer) {
+            start_block -= 1 << idx;
+        }
     }
     *step_idx += ucs_ilog2(high);
     return status;
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: k-ary dissemination barrier algorithm
+ */
+
+#include <string.h>
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <uct/api/uct_def.h>
+
+#include "builtin_plan.h"
+#include "builtin_algo_mgr.h"
+
+/*
+ * k-ary dissemination: in round r every member signals the k members at distance
+ * j * (k + 1)^r (j = 1..k) and waits for the k members at the same distances
+ * behind it. After ceil(log_{k+1}(N)) rounds every member has (transitively)
+ * heard from every other member, for any N and without pre/post steps.
+ *
+ *  An example (k = 1, N = 6):
+ *  round 0:   i -> i + 1
+ *  round 1:   i -> i + 2
+ *  round 2:   i -> i + 4
+ */
+
+/* intra-node fan-in and fan-out around the inter-node rounds */
+#define NODE_AWARE_EXTRA_PHASES 2
+
+static unsigned ucg_builtin_dissemination_round_cnt(unsigned radix, ucg_group_member_index_t member_cnt)
+{
+    ucg_group_member_index_t distance = 1;
+    unsigned round_cnt = 0;
+
+    while (distance < member_cnt) {
+        distance *= (radix + 1);
+        round_cnt++;
+    }
+
+    return round_cnt;
+}
+
+static unsigned ucg_builtin_dissemination_peer_cnt(unsigned radix, ucg_group_member_index_t distance,
+                                                   ucg_group_member_index_t member_cnt)
+{
+    unsigned peer_cnt = 0;
+
+    /* the last round may not need all k peers */
+    while ((peer_cnt < radix) && ((peer_cnt + 1) * distance < member_cnt)) {
+        peer_cnt++;
+    }
+
+    return peer_cnt;
+}
+
+static ucs_status_t ucg_builtin_dissemination_connect(ucg_builtin_plan_t *plan,
+                                                      ucg_builtin_group_ctx_t *ctx,
+                                                      unsigned radix,
+                                                      const ucg_group_member_index_t *member_list,
+                                                      ucg_group_member_index_t member_cnt,
+                                                      ucg_group_member_index_t my_index,
+                                                      ucg_step_idx_ext_t first_step,
+                                                      ucg_builtin_plan_phase_t **phase,
+                                                      uct_ep_h **next_ep)
+{
+    ucs_status_t status = UCS_OK;
+    ucg_group_member_index_t distance;
+    ucg_group_member_index_t peer_index;
+    unsigned round_cnt = ucg_builtin_dissemination_round_cnt(radix, member_cnt);
+    unsigned round_idx, peer_idx, peer_cnt;
+
+    for (round_idx = 0, distance = 1; (round_idx < round_cnt) && (status == UCS_OK);
+         round_idx++, distance *= (radix + 1)) {
+        peer_cnt = ucg_builtin_dissemination_peer_cnt(radix, distance, member_cnt);
+
+        (*phase)->method     = UCG_PLAN_METHOD_DISSEMINATION;
+        (*phase)->ep_cnt     = peer_cnt;
+        (*phase)->step_index = first_step + round_idx;
+        (*phase)->multi_eps  = *next_ep;
+#if ENABLE_DEBUG_DATA
+        (*phase)->indexes = UCS_ALLOC_CHECK(peer_cnt * sizeof(my_index), "dissemination indexes");
+#endif
+        for (peer_idx = 0; (peer_idx < peer_cnt) && (status == UCS_OK); peer_idx++) {
+            peer_index = (my_index + (peer_idx + 1) * distance) % member_cnt;
+            ucs_debug("%lu's peer #%u/%u (round #%u/%u): %lu", my_index, peer_idx + 1, peer_cnt,
+                      round_idx + 1, round_cnt, member_list[peer_index]);
+            status = ucg_builtin_connect(ctx, member_list[peer_index], *phase,
+                                         (peer_cnt == 1) ? UCG_BUILTIN_CONNECT_SINGLE_EP : peer_idx);
+        }
+
+        *next_ep      += peer_cnt;
+        plan->ep_cnt  += peer_cnt;
+        plan->phs_cnt++;
+        (*phase)++;
+    }
+
+    return status;
+}
+
+/*
+ * Inside a node, members only signal (fan-in) and are released by (fan-out) the
+ * node leader. Both are zero-byte messages over the intra-node transport.
+ */
+static ucs_status_t ucg_builtin_dissemination_add_intra(ucg_builtin_plan_t *plan,
+                                                        ucg_builtin_group_ctx_t *ctx,
+                                                        const ucg_builtin_topology_info_params_t *topo_params,
+                                                        ucg_group_member_index_t my_rank,
+                                                        unsigned is_fanin,
+                                                        ucg_step_idx_ext_t step_index,
+                                                        ucg_builtin_plan_phase_t **phase,
+                                                        uct_ep_h **next_ep)
+{
+    ucs_status_t status = UCS_OK;
+    ucg_group_member_index_t leader = topo_params->rank_same_node[0];
+    unsigned local_cnt = topo_params->ppn_cnt;
+    unsigned local_idx;
+
+    if (local_cnt == 1) {
+        return UCS_OK;
+    }
+
+    (*phase)->step_index = step_index;
+    (*phase)->multi_eps  = *next_ep;
+    if (my_rank == leader) {
+        (*phase)->method = is_fanin ? UCG_PLAN_METHOD_RECV_TERMINAL : UCG_PLAN_METHOD_SEND_TERMINAL;
+        (*phase)->ep_cnt = local_cnt - 1;
+    } else {
+        (*phase)->method = is_fanin ? UCG_PLAN_METHOD_SEND_TERMINAL : UCG_PLAN_METHOD_RECV_TERMINAL;
+        (*phase)->ep_cnt = 1;
+    }
+#if ENABLE_DEBUG_DATA
+    (*phase)->indexes = UCS_ALLOC_CHECK((*phase)->ep_cnt * sizeof(my_rank), "dissemination indexes");
+#endif
+
+    if (my_rank == leader) {
+        for (local_idx = 1; (local_idx < local_cnt) && (status == UCS_OK); local_idx++) {
+            status = ucg_builtin_connect(ctx, topo_params->rank_same_node[local_idx], *phase,
+                                         (local_cnt == 2) ? UCG_BUILTIN_CONNECT_SINGLE_EP : (local_idx - 1));
+        }
+    } else {
+        status = ucg_builtin_connect(ctx, leader, *phase, UCG_BUILTIN_CONNECT_SINGLE_EP);
+    }
+
+    *next_ep     += (*phase)->ep_cnt;
+    plan->ep_cnt += (*phase)->ep_cnt;
+    plan->phs_cnt++;
+    (*phase)++;
+
+    return status;
+}
+
+static ucs_status_t ucg_builtin_node_aware_dissemination_build(ucg_builtin_plan_t *plan,
+                                                               ucg_builtin_group_ctx_t *ctx,
+                                                               const ucg_builtin_config_t *config,
+                                                               const ucg_group_params_t *group_params,
+                                                               const ucg_builtin_topology_info_params_t *topo_params,
+                                                               ucg_builtin_plan_phase_t *phase,
+                                                               uct_ep_h *next_ep)
+{
+    ucs_status_t status;
+    ucg_group_member_index_t my_rank = group_params->member_index;
+    unsigned radix = config->dissemination_radix;
+    unsigned round_cnt = ucg_builtin_dissemination_round_cnt(radix, topo_params->node_cnt);
+
+    /* step 0: intra-node fan-in */
+    status = ucg_builtin_dissemination_add_intra(plan, ctx, topo_params, my_rank, 1, 0, &phase, &next_ep);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    /* step 1..round_cnt: dissemination among node leaders */
+    if (topo_params->rank_same_node[0] == my_rank) {
+        status = ucg_builtin_dissemination_connect(plan, ctx, radix, topo_params->subroot_array,
+                                                   topo_params->node_cnt, group_params->node_index[my_rank],
+                                                   1, &phase, &next_ep);
+        if (status != UCS_OK) {
+            return status;
+        }
+    }
+
+    /* step round_cnt + 1: intra-node fan-out */
+    return ucg_builtin_dissemination_add_intra(plan, ctx, topo_params, my_rank, 0, round_cnt + 1,
+                                               &phase, &next_ep);
+}
+
+ucs_status_t ucg_builtin_dissemination_create(ucg_builtin_group_ctx_t *ctx,
+                                              enum ucg_builtin_plan_topology_type plan_topo_type,
+                                              const ucg_builtin_config_t *config,
+                                              const ucg_group_params_t *group_params,
+                                              const ucg_collective_params_t *coll_params,
+                                              ucg_builtin_plan_t **plan_p)
+{
+    ucs_status_t status;
+    ucg_builtin_topology_info_params_t topo_params = {0};
+    ucg_group_member_index_t member_cnt = group_params->member_count;
+    ucg_group_member_index_t *member_list = NULL;
+    unsigned radix = config->dissemination_radix;
+    unsigned node_aware = ucg_algo.topo;
+    unsigned phs_cnt;
+    size_t ep_cnt;
+
+    if (node_aware) {
+        status = ucg_builtin_topology_info_create(&topo_params, group_params, 0);
+        if (status != UCS_OK) {
+            return status;
+        }
+        phs_cnt = ucg_builtin_dissemination_round_cnt(radix, topo_params.node_cnt) + NODE_AWARE_EXTRA_PHASES;
+        ep_cnt  = (phs_cnt - NODE_AWARE_EXTRA_PHASES) * radix + NODE_AWARE_EXTRA_PHASES * topo_params.ppn_cnt;
+    } else {
+        member_list = UCS_ALLOC_CHECK(member_cnt * sizeof(ucg_group_member_index_t), "member list");
+        ucg_builtin_recursive_init_member_list(member_cnt, member_list);
+        phs_cnt = ucg_builtin_dissemination_round_cnt(radix, member_cnt);
+        ep_cnt  = phs_cnt * radix;
+    }
+
+    /* Allocate memory resources */
+    size_t alloc_size = sizeof(ucg_builtin_plan_t) + phs_cnt * sizeof(ucg_builtin_plan_phase_t) +
+                        ep_cnt * sizeof(uct_ep_h);
+    ucg_builtin_plan_t *dissemination = (ucg_builtin_plan_t*)ucs_malloc(alloc_size, "dissemination topology");
+    if (dissemination == NULL) {
+        status = UCS_ERR_NO_MEMORY;
+        goto out;
+    }
+    memset(dissemination, 0, alloc_size);
+
+    ucg_builtin_plan_phase_t *phase = &dissemination->phss[0];
+    uct_ep_h *next_ep = (uct_ep_h*)(&dissemination->phss[phs_cnt]);
+    if (node_aware) {
+        status = ucg_builtin_node_aware_dissemination_build(dissemination, ctx, config, group_params,
+                                                            &topo_params, phase, next_ep);
+    } else {
+        status = ucg_builtin_dissemination_connect(dissemination, ctx, radix, member_list, member_cnt,
+                                                   group_params->member_index, 0, &phase, &next_ep);
+    }
+    if (status != UCS_OK) {
+        ucs_error("Error in dissemination create: %d", (int)status);
+        ucs_free(dissemination);
+        goto out;
+    }
+
+    /* step indexes are the same on every rank, also on those skipping the leader rounds */
+    dissemination->step_cnt       = phs_cnt;
+    dissemination->super.my_index = group_params->member_index;
+    *plan_p = dissemination;
+out:
+    ucg_builtin_free((void **)&member_list);
+    ucg_builtin_free((void **)&topo_params.rank_same_node);
+    ucg_builtin_free((void **)&topo_params.subroot_array);
+    return status;
+}
+
+UCG_BUILTIN_ALGO_REGISTER(barrier, COLL_TYPE_BARRIER, UCG_ALGORITHM_BARRIER_DISSEMINATION,
+                          ucg_builtin_dissemination_create);
+UCG_BUILTIN_ALGO_REGISTER(barrier, COLL_TYPE_BARRIER, UCG_ALGORITHM_BARRIER_NODE_AWARE_DISSEMINATION,
+                          ucg_builtin_dissemination_create);
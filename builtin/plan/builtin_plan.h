@@ -49,6 +49,7 @@ typedef struct ucg_builtin_algorithm {
     uint16_t   binary_block : 1;       /*binary block 0:false 1:yes*/
     uint16_t  ladd  : 1;       /* ladd 0:false 1:yes*/
     uint16_t   plummer : 1;       /*plummer 0:false 1:yes*/
+    uint16_t   sparse : 1;        /* sparse alltoallv 0:false 1:yes */
     uint16_t topo   : 1;       /* topo       0: standard tree   1: topo-aware tree */
     /* 
      * topo_level =
@@ -57,7 +58,7 @@ typedef struct ucg_builtin_algorithm {
      * UCG_GROUP_HIERARCHY_LEVEL_L3CACHE:  L3cache-aware 
      */
     uint16_t   topo_level : 2;
-    uint16_t   reserved : 2;
+    uint16_t   reserved : 1;
     uint8_t  feature_flag; /* @ref enum ucg_builtin_algorithm_feature */
 } ucg_builtin_algo_t;
 
@@ -80,6 +81,7 @@ enum ucg_builtin_plan_topology_type {
     UCG_PLAN_BINARY_BLOCK,
     UCG_PLAN_ALLTOALLV_LADD,
     UCG_PLAN_ALLTOALLV_PLUMMER,
+    UCG_PLAN_ALLTOALLV_SPARSE,
     UCG_PLAN_LAST
 };
 
@@ -131,6 +133,7 @@ enum UCS_S_PACKED ucg_builtin_plan_method_type {
     UCG_PLAN_METHOD_SCATTER_V_TERMINAL,/* scatterv operation for fanout */
     UCG_PLAN_METHOD_GATHER_V_TERMINAL, /* gatherv operation for fanin */
     UCG_PLAN_METHOD_ALLTOALLV_PLUMMER, /* inter node alltoallv for plummer*/
+    UCG_PLAN_METHOD_DISSEMINATION,     /* send to k peers, receive from k others */
 };
 
 enum ucg_builtin_bcast_algorithm {
@@ -175,6 +178,8 @@ enum ucg_builtin_barrier_algorithm {
     UCG_ALGORITHM_BARRIER_NODE_AWARE_INC                     = 8, /* Node-aware In Network Computing (INC) */
     UCG_ALGORITHM_BARRIER_SOCKET_AWARE_INC                   = 9, /* Socket-aware In Network Computing (INC) */
     UCG_ALGORITHM_BARRIER_NAP                                = 10, /* Node-Aware Parallel algorithm (NAP) */
+    UCG_ALGORITHM_BARRIER_DISSEMINATION                      = 11, /* k-ary dissemination */
+    UCG_ALGORITHM_BARRIER_NODE_AWARE_DISSEMINATION           = 12, /* Topo-aware dissemination (leaders only, fan-in/out inside node) */
     UCG_ALGORITHM_BARRIER_LAST,
 };
 
@@ -182,6 +187,7 @@ enum ucg_builtin_alltoallv_algorithm {
     UCG_ALGORITHM_ALLTOALLV_AUTO_DECISION    = 0,
     UCG_ALGORITHM_ALLTOALLV_LADD             = 1,  /* Throttled scattered destination */
     UCG_ALGORITHM_ALLTOALLV_NODE_AWARE_PLUMMER = 2,  /* gatherv+alltoallv+scatterv*/
+    UCG_ALGORITHM_ALLTOALLV_SPARSE           = 3,  /* only exchange with non-zero count peers */
     UCG_ALGORITHM_ALLTOALLV_LAST,
 };
 
@@ -193,6 +199,8 @@ typedef struct ucg_builtin_tl_threshold {
     size_t                            max_bcopy_max; /* max length to use bcopy */
     size_t                            max_zcopy_one; /* max single zcopy message */
     size_t                            md_attr_cap_max_reg;
+    size_t                            rndv_thresh;   /* min length the receiver reads by RMA */
+    size_t                            zcopy_eager;   /* min bcopy length sent by zcopy from the first call */
 } ucg_builtin_tl_threshold_t;
 
 /* special feature for some algorithms (rabenseifner, bruck),
@@ -215,7 +223,21 @@ typedef struct ucg_builtin_plan_extra_attr {
     unsigned is_variable_len;         /* indicates whether the length is variable. */
     unsigned is_plummer;              /* indicates whether plummer algorithm. */
     unsigned ppn;                     /* number of processes on a node */
+    const unsigned *sparse_blocks;    /* block index of every endpoint, NULL if blocks are contiguous */
 } ucg_builtin_plan_extra_attr_t;
+/* max number of interfaces a large message to one peer is striped over */
+#define UCG_BUILTIN_MAX_RAILS 4
+
+/* endpoints to the same peer on different interfaces, rail 0 is the phase endpoint */
+typedef struct ucg_builtin_rails {
+    uct_ep_h                          main_ep;       /* phase endpoint these rails belong to */
+    unsigned                          cnt;           /* number of rails, including the main one */
+    unsigned                          weight_sum;    /* fragments in one striping round */
+    uct_ep_h                          eps[UCG_BUILTIN_MAX_RAILS];
+    uct_md_h                          mds[UCG_BUILTIN_MAX_RAILS];
+    unsigned                          weights[UCG_BUILTIN_MAX_RAILS]; /* fragments per round on each rail */
+} ucg_builtin_rails_t;
+
 struct ucg_builtin_plan_phase;
 typedef ucs_status_t (*ucg_builtin_init_phase_by_step_cb_t)(struct ucg_builtin_plan_phase *phase,
                                                             const ucg_collective_params_t *coll_params);
@@ -240,7 +262,7 @@ typedef struct ucg_builtin_index_group {
 
 typedef struct ucg_builtin_plan_raben_phase_extend {
     unsigned step_index;   /* step index in each phase of algorithm */
-    unsigned first_step_flag;
+    unsigned start_block;  /* first block held before this step, set when planning */
     ucg_builtin_index_group_t index_group;
 } ucg_builtin_plan_raben_phase_extend_t;
 
@@ -275,6 +297,10 @@ typedef struct ucg_builtin_plan_phase {
     /* layout for multi_eps : s s s | r r */
     ucg_builtin_tl_threshold_t       *ep_thresh;   /* threshold for every uct_ep*/
 
+    ucg_builtin_rails_t              *rails;       /* rails for every uct_ep, NULL if not striping */
+    unsigned                          rails_cnt;   /* number of entries in rails */
+    size_t                            rail_stripe_min; /* fragments below this size use the main rail */
+
 #if ENABLE_DEBUG_DATA
     ucg_group_member_index_t         *indexes;       /* array corresponding to EPs */
 #endif
@@ -285,7 +311,7 @@ typedef struct ucg_builtin_plan_phase {
 typedef struct ucg_builtin_group_ctx ucg_builtin_group_ctx_t;
 typedef struct ucg_builtin_plan {
     ucg_plan_t               super;
-    void                    *slots;   /* slots for builtin operations */
+    void                    *window;  /* slots for builtin operations */
     ucs_list_link_t         *resend;  /* per-group list of requests to resend */
     ucs_list_link_t          list;    /* member of a per-group list of plans */
     ucs_list_link_t          by_root; /* extra phases for non-zero root */
@@ -295,6 +321,7 @@ typedef struct ucg_builtin_plan {
     ucg_step_idx_ext_t       ep_cnt;  /* total endpoint count */
     uint16_t                 am_id;   /* active message ID */
     ucg_builtin_algo_t       ucg_algo;
+    int                      algo_id; /* as in UCX_BUILTIN_<TYPE>_ALGORITHM */
     dt_convert_f             convert_f; /* convert datatypes */
     dt_span_f                dtspan_f;
     ucg_builtin_plan_phase_t phss[];  /* topology's phases */
@@ -350,9 +377,20 @@ ucs_status_t ucg_builtin_binomial_tree_create(ucg_builtin_group_ctx_t *ctx,
                                               const ucg_collective_params_t *coll_params,
                                               ucg_builtin_plan_t **plan_p);
 
+/* largest radix the recursive k-ing builder may pick, bounds the plan cache slots */
+#define UCG_BUILTIN_RECURSIVE_MAX_FACTOR 8
+
 typedef struct ucg_builtin_recursive_config {
-    unsigned factor;
+    unsigned factor;           /* static radix, used when auto-tuning is off or not applicable */
+    int      auto_factor;      /* choose the radix per call from message and group size */
+    unsigned max_factor;       /* upper bound of the auto-tuned radix */
+    size_t   small_msg_thresh; /* messages up to this size are latency-bound */
 } ucg_builtin_recursive_config_t;
+extern ucs_config_field_t ucg_builtin_recursive_config_table[];
+
+unsigned ucg_builtin_recursive_choose_factor(const ucg_builtin_config_t *config,
+                                             const ucg_group_params_t *group_params,
+                                             const ucg_collective_params_t *coll_params);
 
 ucs_status_t ucg_builtin_recursive_create(ucg_builtin_group_ctx_t *ctx,
                                           enum ucg_builtin_plan_topology_type plan_topo_type,
@@ -372,6 +410,16 @@ ucs_status_t ucg_builtin_recursive_connect(ucg_builtin_group_ctx_t *ctx,
 void ucg_builtin_recursive_compute_steps(ucg_group_member_index_t my_index_local,
                                                  unsigned rank_count, unsigned factor, unsigned *steps);
 
+void ucg_builtin_recursive_init_member_list(ucg_group_member_index_t member_cnt,
+                                            ucg_group_member_index_t *member_list);
+
+ucs_status_t ucg_builtin_dissemination_create(ucg_builtin_group_ctx_t *ctx,
+                                              enum ucg_builtin_plan_topology_type plan_topo_type,
+                                              const ucg_builtin_config_t *config,
+                                              const ucg_group_params_t *group_params,
+                                              const ucg_collective_params_t *coll_params,
+                                              ucg_builtin_plan_t **plan_p);
+
 /* Binary block Algorithm related functions */
 typedef struct ucg_builtin_binary_block_config {
     unsigned inter_allreduce_method;
@@ -416,6 +464,14 @@ ucs_status_t ucg_builtin_throttled_scatter_create(ucg_builtin_group_ctx_t *ctx,
                                                   const ucg_collective_params_t *coll_params,
                                                   ucg_builtin_plan_t **plan_p);
 
+/* Sparse alltoallv algorithm related functions */
+ucs_status_t ucg_builtin_sparse_alltoallv_create(ucg_builtin_group_ctx_t *ctx,
+                                                 enum ucg_builtin_plan_topology_type plan_topo_type,
+                                                 const ucg_builtin_config_t *config,
+                                                 const ucg_group_params_t *group_params,
+                                                 const ucg_collective_params_t *coll_params,
+                                                 ucg_builtin_plan_t **plan_p);
+
 /* Throttled scattered destination algorithm related functions */
 ucs_status_t ucg_builtin_Plummer_create(ucg_builtin_group_ctx_t *ctx,
                                         const enum ucg_builtin_plan_topology_type plan_topo_type,
@@ -496,8 +552,28 @@ struct ucg_builtin_config {
     double                         barrier_algorithm;
     double                         alltoallv_algorithm;
     unsigned                       pipelining;
-    unsigned                       max_msg_list_size;
     unsigned                       throttle_factor;
+    unsigned                       dissemination_radix;
+    int                            native_reduce;       /* reduce predefined op/datatype pairs natively */
+    unsigned                       max_rails;           /* interfaces to stripe large fragments over */
+    size_t                         rail_stripe_min;     /* smallest fragment worth striping */
+    int                            rail_weighted;       /* stripe by interface bandwidth instead of round-robin */
+    size_t                         rndv_thresh;         /* smallest message sent by rendezvous */
+    int                            reg_cache;           /* cache zcopy memory registrations */
+    size_t                         zcopy_eager_thresh;  /* bcopy length registered at once, auto to measure */
+    unsigned                       concurrent_ops;      /* initial window of outstanding collectives */
+    unsigned                       concurrent_ops_limit; /* the window doubles up to it */
+    double                         wait_spin_time;      /* progress of a wait before it blocks */
+    int                            async_progress;      /* progress from a thread of the worker */
+    double                         async_interval;      /* pause of that thread without progress */
+    unsigned                       reduce_threads;      /* threads splitting large reductions */
+    size_t                         reduce_threads_thresh; /* smallest reduction split over them */
+    int                            metrics;             /* record latency histograms and counters */
+    int                            metrics_signal;      /* signal printing the metrics, 0 for none */
+    char                          *metrics_file;        /* prefix of the metrics files, empty to log */
+    char                          *trace_file;          /* prefix of the timeline files, empty for none */
+    unsigned                       trace_events;        /* latest events kept per thread */
+    unsigned                       decision_audit;      /* algorithm decisions logged per process */
     int                            reduce_consistency;  /* reduce operate result consistency flag, default is n */
 };
 
@@ -626,6 +702,22 @@ ucg_group_member_index_t ucg_builtin_get_local_index(ucg_group_member_index_t gl
 
 int ucg_is_allreduce_consistency(const ucg_builtin_group_ctx_t *ctx);
 
+typedef struct ucg_builtin_scratch ucg_builtin_scratch_t;
+ucg_builtin_scratch_t *ucg_builtin_group_scratch(ucg_builtin_group_ctx_t *ctx);
+
+typedef struct ucg_builtin_rcache ucg_builtin_rcache_t;
+ucg_builtin_rcache_t *ucg_builtin_group_rcache(ucg_builtin_group_ctx_t *ctx);
+
+typedef struct ucg_builtin_async ucg_builtin_async_t;
+ucg_builtin_async_t *ucg_builtin_group_async(ucg_builtin_group_ctx_t *ctx);
+void ucg_builtin_async_kick(ucg_builtin_async_t *async);
+
+typedef struct ucg_builtin_rpool ucg_builtin_rpool_t;
+ucg_builtin_rpool_t *ucg_builtin_group_rpool(ucg_builtin_group_ctx_t *ctx);
+
+typedef struct ucg_builtin_metrics ucg_builtin_metrics_t;
+ucg_builtin_metrics_t *ucg_builtin_group_metrics(ucg_builtin_group_ctx_t *ctx);
+
 
 short ucg_get_tree_buffer_pos(ucg_group_member_index_t myrank,
                               ucg_group_member_index_t uprank,
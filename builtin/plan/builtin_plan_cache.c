@@ -6,16 +6,20 @@
  */
 
 #include <ucs/debug/log.h>
+#include <ucg/builtin/ops/builtin_ops.h>
 
+#include "builtin_algo_decision.h"
 #include "builtin_plan.h"
 #include "builtin_plan_cache.h"
 
 #define ROOT_NUMS 96
+/* recursive k-ing plans with radix 3..MAX are cached after the per-algorithm slots */
+#define RADIX_NUMS (UCG_BUILTIN_RECURSIVE_MAX_FACTOR - 2)
 
 const static int cache_size[COLL_TYPE_NUMS] = {
-    UCG_ALGORITHM_BARRIER_LAST - 1,
+    UCG_ALGORITHM_BARRIER_LAST - 1 + RADIX_NUMS,
     (UCG_ALGORITHM_BCAST_LAST - 1) * ROOT_NUMS,
-    UCG_ALGORITHM_ALLREDUCE_LAST - 1,
+    UCG_ALGORITHM_ALLREDUCE_LAST - 1 + RADIX_NUMS,
     UCG_ALGORITHM_ALLTOALLV_LAST - 1,
 };
 
@@ -53,6 +57,32 @@ static ucg_plan_t *ucg_builtin_alltoallv_pcache_find(const ucg_group_h group, in
     return NULL;
 }
 
+static int ucg_builtin_is_recursive_algo(coll_type_t coll_type, int algo)
+{
+    return (coll_type == COLL_TYPE_BARRIER && algo == UCG_ALGORITHM_BARRIER_RECURSIVE) ||
+           (coll_type == COLL_TYPE_ALLREDUCE && algo == UCG_ALGORITHM_ALLREDUCE_RECURSIVE);
+}
+
+/* The radix of recursive k-ing is chosen per call, so it is part of the cache key */
+static int ucg_builtin_pcache_pos(const ucg_group_h group, int algo,
+                                  const ucg_collective_params_t *coll_params)
+{
+    ucg_builtin_config_t *config = (ucg_builtin_config_t *)ucg_builtin_component.plan_config;
+    coll_type_t coll_type = coll_params->coll_type;
+    unsigned factor;
+
+    if (!ucg_builtin_is_recursive_algo(coll_type, algo)) {
+        return algo - 1;
+    }
+
+    factor = ucg_builtin_recursive_choose_factor(config, &group->params, coll_params);
+    if (factor <= 2) {
+        return algo - 1;
+    }
+
+    return cache_size[coll_type] - RADIX_NUMS + factor - 3;
+}
+
 ucg_plan_t *ucg_builtin_pcache_find(const ucg_group_h group, int algo,
                                     const ucg_collective_params_t *coll_params)
 {
@@ -70,7 +100,8 @@ ucg_plan_t *ucg_builtin_pcache_find(const ucg_group_h group, int algo,
             return ucg_builtin_alltoallv_pcache_find(group, algo, coll_params);
 
         default:
-            return group->builtin_pcache[coll_type][algo - 1];
+            pos = ucg_builtin_pcache_pos(group, algo, coll_params);
+            return group->builtin_pcache[coll_type][pos];
     }
 }
 
@@ -90,13 +121,16 @@ void ucg_builtin_pcache_update(ucg_group_h group, ucg_plan_t *plan, int algo,
             break;
 
         default:
-            plan_old = group->builtin_pcache[coll_type][algo - 1];
-            group->builtin_pcache[coll_type][algo - 1] = plan;
+            pos = ucg_builtin_pcache_pos(group, algo, coll_params);
+            plan_old = group->builtin_pcache[coll_type][pos];
+            group->builtin_pcache[coll_type][pos] = plan;
             break;
     }
 
     if (plan_old) {
         builtin_plan = ucs_derived_of(plan_old, ucg_builtin_plan_t);
         ucg_builtin_destroy_plan(builtin_plan, group);
+    } else {
+        ucg_builtin_algo_audit(group->group_id, &group->params, coll_params);
     }
 }
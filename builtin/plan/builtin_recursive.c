@@ -9,14 +9,32 @@
 #include <ucs/debug/log.h>
 #include <ucs/debug/memtrack.h>
 #include <ucs/arch/bitops.h>
+#include <ucs/sys/math.h>
 #include <uct/api/uct_def.h>
 #include <ucg/api/ucg_mpi.h>
+#include <ucg/builtin/ops/builtin_ops.h>
 
 #define MAX_PEERS 100
 #define MAX_PHASES 32
 #define NUM_TWO 2
 #define FACTOR 2
 
+ucs_config_field_t ucg_builtin_recursive_config_table[] = {
+    {"FACTOR", "2", "recursive k-ing radix used when the radix is not auto-tuned.\n",
+     ucs_offsetof(ucg_builtin_recursive_config_t, factor), UCS_CONFIG_TYPE_UINT},
+
+    {"AUTO_FACTOR", "n", "choose the recursive k-ing radix per call from message size and group size.\n"
+     "Allreduce only uses a radix above 2 for integer and bitwise operations.\n",
+     ucs_offsetof(ucg_builtin_recursive_config_t, auto_factor), UCS_CONFIG_TYPE_BOOL},
+
+    {"MAX_FACTOR", "8", "largest radix the recursive k-ing auto-tuning may choose.\n",
+     ucs_offsetof(ucg_builtin_recursive_config_t, max_factor), UCS_CONFIG_TYPE_UINT},
+
+    {"SMALL_MSG_THRESH", "2048", "messages up to this size are latency-bound and may use a radix above 2.\n",
+     ucs_offsetof(ucg_builtin_recursive_config_t, small_msg_thresh), UCS_CONFIG_TYPE_MEMUNITS},
+    {NULL}
+};
+
 static void ucg_builtin_check_swap(unsigned factor, ucg_step_idx_t step_idx,
                                    ucg_group_member_index_t my_index,
                                    ucg_builtin_plan_phase_t *phase)
@@ -805,6 +823,83 @@ void ucg_builtin_recursive_compute_steps(ucg_group_member_index_t my_index_local
     *steps = (step_size != rank_count) ? (near_power_of_two_step + NUM_TWO) : step_idx;
 }
 
+/* Return the number of steps if member_cnt is a power of factor, 0 otherwise */
+static unsigned ucg_builtin_recursive_power_steps(unsigned factor, ucg_group_member_index_t member_cnt)
+{
+    ucg_group_member_index_t step_size = 1;
+    unsigned step_cnt = 0;
+
+    if (factor < FACTOR) {
+        return 0;
+    }
+
+    while (step_size < member_cnt) {
+        step_size *= factor;
+        step_cnt++;
+    }
+
+    return (step_size == member_cnt) ? step_cnt : 0;
+}
+
+/*
+ * Choose the radix of recursive k-ing for one call. A higher radix trades more
+ * concurrent sends per step for fewer steps, which pays off while the message
+ * is latency-bound; bandwidth-bound messages always use radix 2. Only the
+ * power-of-factor layout supports a radix above 2, otherwise fall back to 2.
+ * The factor-1 peers of a step are reduced in arrival order, so auto-tuned
+ * allreduces only go above 2 when that order cannot change the result.
+ */
+unsigned ucg_builtin_recursive_choose_factor(const ucg_builtin_config_t *config,
+                                             const ucg_group_params_t *group_params,
+                                             const ucg_collective_params_t *coll_params)
+{
+    ucg_group_member_index_t member_cnt = group_params->member_count;
+    unsigned max_factor = ucs_min(config->recursive.max_factor, UCG_BUILTIN_RECURSIVE_MAX_FACTOR);
+    size_t thresh = ucs_max(config->recursive.small_msg_thresh, 1);
+    unsigned factor, best_factor, step_cnt;
+    size_t msg_size, cost, best_cost;
+
+    /* with a radix above 2 the factor-1 peers of a step are reduced in arrival order */
+    if (config->reduce_consistency && (coll_params->coll_type == COLL_TYPE_ALLREDUCE)) {
+        return FACTOR;
+    }
+
+    if (!config->recursive.auto_factor) {
+        factor = config->recursive.factor;
+        return (factor <= UCG_BUILTIN_RECURSIVE_MAX_FACTOR &&
+                ucg_builtin_recursive_power_steps(factor, member_cnt)) ? factor : FACTOR;
+    }
+
+    if ((coll_params->coll_type == COLL_TYPE_ALLREDUCE) &&
+        !ucg_builtin_reduce_is_exact(group_params, coll_params->recv.op_ext, coll_params->recv.dt_ext)) {
+        return FACTOR;
+    }
+
+    /* barrier carries no payload, so it is always latency-bound */
+    msg_size = (coll_params->coll_type == COLL_TYPE_BARRIER) ? 0 :
+               (size_t)coll_params->send.count * coll_params->send.dt_len;
+    if (msg_size > config->recursive.small_msg_thresh) {
+        return FACTOR;
+    }
+
+    /* cost of a radix: steps * (per-step latency + payload injected to factor-1 peers) */
+    best_factor = FACTOR;
+    best_cost   = SIZE_MAX;
+    for (factor = FACTOR; (factor <= max_factor) && (factor <= member_cnt); factor++) {
+        step_cnt = ucg_builtin_recursive_power_steps(factor, member_cnt);
+        if (step_cnt == 0 || step_cnt * (factor - 1) > MAX_PEERS) {
+            continue;
+        }
+        cost = step_cnt * (thresh + (factor - 1) * msg_size);
+        if (cost < best_cost) {
+            best_cost   = cost;
+            best_factor = factor;
+        }
+    }
+
+    return best_factor;
+}
+
 void ucg_builtin_recursive_init_member_list(ucg_group_member_index_t member_cnt, ucg_group_member_index_t *member_list)
 {
     ucg_group_member_index_t i;
@@ -825,7 +920,8 @@ ucs_status_t ucg_builtin_recursive_create(ucg_builtin_group_ctx_t *ctx,
                                                             "member list");
     ucg_builtin_recursive_init_member_list(member_cnt, member_list);
 
-    unsigned factor = config->recursive.factor;
+    unsigned factor = ucg_builtin_recursive_choose_factor(config, group_params, coll_params);
+    ucs_debug("recursive k-ing radix %u for %lu members", factor, (uint64_t)member_cnt);
     ucg_step_idx_t step_cnt = 0;
     unsigned step_size = 1;
     while (step_size < member_cnt) {
@@ -853,7 +949,8 @@ ucs_status_t ucg_builtin_recursive_create(ucg_builtin_group_ctx_t *ctx,
     }
 
     recursive->super.my_index = my_rank;
-    recursive->super.support_non_commutative = 1;
+    /* above radix 2, the peers of a step are not reduced in rank order */
+    recursive->super.support_non_commutative = (factor == NUM_TWO);
     recursive->super.support_large_datatype = 1;
     *plan_p = recursive;
 out:
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Sparse alltoallv algorithm
+ */
+
+#include <string.h>
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/math.h>
+#include <uct/api/uct_def.h>
+
+#include "builtin_plan.h"
+#include "builtin_algo_mgr.h"
+
+/*
+ * Sparse alltoallv: every member only connects to the peers it exchanges a
+ * non-zero count with. Send peers come from send.counts and receive peers from
+ * recv.counts, so no extra communication is needed to build the plan, and the
+ * single phase never visits a zero-count peer.
+ *
+ *  layout for multi_eps : s s s | r r
+ *  sparse_blocks[i] : block (member) index of multi_eps[i]
+ */
+
+static unsigned ucg_builtin_sparse_alltoallv_active_cnt(const int *counts,
+                                                        ucg_group_member_index_t member_cnt,
+                                                        ucg_group_member_index_t my_index)
+{
+    ucg_group_member_index_t member_idx;
+    unsigned active_cnt = 0;
+
+    for (member_idx = 0; member_idx < member_cnt; member_idx++) {
+        if ((member_idx != my_index) && (counts[member_idx] > 0)) {
+            active_cnt++;
+        }
+    }
+
+    return active_cnt;
+}
+
+static ucs_status_t ucg_builtin_sparse_alltoallv_connect(ucg_builtin_group_ctx_t *ctx,
+                                                         ucg_builtin_plan_phase_t *phase,
+                                                         const int *counts,
+                                                         ucg_group_member_index_t member_cnt,
+                                                         ucg_group_member_index_t my_index,
+                                                         unsigned *sparse_blocks,
+                                                         unsigned *phase_ep_index)
+{
+    ucs_status_t status = UCS_OK;
+    ucg_group_member_index_t member_idx;
+
+    for (member_idx = 0; (member_idx < member_cnt) && (status == UCS_OK); member_idx++) {
+        if ((member_idx == my_index) || (counts[member_idx] <= 0)) {
+            continue;
+        }
+        sparse_blocks[*phase_ep_index] = member_idx;
+        status = ucg_builtin_connect(ctx, member_idx, phase, *phase_ep_index);
+        (*phase_ep_index)++;
+    }
+
+    return status;
+}
+
+ucs_status_t ucg_builtin_sparse_alltoallv_create(ucg_builtin_group_ctx_t *ctx,
+                                                 enum ucg_builtin_plan_topology_type plan_topo_type,
+                                                 const ucg_builtin_config_t *config,
+                                                 const ucg_group_params_t *group_params,
+                                                 const ucg_collective_params_t *coll_params,
+                                                 ucg_builtin_plan_t **plan_p)
+{
+    ucs_status_t status;
+    ucg_group_member_index_t member_cnt = group_params->member_count;
+    ucg_group_member_index_t my_index = group_params->member_index;
+    unsigned send_ep_cnt = ucg_builtin_sparse_alltoallv_active_cnt(coll_params->send.counts, member_cnt, my_index);
+    unsigned recv_ep_cnt = ucg_builtin_sparse_alltoallv_active_cnt(coll_params->recv.counts, member_cnt, my_index);
+    unsigned ep_cnt = send_ep_cnt + recv_ep_cnt;
+    unsigned phase_ep_index = 0;
+
+    /* Allocate memory resources */
+    size_t alloc_size = sizeof(ucg_builtin_plan_t) + sizeof(ucg_builtin_plan_phase_t) +
+                        ep_cnt * (sizeof(uct_ep_h) + sizeof(unsigned));
+    ucg_builtin_plan_t *sparse = (ucg_builtin_plan_t*)ucs_malloc(alloc_size, "sparse alltoallv topology");
+    if (sparse == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+    memset(sparse, 0, alloc_size);
+
+    ucg_builtin_plan_phase_t *phase = &sparse->phss[0];
+    uct_ep_h *next_ep = (uct_ep_h*)(&sparse->phss[1]);
+    unsigned *sparse_blocks = (unsigned*)(next_ep + ep_cnt);
+
+    /* the dynamic send/recv path of throttled scatter handles the data movement */
+    phase->method      = UCG_PLAN_METHOD_ALLTOALLV_LADD;
+    phase->step_index  = 0;
+    phase->ep_cnt      = ep_cnt;
+    phase->send_ep_cnt = send_ep_cnt;
+    phase->recv_ep_cnt = recv_ep_cnt;
+    phase->multi_eps   = next_ep;
+
+    phase->ex_attr.total_num_blocks = member_cnt;
+    phase->ex_attr.num_blocks       = send_ep_cnt;
+    phase->ex_attr.member_cnt       = member_cnt;
+    phase->ex_attr.packed_rank      = my_index;
+    phase->ex_attr.is_variable_len  = 1;
+    phase->ex_attr.sparse_blocks    = sparse_blocks;
+#if ENABLE_DEBUG_DATA
+    phase->indexes = UCS_ALLOC_CHECK(ucs_max(ep_cnt, 1) * sizeof(my_index), "sparse alltoallv indexes");
+#endif
+
+    status = ucg_builtin_sparse_alltoallv_connect(ctx, phase, coll_params->send.counts, member_cnt, my_index,
+                                                  sparse_blocks, &phase_ep_index);
+    if (status == UCS_OK) {
+        status = ucg_builtin_sparse_alltoallv_connect(ctx, phase, coll_params->recv.counts, member_cnt, my_index,
+                                                      sparse_blocks, &phase_ep_index);
+    }
+    if (status != UCS_OK) {
+        ucs_error("Error in sparse alltoallv create: %d", (int)status);
+        ucs_free(sparse);
+        return status;
+    }
+
+    ucs_debug("sparse alltoallv: %u send peers, %u recv peers out of %lu members",
+              send_ep_cnt, recv_ep_cnt, member_cnt);
+
+    sparse->phs_cnt        = 1;
+    sparse->ep_cnt         = ep_cnt;
+    sparse->super.my_index = my_index;
+    *plan_p = sparse;
+    return UCS_OK;
+}
+
+UCG_BUILTIN_ALGO_REGISTER(alltoallv, COLL_TYPE_ALLTOALLV, UCG_ALGORITHM_ALLTOALLV_SPARSE,
+                          ucg_builtin_sparse_alltoallv_create);
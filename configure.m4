@@ -39,5 +39,6 @@ m4_include([src/ucg/builtin/configure.m4])
 AC_DEFINE_UNQUOTED([ucg_MODULES], ["${ucg_modules}"], [UCG loadable modules])
 
 AC_CONFIG_FILES([src/ucg/Makefile
+                 src/ucg/test/Makefile
                  src/ucg/api/ucg_version.h
                  src/ucg/base/ucg_version.c])
\ No newline at end of file
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Threads of each member run allreduces on groups over workers
+ *              of their own, all at the same time, and check every result.
+ *              Reports the throughput as the number of threads grows.
+ *              The worker is the unit of concurrency, so the threads share
+ *              no lock and the throughput should scale with the threads.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <ucs/time/time.h>
+
+#include "ucg_test_group.h"
+
+#define TEST_PROCS       2
+#define TEST_MAX_THREADS 8
+#define TEST_ITERS       2000
+#define TEST_COUNT       64
+
+typedef struct test_thread {
+    ucg_test_member_t *member;
+    ucg_worker_h       worker;
+    ucg_group_h        group;
+    pthread_t          thread;
+    pthread_barrier_t *barrier;
+    unsigned           index;
+    unsigned           errors;
+    ucs_status_t       status;
+} test_thread_t;
+
+static void *test_thread_run(void *arg)
+{
+    test_thread_t *thread = arg;
+    unsigned procs        = thread->member->procs;
+    double sbuf[TEST_COUNT], rbuf[TEST_COUNT];
+    double expected;
+    ucg_coll_h coll;
+    unsigned iter, idx;
+
+    pthread_barrier_wait(thread->barrier);
+    for (iter = 0; (iter < TEST_ITERS) && (thread->status == UCS_OK); iter++) {
+        /* the sum tells the iteration, the thread and the members apart */
+        for (idx = 0; idx < TEST_COUNT; idx++) {
+            sbuf[idx] = iter + thread->index * TEST_ITERS + thread->member->rank + idx;
+            rbuf[idx] = -1.0;
+        }
+
+        thread->status = ucg_test_allreduce_create(thread->group, sbuf, rbuf, TEST_COUNT, &coll);
+        if (thread->status != UCS_OK) {
+            break;
+        }
+        /* the same buffers find the collective cached in the plan, which owns it */
+        thread->status = ucg_test_coll_run(thread->group, coll);
+
+        for (idx = 0; idx < TEST_COUNT; idx++) {
+            expected = procs * (iter + thread->index * TEST_ITERS + idx) + procs * (procs - 1) / 2;
+            thread->errors += (rbuf[idx] != expected);
+        }
+    }
+
+    return NULL;
+}
+
+/* all the threads start together, so the groups run their collectives concurrently */
+static int test_threads(ucg_test_member_t *member, test_thread_t *threads, unsigned thread_cnt)
+{
+    pthread_barrier_t barrier;
+    ucs_time_t start;
+    unsigned idx;
+    double sec;
+    int ret = EXIT_SUCCESS;
+
+    pthread_barrier_init(&barrier, NULL, thread_cnt + 1);
+    for (idx = 0; idx < thread_cnt; idx++) {
+        threads[idx].barrier = &barrier;
+        threads[idx].errors  = 0;
+        threads[idx].status  = UCS_OK;
+        if (pthread_create(&threads[idx].thread, NULL, test_thread_run, &threads[idx]) != 0) {
+            fprintf(stderr, "rank %u: failed to create thread %u\n", member->rank, idx);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    pthread_barrier_wait(&barrier);
+    start = ucs_get_time();
+    for (idx = 0; idx < thread_cnt; idx++) {
+        pthread_join(threads[idx].thread, NULL);
+    }
+    sec = ucs_time_to_sec(ucs_get_time() - start);
+    pthread_barrier_destroy(&barrier);
+
+    for (idx = 0; idx < thread_cnt; idx++) {
+        if ((threads[idx].status != UCS_OK) || (threads[idx].errors != 0)) {
+            fprintf(stderr, "rank %u thread %u: %s, %u wrong elements\n", member->rank, idx,
+                    ucs_status_string(threads[idx].status), threads[idx].errors);
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    if (member->rank == 0) {
+        printf("%8u %14.0f %14.0f\n", thread_cnt, thread_cnt * TEST_ITERS / sec, TEST_ITERS / sec);
+    }
+    return ret;
+}
+
+static int test_rank(ucg_test_member_t *member, void *arg)
+{
+    unsigned max_threads = *(unsigned*)arg;
+    test_thread_t threads[TEST_MAX_THREADS];
+    unsigned thread_cnt, idx;
+    ucs_status_t status;
+    int ret = EXIT_SUCCESS;
+
+    /* one worker and group per thread, each only ever used by its thread */
+    memset(threads, 0, sizeof(threads));
+    for (idx = 0; idx < max_threads; idx++) {
+        threads[idx].member = member;
+        threads[idx].index  = idx;
+        status = ucg_test_worker_create(member, idx + 1, UCS_THREAD_MODE_SERIALIZED,
+                                        &threads[idx].worker);
+        if (status != UCS_OK) {
+            fprintf(stderr, "rank %u: failed to create worker %u: %s\n", member->rank, idx,
+                    ucs_status_string(status));
+            max_threads = idx;
+            ret         = EXIT_FAILURE;
+            break;
+        }
+
+        status = ucg_test_group_create_on(member, threads[idx].worker, idx + 1, idx + 1,
+                                          &threads[idx].group);
+        if (status != UCS_OK) {
+            fprintf(stderr, "rank %u: failed to create group %u: %s\n", member->rank, idx,
+                    ucs_status_string(status));
+            ucg_worker_destroy(threads[idx].worker);
+            max_threads = idx;
+            ret         = EXIT_FAILURE;
+            break;
+        }
+    }
+
+    if ((ret == EXIT_SUCCESS) && (member->rank == 0)) {
+        printf("%8s %14s %14s\n", "threads", "allreduce/s", "per thread");
+    }
+    for (thread_cnt = 1; (ret == EXIT_SUCCESS) && (thread_cnt <= max_threads); thread_cnt *= 2) {
+        ret = test_threads(member, threads, thread_cnt);
+    }
+
+    for (idx = 0; idx < max_threads; idx++) {
+        ucg_group_destroy(threads[idx].group);
+        ucg_worker_destroy(threads[idx].worker);
+    }
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned procs       = (argc > 1) ? strtoul(argv[1], NULL, 0) : TEST_PROCS;
+    unsigned max_threads = (argc > 2) ? strtoul(argv[2], NULL, 0) : TEST_MAX_THREADS;
+
+    if ((procs < 2) || (procs > UCG_TEST_MAX_PROCS) || (max_threads < 1) ||
+        (max_threads > TEST_MAX_THREADS)) {
+        fprintf(stderr, "usage: %s [procs] [threads (1..%d)]\n", argv[0], TEST_MAX_THREADS);
+        return EXIT_FAILURE;
+    }
+
+    return ucg_test_fork(procs, UCS_THREAD_MODE_SINGLE, test_rank, &max_threads);
+}
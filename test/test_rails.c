@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Large allreduces striped over two interfaces to the same peer
+ *              carry fragments on both rails and still reduce correctly.
+ *              The interfaces are those of the environment, e.g. two HCAs
+ *              selected with UCX_NET_DEVICES=mlx5_0:1,mlx5_1:1. The test is
+ *              skipped if the members are connected over a single interface.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucs/sys/math.h>
+
+#include "ucg_test_group.h"
+
+#define TEST_PROCS       2
+#define TEST_COUNT       (1024 * 1024)
+#define TEST_ITERS       10
+#define TEST_MAX_METRICS 16
+#define TEST_SKIP        77 /* automake's exit code of a skipped test */
+
+typedef struct test_shared {
+    volatile uint32_t single_rail; /* members which found nothing striped */
+} test_shared_t;
+
+static int test_rank(ucg_test_member_t *member, void *arg)
+{
+    test_shared_t *shared = arg;
+    ucg_collective_metrics_t metrics[TEST_MAX_METRICS];
+    uint64_t rail_frags[2] = {0, 0};
+    unsigned procs         = member->procs;
+    unsigned errors        = 0;
+    unsigned iter, cnt, idx;
+    ucs_status_t status;
+    double *sbuf, *rbuf;
+    ucg_group_h group;
+    ucg_coll_h coll;
+    int ret = EXIT_SUCCESS;
+
+    sbuf = malloc(TEST_COUNT * sizeof(double));
+    rbuf = malloc(TEST_COUNT * sizeof(double));
+    if ((sbuf == NULL) || (rbuf == NULL)) {
+        status = UCS_ERR_NO_MEMORY;
+        goto out_free;
+    }
+
+    status = ucg_test_group_create(member, 1, &group);
+    if (status != UCS_OK) {
+        goto out_free;
+    }
+
+    /* small values keep the sums exact */
+    for (idx = 0; idx < TEST_COUNT; idx++) {
+        sbuf[idx] = member->rank + (idx % 1024);
+    }
+
+    for (iter = 0; (iter < TEST_ITERS) && (status == UCS_OK); iter++) {
+        for (idx = 0; idx < TEST_COUNT; idx++) {
+            rbuf[idx] = -1.0;
+        }
+
+        status = ucg_test_allreduce_create(group, sbuf, rbuf, TEST_COUNT, &coll);
+        if (status == UCS_OK) {
+            status = ucg_test_coll_run(group, coll);
+        }
+
+        for (idx = 0; (idx < TEST_COUNT) && (status == UCS_OK); idx++) {
+            errors += (rbuf[idx] != procs * (double)(idx % 1024) + procs * (procs - 1) / 2);
+        }
+    }
+
+    if (status == UCS_OK) {
+        cnt = ucs_min(ucg_group_metrics_query(group, metrics, TEST_MAX_METRICS), TEST_MAX_METRICS);
+        for (idx = 0; idx < cnt; idx++) {
+            rail_frags[0] += metrics[idx].rail_frags[0];
+            rail_frags[1] += metrics[idx].rail_frags[1];
+        }
+    }
+    ucg_group_destroy(group);
+
+out_free:
+    free(rbuf);
+    free(sbuf);
+    if ((status != UCS_OK) || (errors != 0)) {
+        fprintf(stderr, "rank %u: %s, %u wrong elements\n", member->rank, ucs_status_string(status), errors);
+        return EXIT_FAILURE;
+    }
+
+    if ((rail_frags[0] == 0) && (rail_frags[1] == 0)) {
+        __sync_fetch_and_add(&shared->single_rail, 1);
+    } else if ((rail_frags[0] == 0) || (rail_frags[1] == 0)) {
+        fprintf(stderr, "rank %u: striped fragments on rail 0: %" PRIu64 ", on rail 1: %" PRIu64 "\n",
+                member->rank, rail_frags[0], rail_frags[1]);
+        ret = EXIT_FAILURE;
+    } else if (member->rank == 0) {
+        printf("fragments on rail 0: %" PRIu64 ", on rail 1: %" PRIu64 "\n", rail_frags[0], rail_frags[1]);
+    }
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned procs = (argc > 1) ? strtoul(argv[1], NULL, 0) : TEST_PROCS;
+    test_shared_t *shared;
+    int ret;
+
+    if ((procs < 2) || (procs > UCG_TEST_MAX_PROCS)) {
+        fprintf(stderr, "usage: %s [procs (2..%d)]\n", argv[0], UCG_TEST_MAX_PROCS);
+        return EXIT_FAILURE;
+    }
+
+    /* two rails, alternating fragment by fragment, unless the environment says otherwise */
+    setenv("UCX_MAX_EAGER_RAILS", "2", 0);
+    setenv("UCX_BUILTIN_MAX_RAILS", "2", 0);
+    setenv("UCX_BUILTIN_RAIL_WEIGHTED", "n", 0);
+    setenv("UCX_BUILTIN_METRICS", "y", 1);
+
+    shared = mmap(NULL, sizeof(*shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+    shared->single_rail = 0;
+
+    ret = ucg_test_fork(procs, UCS_THREAD_MODE_SINGLE, test_rank, shared);
+    if ((ret == EXIT_SUCCESS) && (shared->single_rail == procs)) {
+        printf("skipped: the members are connected over a single interface\n");
+        ret = TEST_SKIP;
+    }
+
+    munmap(shared, sizeof(*shared));
+    return ret;
+}
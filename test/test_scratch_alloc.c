@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: The scratch arena takes no memory from the system in steady state
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ucg/builtin/ops/builtin_ops.h>
+
+#define TEST_ITERS 10000
+
+#define TEST_CHECK(_cond) \
+    do { \
+        if (!(_cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #_cond); \
+            return EXIT_FAILURE; \
+        } \
+    } while (0)
+
+/* what a generic-datatype reduction borrows per message: a few sizes, some in flight together */
+static const size_t test_sizes[] = {1, 100, 4096, 4097, 65536, 1000000, 4 * 1024 * 1024};
+
+#define TEST_SIZES (sizeof(test_sizes) / sizeof(test_sizes[0]))
+
+static int test_borrow_all(ucg_builtin_scratch_t *scratch)
+{
+    void *buffers[TEST_SIZES];
+    unsigned idx;
+
+    for (idx = 0; idx < TEST_SIZES; idx++) {
+        buffers[idx] = ucg_builtin_scratch_get(scratch, test_sizes[idx]);
+        TEST_CHECK(buffers[idx] != NULL);
+        /* the whole size is usable */
+        memset(buffers[idx], (int)idx, test_sizes[idx]);
+    }
+
+    for (idx = 0; idx < TEST_SIZES; idx++) {
+        ucg_builtin_scratch_put(scratch, buffers[idx], test_sizes[idx]);
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    ucg_builtin_scratch_t scratch;
+    uint64_t alloc_cnt, get_cnt;
+    void *buffer, *again;
+    size_t held_length;
+    int8_t *held;
+    size_t huge_size;
+    int iter;
+
+    ucg_builtin_scratch_init(&scratch);
+    TEST_CHECK(scratch.alloc_cnt == 0);
+
+    /* warm-up fills every size class once */
+    TEST_CHECK(test_borrow_all(&scratch) == EXIT_SUCCESS);
+    TEST_CHECK(scratch.alloc_cnt > 0);
+
+    alloc_cnt = scratch.alloc_cnt;
+    get_cnt   = scratch.get_cnt;
+    for (iter = 0; iter < TEST_ITERS; iter++) {
+        TEST_CHECK(test_borrow_all(&scratch) == EXIT_SUCCESS);
+    }
+    TEST_CHECK(scratch.alloc_cnt == alloc_cnt);
+    TEST_CHECK(scratch.get_cnt == get_cnt + (uint64_t)TEST_ITERS * TEST_SIZES);
+
+    /* a returned buffer is handed out again */
+    buffer = ucg_builtin_scratch_get(&scratch, 8192);
+    ucg_builtin_scratch_put(&scratch, buffer, 8192);
+    again = ucg_builtin_scratch_get(&scratch, 8000);
+    TEST_CHECK(again == buffer);
+    ucg_builtin_scratch_put(&scratch, again, 8000);
+
+    /* a held buffer goes back with its length, and both are cleared */
+    held        = (int8_t*)ucg_builtin_scratch_get(&scratch, 8192);
+    held_length = 8192;
+    ucg_builtin_scratch_release(&scratch, &held, &held_length);
+    TEST_CHECK((held == NULL) && (held_length == 0));
+    again = ucg_builtin_scratch_get(&scratch, 8192);
+    TEST_CHECK(again == buffer);
+    ucg_builtin_scratch_put(&scratch, again, 8192);
+
+    /* beyond the largest class every buffer is a system allocation, and counted */
+    huge_size = (size_t)1 << (UCG_BUILTIN_SCRATCH_MIN_SHIFT + UCG_BUILTIN_SCRATCH_CLASSES);
+    alloc_cnt = scratch.alloc_cnt;
+    buffer    = ucg_builtin_scratch_get(&scratch, huge_size);
+    TEST_CHECK(buffer != NULL);
+    ucg_builtin_scratch_put(&scratch, buffer, huge_size);
+    TEST_CHECK(scratch.alloc_cnt == alloc_cnt + 1);
+
+    ucg_builtin_scratch_cleanup(&scratch);
+    printf("scratch arena: %lu buffers borrowed, %lu system allocations\n",
+           scratch.get_cnt, scratch.alloc_cnt);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Repeated starts of an allreduce take no memory from the system
+ *              once warmed up. The allocations of the starting thread are
+ *              counted by interposing the allocator of the C library.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "ucg_test_group.h"
+
+#define TEST_PROCS  4
+#define TEST_WARMUP 16
+#define TEST_ITERS  1000
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+
+static __thread volatile int test_is_counting;
+static volatile unsigned long test_alloc_cnt;
+
+void *malloc(size_t size)
+{
+    test_alloc_cnt += test_is_counting;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    test_alloc_cnt += test_is_counting;
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    test_alloc_cnt += test_is_counting;
+    return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+    test_alloc_cnt += test_is_counting;
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+    void *ptr;
+
+    test_alloc_cnt += test_is_counting;
+    ptr = __libc_memalign(alignment, size);
+    if (ptr == NULL) {
+        return ENOMEM;
+    }
+    *memptr = ptr;
+    return 0;
+}
+
+/* small, fragmented and rendezvous messages */
+static const int test_counts[] = {8, 16 * 1024, 512 * 1024};
+
+#define TEST_COUNTS (sizeof(test_counts) / sizeof(test_counts[0]))
+
+static ucs_status_t test_run(ucg_test_member_t *member, ucg_group_h group, double *sbuf, double *rbuf,
+                             int count, unsigned iters, unsigned *errors)
+{
+    unsigned procs = member->procs;
+    ucs_status_t status;
+    ucg_coll_h coll;
+    unsigned iter;
+    int idx;
+
+    for (iter = 0; iter < iters; iter++) {
+        for (idx = 0; idx < count; idx++) {
+            rbuf[idx] = -1.0;
+        }
+
+        /* the same buffers find the collective cached in the plan */
+        status = ucg_test_allreduce_create(group, sbuf, rbuf, count, &coll);
+        if (status != UCS_OK) {
+            return status;
+        }
+
+        status = ucg_test_coll_run(group, coll);
+        if (status != UCS_OK) {
+            return status;
+        }
+
+        for (idx = 0; idx < count; idx++) {
+            *errors += (rbuf[idx] != procs * (double)idx + procs * (procs - 1) / 2);
+        }
+    }
+    return UCS_OK;
+}
+
+static int test_rank(ucg_test_member_t *member, void *arg)
+{
+    unsigned long alloc_cnt = 0;
+    unsigned errors = 0;
+    ucs_status_t status;
+    double *sbuf, *rbuf;
+    ucg_group_h group;
+    unsigned size_idx;
+    int idx, ret = EXIT_SUCCESS;
+
+    status = ucg_test_group_create(member, 1, &group);
+    if (status != UCS_OK) {
+        fprintf(stderr, "rank %u: %s\n", member->rank, ucs_status_string(status));
+        return EXIT_FAILURE;
+    }
+
+    for (size_idx = 0; (size_idx < TEST_COUNTS) && (ret == EXIT_SUCCESS); size_idx++) {
+        sbuf = malloc(test_counts[size_idx] * sizeof(double));
+        rbuf = malloc(test_counts[size_idx] * sizeof(double));
+        if ((sbuf == NULL) || (rbuf == NULL)) {
+            free(rbuf);
+            free(sbuf);
+            ret = EXIT_FAILURE;
+            break;
+        }
+        for (idx = 0; idx < test_counts[size_idx]; idx++) {
+            sbuf[idx] = member->rank + idx;
+        }
+
+        status = test_run(member, group, sbuf, rbuf, test_counts[size_idx], TEST_WARMUP, &errors);
+        if (status == UCS_OK) {
+            alloc_cnt        = test_alloc_cnt;
+            test_is_counting = 1;
+            status = test_run(member, group, sbuf, rbuf, test_counts[size_idx], TEST_ITERS, &errors);
+            test_is_counting = 0;
+            alloc_cnt        = test_alloc_cnt - alloc_cnt;
+        }
+
+        if ((status != UCS_OK) || (errors != 0) || (alloc_cnt != 0)) {
+            fprintf(stderr, "rank %u, %d doubles: %s, %u wrong elements, %lu allocations in %u starts\n",
+                    member->rank, test_counts[size_idx], ucs_status_string(status), errors,
+                    alloc_cnt, TEST_ITERS);
+            ret = EXIT_FAILURE;
+        } else if (member->rank == 0) {
+            printf("%10d doubles: no allocations in %u starts\n", test_counts[size_idx], TEST_ITERS);
+        }
+
+        free(rbuf);
+        free(sbuf);
+    }
+
+    ucg_group_destroy(group);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned procs = (argc > 1) ? strtoul(argv[1], NULL, 0) : TEST_PROCS;
+
+    if ((procs < 2) || (procs > UCG_TEST_MAX_PROCS)) {
+        fprintf(stderr, "usage: %s [procs (2..%d)]\n", argv[0], UCG_TEST_MAX_PROCS);
+        return EXIT_FAILURE;
+    }
+
+    return ucg_test_fork(procs, UCS_THREAD_MODE_SINGLE, test_rank, NULL);
+}
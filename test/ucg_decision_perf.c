@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Microbenchmark of the per-collective algorithm decision, alone
+ *              and within ucg_collective_create of an allreduce found in the
+ *              plan cache, in a host-local group. Neither logs anything unless
+ *              UCX_LOG_LEVEL is raised to debug or beyond.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucs/time/time.h>
+
+#include <ucg/base/ucg_group.h>
+#include <ucg/builtin/plan/builtin_algo_decision.h>
+
+#include "ucg_test_group.h"
+
+#define UCG_DECISION_PERF_PROCS   2
+#define UCG_DECISION_PERF_MAX_SZ  (1024 * 1024)
+#define UCG_DECISION_PERF_ITERS   100000
+
+typedef struct ucg_decision_perf_args {
+    size_t   max_size;
+    unsigned iters;
+} ucg_decision_perf_args_t;
+
+static ucs_status_t ucg_decision_perf_size(ucg_group_h group, double *sbuf, double *rbuf, size_t size,
+                                           unsigned iters, double *decision_ns, double *create_ns)
+{
+    ucg_op_t *op;
+    ucg_coll_h coll;
+    ucs_time_t start;
+    ucs_status_t status;
+    volatile int algo;
+    unsigned iter;
+
+    /* the first create takes the plan, the next ones find it with the operation */
+    status = ucg_test_allreduce_create(group, sbuf, rbuf, size / sizeof(double), &coll);
+    if (status != UCS_OK) {
+        return status;
+    }
+    op = (ucg_op_t*)coll;
+
+    start = ucs_get_time();
+    for (iter = 0; iter < iters; iter++) {
+        algo = ucg_builtin_algo_decision(&group->params, &op->params);
+    }
+    *decision_ns = ucs_time_to_nsec(ucs_get_time() - start) / iters;
+    (void)algo;
+
+    start = ucs_get_time();
+    for (iter = 0; (iter < iters) && (status == UCS_OK); iter++) {
+        status = ucg_test_allreduce_create(group, sbuf, rbuf, size / sizeof(double), &coll);
+    }
+    *create_ns = ucs_time_to_nsec(ucs_get_time() - start) / iters;
+    if ((status == UCS_OK) && (coll != (ucg_coll_h)op)) {
+        fprintf(stderr, "allreduce of %zu bytes was not found in the plan cache\n", size);
+        status = UCS_ERR_IO_ERROR;
+    }
+    return status;
+}
+
+static int ucg_decision_perf_rank(ucg_test_member_t *member, void *arg)
+{
+    const ucg_decision_perf_args_t *args = arg;
+    double decision_ns, create_ns;
+    double *sbuf, *rbuf;
+    ucs_status_t status;
+    ucg_group_h group;
+    size_t size;
+
+    sbuf = calloc(1, args->max_size);
+    rbuf = calloc(1, args->max_size);
+    if ((sbuf == NULL) || (rbuf == NULL)) {
+        status = UCS_ERR_NO_MEMORY;
+        goto out_free;
+    }
+
+    status = ucg_test_group_create(member, 1, &group);
+    if (status != UCS_OK) {
+        goto out_free;
+    }
+
+    /* the collectives are only created, the members do not need to be in step */
+    for (size = sizeof(double); (status == UCS_OK) && (size <= args->max_size); size *= 4) {
+        status = ucg_decision_perf_size(group, sbuf, rbuf, size, args->iters, &decision_ns, &create_ns);
+        if ((status == UCS_OK) && (member->rank == 0)) {
+            printf("%10zu %14.1f %14.1f\n", size, decision_ns, create_ns);
+        }
+    }
+
+    ucg_group_destroy(group);
+out_free:
+    free(rbuf);
+    free(sbuf);
+    if (status != UCS_OK) {
+        fprintf(stderr, "rank %u: %s\n", member->rank, ucs_status_string(status));
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    ucg_decision_perf_args_t args;
+    unsigned procs;
+
+    procs         = (argc > 1) ? strtoul(argv[1], NULL, 0) : UCG_DECISION_PERF_PROCS;
+    args.max_size = (argc > 2) ? strtoul(argv[2], NULL, 0) : UCG_DECISION_PERF_MAX_SZ;
+    args.iters    = (argc > 3) ? strtoul(argv[3], NULL, 0) : UCG_DECISION_PERF_ITERS;
+    if ((procs < 1) || (procs > UCG_TEST_MAX_PROCS) || (args.max_size < sizeof(double)) ||
+        (args.iters == 0)) {
+        fprintf(stderr, "usage: %s [procs (1..%d)] [max bytes] [iterations]\n", argv[0], UCG_TEST_MAX_PROCS);
+        return EXIT_FAILURE;
+    }
+
+    printf("%10s %14s %14s\n", "bytes", "decision ns", "create ns");
+    return ucg_test_fork(procs, UCS_THREAD_MODE_SINGLE, ucg_decision_perf_rank, &args);
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Overlap benchmark of non-blocking allreduce with computation,
+ *              without and with the builtin progress thread, in a host-local
+ *              group.
+ *
+ *              overlap = 100 * (1 - (t_total - t_compute) / t_pure)
+ *
+ *              where t_pure is start and wait alone, t_compute a busy loop as
+ *              long as t_pure, and t_total start, the same busy loop and wait.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucs/time/time.h>
+
+#include "ucg_test_group.h"
+
+#define UCG_OVERLAP_PERF_PROCS     4
+#define UCG_OVERLAP_PERF_MAX_SZ    (1024 * 1024)
+#define UCG_OVERLAP_PERF_WARMUP    10
+#define UCG_OVERLAP_PERF_ITERS     100
+
+typedef struct ucg_overlap_perf {
+    ucg_group_h group;
+    ucg_coll_h  coll;
+} ucg_overlap_perf_t;
+
+typedef struct ucg_overlap_perf_args {
+    size_t max_size;
+    int    is_async;
+} ucg_overlap_perf_args_t;
+
+static ucs_status_t ucg_overlap_perf_allreduce(ucg_overlap_perf_t *perf)
+{
+    return ucg_test_coll_run(perf->group, perf->coll);
+}
+
+/* computation which never calls into the library */
+static void ucg_overlap_perf_compute(ucs_time_t duration)
+{
+    ucs_time_t end = ucs_get_time() + duration;
+
+    while (ucs_get_time() < end) {
+    }
+}
+
+/* mean of the iterations, in seconds */
+static ucs_status_t ucg_overlap_perf_measure(ucg_overlap_perf_t *perf, ucs_time_t compute,
+                                             int is_start, int is_wait, double *sec_p)
+{
+    ucs_status_ptr_t req = NULL;
+    ucs_status_t status;
+    ucs_time_t start;
+    int iter;
+
+    start = ucs_get_time();
+    for (iter = 0; iter < UCG_OVERLAP_PERF_ITERS; iter++) {
+        if (is_start) {
+            req = ucg_collective_start_nb(perf->coll);
+            if (UCS_PTR_IS_ERR(req)) {
+                return UCS_PTR_STATUS(req);
+            }
+        }
+
+        ucg_overlap_perf_compute(compute);
+
+        if (is_wait && (req != NULL)) {
+            status = ucg_request_wait(perf->group, req);
+            if (status != UCS_OK) {
+                return status;
+            }
+        }
+    }
+
+    *sec_p = ucs_time_to_sec(ucs_get_time() - start) / UCG_OVERLAP_PERF_ITERS;
+    return UCS_OK;
+}
+
+static ucs_status_t ucg_overlap_perf_size(ucg_overlap_perf_t *perf, ucg_overlap_perf_t *barrier,
+                                          unsigned rank, size_t size, int is_async)
+{
+    double t_pure, t_compute, t_total, overlap;
+    ucs_status_t status;
+    int iter;
+
+    for (iter = 0; iter < UCG_OVERLAP_PERF_WARMUP; iter++) {
+        status = ucg_overlap_perf_allreduce(perf);
+        if (status != UCS_OK) {
+            return status;
+        }
+    }
+
+    status = ucg_overlap_perf_allreduce(barrier);
+    if (status == UCS_OK) {
+        status = ucg_overlap_perf_measure(perf, 0, 1, 1, &t_pure);
+    }
+    if (status == UCS_OK) {
+        status = ucg_overlap_perf_measure(perf, ucs_time_from_sec(t_pure), 0, 0, &t_compute);
+    }
+    if (status == UCS_OK) {
+        status = ucg_overlap_perf_allreduce(barrier);
+    }
+    if (status == UCS_OK) {
+        status = ucg_overlap_perf_measure(perf, ucs_time_from_sec(t_pure), 1, 1, &t_total);
+    }
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    overlap = 100.0 * (1.0 - (t_total - t_compute) / t_pure);
+    overlap = ucs_max(0.0, ucs_min(100.0, overlap));
+    if (rank == 0) {
+        printf("%-6s %10zu %12.2f %12.2f %12.2f %9.1f\n", is_async ? "thread" : "none", size,
+               t_pure * 1e6, t_compute * 1e6, t_total * 1e6, overlap);
+    }
+    return UCS_OK;
+}
+
+static int ucg_overlap_perf_rank(ucg_test_member_t *member, void *arg)
+{
+    const ucg_overlap_perf_args_t *args = arg;
+    ucg_overlap_perf_t perf, barrier;
+    double *sbuf, *rbuf;
+    double one = 1.0, sum;
+    ucs_status_t status;
+    size_t size;
+
+    sbuf = malloc(args->max_size);
+    rbuf = malloc(args->max_size);
+    if ((sbuf == NULL) || (rbuf == NULL)) {
+        status = UCS_ERR_NO_MEMORY;
+        goto out_free;
+    }
+    memset(sbuf, 0, args->max_size);
+
+    status = ucg_test_group_create(member, 1, &perf.group);
+    if (status != UCS_OK) {
+        goto out_free;
+    }
+    barrier.group = perf.group;
+
+    /* a one-element allreduce keeps the members in step, and checks the group works */
+    status = ucg_test_allreduce_create(perf.group, &one, &sum, 1, &barrier.coll);
+    if (status != UCS_OK) {
+        goto out_group;
+    }
+    status = ucg_overlap_perf_allreduce(&barrier);
+    if ((status == UCS_OK) && (sum != member->procs)) {
+        fprintf(stderr, "rank %u: allreduce of ones returned %f\n", member->rank, sum);
+        status = UCS_ERR_IO_ERROR;
+    }
+
+    for (size = sizeof(double); (status == UCS_OK) && (size <= args->max_size); size *= 4) {
+        status = ucg_test_allreduce_create(perf.group, sbuf, rbuf, size / sizeof(double), &perf.coll);
+        if (status != UCS_OK) {
+            break;
+        }
+        /* non-persistent: the group keeps the collective in its plan, and releases it */
+        status = ucg_overlap_perf_size(&perf, &barrier, member->rank, size, args->is_async);
+    }
+
+out_group:
+    ucg_group_destroy(perf.group);
+out_free:
+    free(rbuf);
+    free(sbuf);
+    if (status != UCS_OK) {
+        fprintf(stderr, "rank %u: %s\n", member->rank, ucs_status_string(status));
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    ucg_overlap_perf_args_t args;
+    unsigned procs;
+    int ret;
+
+    procs         = (argc > 1) ? strtoul(argv[1], NULL, 0) : UCG_OVERLAP_PERF_PROCS;
+    args.max_size = (argc > 2) ? strtoul(argv[2], NULL, 0) : UCG_OVERLAP_PERF_MAX_SZ;
+    if ((procs < 2) || (procs > UCG_TEST_MAX_PROCS) || (args.max_size < sizeof(double))) {
+        fprintf(stderr, "usage: %s [procs (2..%d)] [max bytes]\n", argv[0], UCG_TEST_MAX_PROCS);
+        return EXIT_FAILURE;
+    }
+
+    printf("%-6s %10s %12s %12s %12s %9s\n", "async", "bytes", "pure usec", "compute usec",
+           "total usec", "overlap%");
+
+    /* read by each member's ucg_init, the progress thread needs a thread-safe worker */
+    args.is_async = 0;
+    setenv("UCX_BUILTIN_ASYNC_PROGRESS", "n", 1);
+    ret = ucg_test_fork(procs, UCS_THREAD_MODE_MULTI, ucg_overlap_perf_rank, &args);
+    if (ret == EXIT_SUCCESS) {
+        args.is_async = 1;
+        setenv("UCX_BUILTIN_ASYNC_PROGRESS", "y", 1);
+        ret = ucg_test_fork(procs, UCS_THREAD_MODE_MULTI, ucg_overlap_perf_rank, &args);
+    }
+    return ret;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Micro-benchmark of the native reduction kernels against the
+ *              MPI reduce callback they replace
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucs/time/time.h>
+
+#include <ucg/builtin/ops/builtin_ops.h>
+
+#define UCG_REDUCE_PERF_ITERS  200
+#define UCG_REDUCE_PERF_MAX_SZ (8 * 1024 * 1024)
+
+/* the handles point to the codes, a NULL operation would be taken for a user-defined one */
+static int ucg_reduce_perf_operate_param(void *mpi_op, void *mpi_dt, int *op, int *dt)
+{
+    *op = *(const int*)mpi_op;
+    *dt = *(const int*)mpi_dt;
+    return 0;
+}
+
+/* stands in for mpi_reduce_f, called through a pointer like the builtin callbacks do */
+static void ucg_reduce_perf_mpi_sum_double(void *mpi_op, char *src, char *dst, unsigned count, void *mpi_dtype)
+{
+    unsigned idx;
+
+    for (idx = 0; idx < count; idx++) {
+        ((double*)dst)[idx] += ((const double*)src)[idx];
+    }
+}
+
+static void (*volatile mpi_reduce_f)(void*, char*, char*, unsigned, void*) = ucg_reduce_perf_mpi_sum_double;
+
+static double ucg_reduce_perf_run(ucg_builtin_reduce_kernel_f kernel, const void *src, void *dst, unsigned count)
+{
+    ucs_time_t start;
+    int iter;
+
+    start = ucs_get_time();
+    for (iter = 0; iter < UCG_REDUCE_PERF_ITERS; iter++) {
+        if (kernel != NULL) {
+            kernel(src, dst, count);
+        } else {
+            mpi_reduce_f(NULL, (char*)src, dst, count, NULL);
+        }
+    }
+
+    return ucs_time_to_sec(ucs_get_time() - start) / UCG_REDUCE_PERF_ITERS;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct {
+        const char *name;
+        int        op;
+        int        dt;
+        size_t     dt_len;
+    } cases[] = {
+        {"sum double",   UCG_OP_SUM,  UCG_DT_DOUBLE,   sizeof(double)},
+        {"sum float",    UCG_OP_SUM,  UCG_DT_FLOAT,    sizeof(float)},
+        {"max int32",    UCG_OP_MAX,  UCG_DT_INT32,    sizeof(int32_t)},
+        {"bxor uint64",  UCG_OP_BXOR, UCG_DT_UINT64,   sizeof(uint64_t)},
+        {"sum float16",  UCG_OP_SUM,  UCG_DT_FLOAT16,  sizeof(uint16_t)},
+        {"sum bfloat16", UCG_OP_SUM,  UCG_DT_BFLOAT16, sizeof(uint16_t)},
+    };
+    ucg_group_params_t group_params;
+    ucg_builtin_reduce_kernel_f kernel;
+    size_t size, max_size;
+    void *src, *dst;
+    unsigned idx;
+    double sec;
+
+    max_size = (argc > 1) ? strtoul(argv[1], NULL, 0) : UCG_REDUCE_PERF_MAX_SZ;
+    src      = malloc(max_size);
+    dst      = malloc(max_size);
+    if ((src == NULL) || (dst == NULL)) {
+        fprintf(stderr, "failed to allocate %zu bytes\n", max_size);
+        return EXIT_FAILURE;
+    }
+
+    /* zeroes are a valid value of every datatype, so no kernel hits denormals or NaNs */
+    memset(src, 0, max_size);
+    memset(dst, 0, max_size);
+
+    memset(&group_params, 0, sizeof(group_params));
+    group_params.get_operate_param_f = ucg_reduce_perf_operate_param;
+    ucg_builtin_reduce_init(1);
+
+    printf("%-14s %10s %12s %12s\n", "kernel", "bytes", "usec", "GB/s");
+    for (idx = 0; idx < sizeof(cases) / sizeof(cases[0]); idx++) {
+        kernel = ucg_builtin_reduce_kernel_find(&group_params, (void*)&cases[idx].op,
+                                                (void*)&cases[idx].dt, cases[idx].dt_len);
+        if (kernel == NULL) {
+            fprintf(stderr, "no native kernel for %s\n", cases[idx].name);
+            return EXIT_FAILURE;
+        }
+
+        for (size = 1024; size <= max_size; size *= 4) {
+            sec = ucg_reduce_perf_run(kernel, src, dst, size / cases[idx].dt_len);
+            printf("%-14s %10zu %12.2f %12.2f\n", cases[idx].name, size, sec * 1e6, size / sec / 1e9);
+        }
+    }
+
+    /* the path every reduction took before the native kernels */
+    for (size = 1024; size <= max_size; size *= 4) {
+        sec = ucg_reduce_perf_run(NULL, src, dst, size / sizeof(double));
+        printf("%-14s %10zu %12.2f %12.2f\n", "mpi callback", size, sec * 1e6, size / sec / 1e9);
+    }
+
+    free(src);
+    free(dst);
+    return EXIT_SUCCESS;
+}
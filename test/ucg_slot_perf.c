@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Stress benchmark of the per-step store of early messages: every
+ *              peer sends every step ahead, in random order, mixed with messages
+ *              of a later operation, and each step is drained as it comes
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucs/time/time.h>
+
+#include <ucg/builtin/ops/builtin_ops.h>
+
+#define UCG_SLOT_PERF_STEPS     40 /* more than UCG_BUILTIN_MSG_BUCKETS, so queues are shared */
+#define UCG_SLOT_PERF_MAX_PEERS 16384
+#define UCG_SLOT_PERF_COLL_ID   7
+
+#define TEST_CHECK(_cond) \
+    do { \
+        if (!(_cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #_cond); \
+            return EXIT_FAILURE; \
+        } \
+    } while (0)
+
+static ucg_builtin_op_step_t ucg_slot_perf_steps[UCG_SLOT_PERF_STEPS];
+static unsigned ucg_slot_perf_recvd[UCG_SLOT_PERF_STEPS];
+static uint8_t *ucg_slot_perf_seen;  /* per step and peer */
+static unsigned ucg_slot_perf_peers;
+static unsigned ucg_slot_perf_errors;
+
+static int ucg_slot_perf_recv_cb(ucg_builtin_request_t *req, uint64_t offset,
+                                 const void *data, size_t length)
+{
+    unsigned step_idx = req->step - ucg_slot_perf_steps;
+    uint8_t *seen;
+
+    /* every message of this step exactly once, and nothing of any other */
+    if ((offset >= ucg_slot_perf_peers) || (length != sizeof(unsigned)) ||
+        (*(const unsigned*)data != step_idx)) {
+        ucg_slot_perf_errors++;
+        return 0;
+    }
+
+    seen = &ucg_slot_perf_seen[step_idx * ucg_slot_perf_peers + offset];
+    if (*seen != 0) {
+        ucg_slot_perf_errors++;
+    }
+    *seen = 1;
+
+    return ++ucg_slot_perf_recvd[step_idx] == ucg_slot_perf_peers;
+}
+
+static ucg_builtin_comp_desc_t *ucg_slot_perf_desc(ucg_coll_id_t coll_id, ucg_step_idx_t step_idx,
+                                                   unsigned peer)
+{
+    ucg_builtin_comp_desc_t *desc = malloc(sizeof(*desc) + sizeof(unsigned));
+
+    if (desc == NULL) {
+        return NULL;
+    }
+
+    desc->release                = free;
+    desc->super.length           = sizeof(unsigned);
+    desc->header.header          = 0;
+    desc->header.coll_id         = coll_id;
+    desc->header.step_idx        = step_idx;
+    desc->header.remote_offset   = peer;
+    *(unsigned*)&desc->data[0]   = step_idx;
+    return desc;
+}
+
+/* what the active message handler does for a message ahead of its step */
+static void ucg_slot_perf_store(ucg_builtin_comp_slot_t *slot, ucg_builtin_comp_desc_t *desc)
+{
+    ucs_list_add_tail(ucg_builtin_slot_msgs(slot, desc->header.step_idx), &desc->super.tag_list[0]);
+    slot->msg_cnt++;
+}
+
+static int ucg_slot_perf_run(unsigned peers, double *store_sec, double *drain_sec)
+{
+    unsigned msg_cnt = peers * UCG_SLOT_PERF_STEPS;
+    ucg_builtin_plan_phase_t phase;
+    ucg_builtin_comp_slot_t slot;
+    ucg_builtin_comp_desc_t **descs;
+    ucg_request_t comp_req;
+    ucg_builtin_op_t op;
+    unsigned idx, other, bucket;
+    ucs_time_t start;
+    ucs_status_t status;
+
+    /* each message has a twin of the next operation, left in the store */
+    descs = malloc(2 * msg_cnt * sizeof(*descs));
+    TEST_CHECK(descs != NULL);
+    for (idx = 0; idx < msg_cnt; idx++) {
+        descs[2 * idx]     = ucg_slot_perf_desc(UCG_SLOT_PERF_COLL_ID, idx / peers, idx % peers);
+        descs[2 * idx + 1] = ucg_slot_perf_desc(UCG_SLOT_PERF_COLL_ID + 1, idx / peers, idx % peers);
+        TEST_CHECK((descs[2 * idx] != NULL) && (descs[2 * idx + 1] != NULL));
+    }
+
+    /* arrival order: any step, any peer */
+    for (idx = 2 * msg_cnt - 1; idx > 0; idx--) {
+        ucg_builtin_comp_desc_t *tmp = descs[idx];
+        other                        = (unsigned)rand() % (idx + 1);
+        descs[idx]                   = descs[other];
+        descs[other]                 = tmp;
+    }
+
+    memset(&slot, 0, sizeof(slot));
+    memset(&phase, 0, sizeof(phase));
+    memset(&op, 0, sizeof(op));
+    memset(&comp_req, 0, sizeof(comp_req));
+    memset(ucg_slot_perf_steps, 0, sizeof(ucg_slot_perf_steps));
+    memset(ucg_slot_perf_recvd, 0, sizeof(ucg_slot_perf_recvd));
+    memset(ucg_slot_perf_seen, 0, msg_cnt);
+    ucg_slot_perf_peers = peers;
+    for (bucket = 0; bucket < UCG_BUILTIN_MSG_BUCKETS; bucket++) {
+        ucs_list_head_init(&slot.msg_head[bucket]);
+    }
+    for (idx = 0; idx < UCG_SLOT_PERF_STEPS; idx++) {
+        ucg_slot_perf_steps[idx].phase   = &phase;
+        ucg_slot_perf_steps[idx].recv_cb = ucg_slot_perf_recv_cb;
+    }
+    slot.req.op       = &op;
+    slot.req.comp_req = &comp_req;
+    slot.coll_id      = UCG_SLOT_PERF_COLL_ID;
+
+    start = ucs_get_time();
+    for (idx = 0; idx < 2 * msg_cnt; idx++) {
+        ucg_slot_perf_store(&slot, descs[idx]);
+    }
+    *store_sec = ucs_time_to_sec(ucs_get_time() - start);
+    TEST_CHECK(slot.msg_cnt == 2 * msg_cnt);
+
+    start = ucs_get_time();
+    for (idx = 0; idx < UCG_SLOT_PERF_STEPS; idx++) {
+        slot.step_idx = idx;
+        slot.req.step = &ucg_slot_perf_steps[idx];
+        status        = ucg_builtin_msg_process(&slot, &slot.req);
+        TEST_CHECK(status == UCS_INPROGRESS);
+        TEST_CHECK(ucg_slot_perf_recvd[idx] == peers);
+    }
+    *drain_sec = ucs_time_to_sec(ucs_get_time() - start);
+
+    TEST_CHECK(ucg_slot_perf_errors == 0);
+    TEST_CHECK(slot.msg_cnt == msg_cnt);
+
+    /* the next operation finds exactly its own messages */
+    slot.coll_id = UCG_SLOT_PERF_COLL_ID + 1;
+    memset(ucg_slot_perf_recvd, 0, sizeof(ucg_slot_perf_recvd));
+    memset(ucg_slot_perf_seen, 0, msg_cnt);
+    for (idx = 0; idx < UCG_SLOT_PERF_STEPS; idx++) {
+        slot.step_idx = idx;
+        slot.req.step = &ucg_slot_perf_steps[idx];
+        (void)ucg_builtin_msg_process(&slot, &slot.req);
+        TEST_CHECK(ucg_slot_perf_recvd[idx] == peers);
+    }
+    TEST_CHECK(ucg_slot_perf_errors == 0);
+    TEST_CHECK(slot.msg_cnt == 0);
+    for (bucket = 0; bucket < UCG_BUILTIN_MSG_BUCKETS; bucket++) {
+        TEST_CHECK(ucs_list_is_empty(&slot.msg_head[bucket]));
+    }
+
+    free(descs);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned max_peers, peers;
+    double store_sec, drain_sec;
+
+    max_peers = (argc > 1) ? strtoul(argv[1], NULL, 0) : UCG_SLOT_PERF_MAX_PEERS;
+    ucg_slot_perf_seen = malloc((size_t)max_peers * UCG_SLOT_PERF_STEPS);
+    if (ucg_slot_perf_seen == NULL) {
+        fprintf(stderr, "failed to allocate for %u peers\n", max_peers);
+        return EXIT_FAILURE;
+    }
+
+    srand(1);
+    printf("%8s %10s %14s %14s\n", "peers", "messages", "store ns/msg", "drain ns/msg");
+    for (peers = 16; peers <= max_peers; peers *= 4) {
+        if (ucg_slot_perf_run(peers, &store_sec, &drain_sec) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+
+        /* both stay flat as the peers grow: a step only walks its own queue */
+        printf("%8u %10u %14.1f %14.1f\n", peers, 2 * peers * UCG_SLOT_PERF_STEPS,
+               store_sec * 1e9 / (2 * peers * UCG_SLOT_PERF_STEPS),
+               drain_sec * 1e9 / (peers * UCG_SLOT_PERF_STEPS));
+    }
+
+    free(ucg_slot_perf_seen);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Host-local groups for the tests and benchmarks
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "ucg_test_group.h"
+
+static int ucg_test_dt; /* MPI_DOUBLE stand-in */
+static int ucg_test_op; /* MPI_SUM stand-in */
+
+static void ucg_test_reduce(void *mpi_op, char *src, char *dst, unsigned count, void *mpi_dtype)
+{
+    unsigned idx;
+
+    for (idx = 0; idx < count; idx++) {
+        ((double*)dst)[idx] += ((const double*)src)[idx];
+    }
+}
+
+static ucs_status_t ucg_test_resolve(void *cb_group_obj, ucg_group_member_index_t index,
+                                     ucg_address_t **addr, size_t *addr_len)
+{
+    ucg_test_slot_t *slot = cb_group_obj;
+
+    *addr     = (ucg_address_t*)slot->addr[index];
+    *addr_len = slot->addr_len[index];
+    return UCS_OK;
+}
+
+static void ucg_test_release(ucg_address_t *addr)
+{
+}
+
+static int ucg_test_is_commute(void *mpi_op)
+{
+    return 1;
+}
+
+static int ucg_test_dt_convert(void *dt_ext, ucp_datatype_t *ucp_datatype)
+{
+    *ucp_datatype = ucp_dt_make_contig(sizeof(double));
+    return 0;
+}
+
+static int ucg_test_dt_is_predefine(void *mpi_dt)
+{
+    return 1;
+}
+
+static ucg_group_member_index_t ucg_test_global_idx(void *cb_group_obj, ucg_group_member_index_t index)
+{
+    return index;
+}
+
+static enum ucg_group_member_distance ucg_test_distance(void *comm, int rank1, int rank2)
+{
+    return (rank1 == rank2) ? UCG_GROUP_MEMBER_DISTANCE_SELF : UCG_GROUP_MEMBER_DISTANCE_SOCKET;
+}
+
+static ptrdiff_t ucg_test_dt_span(void *dt_ext, int count, ptrdiff_t *gap)
+{
+    *gap = 0;
+    return count * sizeof(double);
+}
+
+static int ucg_test_operate_param(void *mpi_op, void *mpi_dt, int *op, int *dt)
+{
+    *op = UCG_OP_SUM;
+    *dt = UCG_DT_DOUBLE;
+    return 0;
+}
+
+static ucs_status_t ucg_test_worker_init(ucg_test_member_t *member, unsigned slot,
+                                         ucs_thread_mode_t thread_mode, ucg_worker_h *worker_p)
+{
+    ucg_test_slot_t *addrs = &member->shm->slots[slot];
+    ucp_worker_params_t worker_params;
+    ucg_address_t *addr;
+    ucs_status_t status;
+    size_t addr_len;
+
+    memset(&worker_params, 0, sizeof(worker_params));
+    worker_params.field_mask  = UCP_WORKER_PARAM_FIELD_THREAD_MODE;
+    worker_params.thread_mode = thread_mode;
+    status = ucg_worker_create(member->context, &worker_params, worker_p);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    status = ucg_worker_get_address(*worker_p, &addr, &addr_len);
+    if (status != UCS_OK) {
+        goto err_worker;
+    }
+    if (addr_len > UCG_TEST_ADDR_MAX) {
+        ucg_worker_release_address(*worker_p, addr);
+        status = UCS_ERR_EXCEEDS_LIMIT;
+        goto err_worker;
+    }
+    memcpy(addrs->addr[member->rank], addr, addr_len);
+    addrs->addr_len[member->rank] = addr_len;
+    ucg_worker_release_address(*worker_p, addr);
+
+    /* all the addresses are in place before anyone connects */
+    __sync_fetch_and_add(&addrs->arrived, 1);
+    while (addrs->arrived < member->procs) {
+        sched_yield();
+    }
+    return UCS_OK;
+
+err_worker:
+    ucg_worker_destroy(*worker_p);
+    return status;
+}
+
+static ucs_status_t ucg_test_member_init(ucg_test_member_t *member, ucs_thread_mode_t thread_mode)
+{
+    ucp_params_t ctx_params;
+    ucs_status_t status;
+
+    member->node_index = calloc(member->procs, sizeof(*member->node_index));
+    if (member->node_index == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    /* the workers of a member may be driven by threads of their own */
+    memset(&ctx_params, 0, sizeof(ctx_params));
+    ctx_params.field_mask        = UCP_PARAM_FIELD_FEATURES | UCP_PARAM_FIELD_MT_WORKERS_SHARED;
+    ctx_params.features          = UCP_FEATURE_TAG | UCP_FEATURE_RMA;
+    ctx_params.mt_workers_shared = 1;
+    status = ucg_init(&ctx_params, NULL, &member->context);
+    if (status != UCS_OK) {
+        goto err_free;
+    }
+
+    status = ucg_test_worker_init(member, 0, thread_mode, &member->worker);
+    if (status != UCS_OK) {
+        goto err_cleanup;
+    }
+    return UCS_OK;
+
+err_cleanup:
+    ucg_cleanup(member->context);
+err_free:
+    free(member->node_index);
+    return status;
+}
+
+static void ucg_test_member_cleanup(ucg_test_member_t *member)
+{
+    ucg_worker_destroy(member->worker);
+    ucg_cleanup(member->context);
+    free(member->node_index);
+}
+
+int ucg_test_fork(unsigned procs, ucs_thread_mode_t thread_mode, ucg_test_rank_f rank_f, void *arg)
+{
+    pid_t pids[UCG_TEST_MAX_PROCS];
+    ucg_test_member_t member;
+    ucg_test_shm_t *shm;
+    ucs_status_t status;
+    int ret = EXIT_SUCCESS;
+    unsigned rank;
+    int wstatus;
+    pid_t pid;
+
+    if ((procs < 1) || (procs > UCG_TEST_MAX_PROCS)) {
+        fprintf(stderr, "%u members, at most %d are supported\n", procs, UCG_TEST_MAX_PROCS);
+        return EXIT_FAILURE;
+    }
+
+    shm = mmap(NULL, sizeof(*shm), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shm == MAP_FAILED) {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+    fflush(stdout);
+
+    for (rank = 0; rank < procs; rank++) {
+        pid = fork();
+        if (pid < 0) {
+            /* the members started so far would wait for this one forever */
+            perror("fork");
+            while (rank > 0) {
+                kill(pids[--rank], SIGKILL);
+                waitpid(pids[rank], NULL, 0);
+            }
+            munmap(shm, sizeof(*shm));
+            return EXIT_FAILURE;
+        } else if (pid > 0) {
+            pids[rank] = pid;
+            continue;
+        }
+
+        memset(&member, 0, sizeof(member));
+        member.shm   = shm;
+        member.rank  = rank;
+        member.procs = procs;
+        status       = ucg_test_member_init(&member, thread_mode);
+        if (status != UCS_OK) {
+            fprintf(stderr, "rank %u: %s\n", rank, ucs_status_string(status));
+            exit(EXIT_FAILURE);
+        }
+
+        ret = rank_f(&member, arg);
+        ucg_test_member_cleanup(&member);
+        exit(ret);
+    }
+
+    for (rank = 0; rank < procs; rank++) {
+        if ((wait(&wstatus) < 0) || !WIFEXITED(wstatus) || (WEXITSTATUS(wstatus) != EXIT_SUCCESS)) {
+            ret = EXIT_FAILURE;
+        }
+    }
+
+    munmap(shm, sizeof(*shm));
+    return ret;
+}
+
+ucs_status_t ucg_test_worker_create(ucg_test_member_t *member, unsigned slot,
+                                    ucs_thread_mode_t thread_mode, ucg_worker_h *worker_p)
+{
+    if ((slot == 0) || (slot >= UCG_TEST_MAX_WORKERS)) {
+        return UCS_ERR_INVALID_PARAM;
+    }
+    return ucg_test_worker_init(member, slot, thread_mode, worker_p);
+}
+
+ucs_status_t ucg_test_group_create(ucg_test_member_t *member, uint32_t cid, ucg_group_h *group_p)
+{
+    return ucg_test_group_create_on(member, member->worker, 0, cid, group_p);
+}
+
+ucs_status_t ucg_test_group_create_on(ucg_test_member_t *member, ucg_worker_h worker, unsigned slot,
+                                      uint32_t cid, ucg_group_h *group_p)
+{
+    ucg_group_params_t group_params;
+
+    memset(&group_params, 0, sizeof(group_params));
+    group_params.member_count                      = member->procs;
+    group_params.member_index                      = member->rank;
+    group_params.cid                               = cid;
+    group_params.node_index                        = member->node_index;
+    group_params.topo_args.ppn_local               = member->procs;
+    group_params.topo_args.pps_local               = member->procs;
+    group_params.topo_args.ppn_max                 = member->procs;
+    group_params.topo_args.node_nums               = 1;
+    group_params.topo_args.rank_continuous_in_node = 1;
+    group_params.topo_args.rank_continuous_in_sock = 1;
+    group_params.topo_args.rank_balance_in_node    = 1;
+    group_params.topo_args.rank_balance_in_sock    = 1;
+    group_params.mpi_reduce_f                      = ucg_test_reduce;
+    group_params.resolve_address_f                 = ucg_test_resolve;
+    group_params.release_address_f                 = ucg_test_release;
+    group_params.cb_group_obj                      = &member->shm->slots[slot];
+    group_params.op_is_commute_f                   = ucg_test_is_commute;
+    group_params.mpi_dt_convert                    = ucg_test_dt_convert;
+    group_params.mpi_dt_is_predefine               = ucg_test_dt_is_predefine;
+    group_params.mpi_global_idx_f                  = ucg_test_global_idx;
+    group_params.mpi_rank_distance                 = ucg_test_distance;
+    group_params.mpi_datatype_span                 = ucg_test_dt_span;
+    group_params.get_operate_param_f               = ucg_test_operate_param;
+    return ucg_group_create(worker, &group_params, group_p);
+}
+
+ucs_status_t ucg_test_allreduce_create(ucg_group_h group, const double *sbuf, double *rbuf, int count,
+                                       ucg_coll_h *coll_p)
+{
+    return ucg_coll_allreduce_init(sbuf, rbuf, count, sizeof(double), &ucg_test_dt, group,
+                                   NULL, &ucg_test_op, 0, 0, coll_p);
+}
+
+ucs_status_t ucg_test_coll_run(ucg_group_h group, ucg_coll_h coll)
+{
+    ucs_status_ptr_t req = ucg_collective_start_nb(coll);
+
+    if (UCS_PTR_IS_ERR(req)) {
+        return UCS_PTR_STATUS(req);
+    }
+    if (req == NULL) {
+        return UCS_OK;
+    }
+    return ucg_request_wait(group, req);
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Huawei Technologies Co., Ltd. 2021-2021.  All rights reserved.
+ * Description: Host-local groups for the tests and benchmarks: the members are
+ *              forked processes, which exchange worker addresses through shared
+ *              memory and reduce doubles with MPI-like callbacks
+ */
+
+#ifndef UCG_TEST_GROUP_H_
+#define UCG_TEST_GROUP_H_
+
+#include <ucg/api/ucg_mpi.h>
+
+#define UCG_TEST_MAX_PROCS   64
+#define UCG_TEST_MAX_WORKERS 16 /* of each member, the first one is created by the fork */
+#define UCG_TEST_ADDR_MAX    4096
+
+/* The addresses of the workers with the same slot number on all the members */
+typedef struct ucg_test_slot {
+    volatile uint32_t arrived;
+    size_t            addr_len[UCG_TEST_MAX_PROCS];
+    char              addr[UCG_TEST_MAX_PROCS][UCG_TEST_ADDR_MAX];
+} ucg_test_slot_t;
+
+typedef struct ucg_test_shm {
+    ucg_test_slot_t slots[UCG_TEST_MAX_WORKERS];
+} ucg_test_shm_t;
+
+typedef struct ucg_test_member {
+    ucg_test_shm_t *shm;
+    unsigned        rank;
+    unsigned        procs;
+    ucp_context_h   context;
+    ucg_worker_h    worker;
+    uint16_t       *node_index;
+} ucg_test_member_t;
+
+typedef int (*ucg_test_rank_f)(ucg_test_member_t *member, void *arg);
+
+/* Runs rank_f in each of the forked members, returns EXIT_SUCCESS if all of them did */
+int ucg_test_fork(unsigned procs, ucs_thread_mode_t thread_mode, ucg_test_rank_f rank_f, void *arg);
+
+/*
+ * Creates another worker of the member in the given slot (1..UCG_TEST_MAX_WORKERS-1),
+ * returns once all the members have created theirs in that slot
+ */
+ucs_status_t ucg_test_worker_create(ucg_test_member_t *member, unsigned slot,
+                                    ucs_thread_mode_t thread_mode, ucg_worker_h *worker_p);
+
+ucs_status_t ucg_test_group_create(ucg_test_member_t *member, uint32_t cid, ucg_group_h *group_p);
+
+/* Creates the group over the workers of the slot, the local one being worker */
+ucs_status_t ucg_test_group_create_on(ucg_test_member_t *member, ucg_worker_h worker, unsigned slot,
+                                      uint32_t cid, ucg_group_h *group_p);
+
+ucs_status_t ucg_test_allreduce_create(ucg_group_h group, const double *sbuf, double *rbuf, int count,
+                                       ucg_coll_h *coll_p);
+
+/* Starts the collective and waits for it */
+ucs_status_t ucg_test_coll_run(ucg_group_h group, ucg_coll_h coll);
+
+#endif